@@ -1,4 +1,5 @@
 import argparse
+import collections
 import glob
 import json
 import os
@@ -32,30 +33,80 @@ if typing.TYPE_CHECKING:
 parser = argparse.ArgumentParser()
 parser.add_argument("-r", "--runs", default=3, type=int)
 parser.add_argument("-d", "--data", required=True)
-parser.add_argument("-o", "--output", required=True)
+parser.add_argument("-o", "--output")
+parser.add_argument(
+    "-c",
+    "--calibrate",
+    nargs="?",
+    const=_trimal._calibration_path(),
+    help="write the calibration table of the `auto` backend",
+)
 args = parser.parse_args()
+if args.output is None and args.calibrate is None:
+    parser.error("one of the arguments -o/--output -c/--calibrate is required")
 
 
-BACKENDS = ["generic", None]
+BACKENDS = ["generic", "bitsliced", None]
 if _trimal._SSE2_RUNTIME_SUPPORT:
     BACKENDS.append("sse")
 if _trimal._AVX2_RUNTIME_SUPPORT:
     BACKENDS.append("avx")
+if _trimal._AVX512_RUNTIME_SUPPORT:
+    BACKENDS.append("avx512")
 if _trimal._MMX_RUNTIME_SUPPORT:
     BACKENDS.append("mmx")
 if _trimal._NEON_RUNTIME_SUPPORT:
     BACKENDS.append("neon")
 
-STATISTIC: Dict[str, Callable[["TRIMMER_BACKEND"], BaseTrimmer]] = {
-    "Gaps": lambda backend: ManualTrimmer(gap_threshold=0.5, backend=backend),
-    "Similarity": lambda backend: ManualTrimmer(
-        similarity_threshold=0.5, backend=backend
+# only compare threads when calibrating, where `0` uses all the CPUs
+THREADS = [1]
+if args.calibrate is not None and (os.cpu_count() or 1) > 1:
+    THREADS.append(0)
+
+STATISTIC: Dict[str, Callable[["TRIMMER_BACKEND", int], BaseTrimmer]] = {
+    "Gaps": lambda backend, threads: ManualTrimmer(
+        gap_threshold=0.5, backend=backend, threads=threads
     ),
-    "Overlap": lambda backend: OverlapTrimmer(
-        sequence_overlap=60, residue_overlap=0.5, backend=backend
+    "Similarity": lambda backend, threads: ManualTrimmer(
+        similarity_threshold=0.5, backend=backend, threads=threads
+    ),
+    "Overlap": lambda backend, threads: OverlapTrimmer(
+        sequence_overlap=60, residue_overlap=0.5, backend=backend, threads=threads
     ),
 }
 
+
+def calibrate(results: List[Dict[str, object]]) -> List[Dict[str, object]]:
+    # sum the median times of all statistics for each configuration
+    totals: Dict[tuple, float] = collections.defaultdict(float)
+    for result in results:
+        if result["backend"] is not None:
+            key = (result["sequences"], result["backend"], result["threads"])
+            totals[key] += result["median"]
+    # select the fastest configuration for each number of sequences, and
+    # merge the consecutive subsets with the same configuration
+    rules: List[Dict[str, object]] = []
+    for sequences in sorted({key[0] for key in totals}):
+        backend, threads = min(
+            (key[1:] for key in totals if key[0] == sequences),
+            key=lambda config: totals[(sequences, *config)],
+        )
+        if rules and rules[-1]["backend"] == backend and rules[-1]["threads"] == threads:
+            rules[-1]["sequences"] = sequences
+        else:
+            rules.append(
+                {
+                    "sequences": sequences,
+                    "residues": None,
+                    "backend": backend,
+                    "threads": threads,
+                }
+            )
+    # the last configuration covers the alignments larger than the example
+    rules[-1]["sequences"] = None
+    return rules
+
+
 with rich.progress.Progress(transient=True) as progress:
     rich.print("[bold green]Benchmarking[/] backends: [cyan italic]{}[/]".format(" ".join(map(str, BACKENDS))))
 
@@ -72,10 +123,11 @@ with rich.progress.Progress(transient=True) as progress:
     task0 = progress.add_task(total=len(STATISTIC), description="Statistic (...)")
     for statistic, get_trimmer in progress.track(STATISTIC.items(), task_id=task0):
         progress.update(task_id=task0, description=f"Statistic ({statistic})")
-        task1 = progress.add_task(total=len(BACKENDS), description=" Backend (...)")
-        for backend in progress.track(BACKENDS, task_id=task1):
-            progress.update(task_id=task1, description=f" Backend ({backend})")
-            trimmer = get_trimmer(backend)
+        configs = [(b, t) for b in BACKENDS for t in THREADS if b is not None or t == 1]
+        task1 = progress.add_task(total=len(configs), description=" Backend (...)")
+        for backend, threads in progress.track(configs, task_id=task1):
+            progress.update(task_id=task1, description=f" Backend ({backend}, threads={threads})")
+            trimmer = get_trimmer(backend, threads)
             task2 = progress.add_task(
                 total=len(subsets), description=f"  Subset (0/{len(example.sequences)})"
             )
@@ -112,6 +164,7 @@ with rich.progress.Progress(transient=True) as progress:
                         "min": min(times),
                         "max": max(times),
                         "statistic": statistic,
+                        "threads": threads,
                         "trimmer": repr(trimmer),
                     }
                 )
@@ -119,5 +172,13 @@ with rich.progress.Progress(transient=True) as progress:
         progress.remove_task(task_id=task1)
     progress.remove_task(task_id=task0)
 
-with open(args.output, "w") as f:
-    json.dump(results, f, sort_keys=True, indent=4)
+if args.output is not None:
+    with open(args.output, "w") as f:
+        json.dump(results, f, sort_keys=True, indent=4)
+
+if args.calibrate is not None:
+    calibration = {"cpu": _trimal._HOST_CPU.name, "rules": calibrate(results["results"])}
+    os.makedirs(os.path.dirname(os.path.abspath(args.calibrate)), exist_ok=True)
+    with open(args.calibrate, "w") as f:
+        json.dump(calibration, f, sort_keys=True, indent=4)
+    rich.print(f"[bold green]Calibrated[/] auto backend: [cyan italic]{args.calibrate}[/]")
@@ -0,0 +1,490 @@
+// Microbenchmarks of the statistics kernels of every backend.
+//
+// The kernels are called directly on synthetic alignments, so that the
+// timings exclude the Python overhead and the copies of the alignments
+// made when trimming. Each run uses a new alignment and a new context, so
+// that no statistic is reused from the cache of a previous run, and only
+// the kernel itself is timed.
+//
+// The results are written as JSON in the same format as `bench.py`, with
+// the kernel name as the statistic, so that they can be plotted with
+// `plot.py`. Build with `python setup.py build_bench`.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Alignment/Alignment.h"
+#include "Cleaner.h"
+#include "Statistics/Gaps.h"
+#include "Statistics/Similarity.h"
+#include "Statistics/similarityMatrix.h"
+
+#include "bitsliced.h"
+#include "context.h"
+#include "generic.h"
+#ifdef MMX_BUILD_SUPPORT
+#include "mmx.h"
+#endif
+#ifdef SSE2_BUILD_SUPPORT
+#include "sse.h"
+#endif
+#ifdef AVX2_BUILD_SUPPORT
+#include "avx.h"
+#endif
+#ifdef AVX512_BUILD_SUPPORT
+#include "avx512.h"
+#endif
+#ifdef NEON_BUILD_SUPPORT
+#include "neon.h"
+#endif
+
+// --- Backends ----------------------------------------------------------------
+
+// The statistics of a backend, created for an alignment and a context.
+struct Backend {
+  // the name of the backend, as given to `BaseTrimmer`, or `nullptr` for
+  // the original trimAl code
+  const char *name;
+  std::function<statistics::Similarity *(Alignment *, const simd::Context &)>
+      similarity;
+  std::function<statistics::Gaps *(Alignment *, const simd::Context &)> gaps;
+  std::function<Cleaner *(Alignment *, const simd::Context &)> cleaner;
+};
+
+template <class S, class G, class C> Backend makeBackend(const char *name) {
+  Backend backend;
+  backend.name = name;
+  backend.similarity = [](Alignment *alig, const simd::Context &context) {
+    return static_cast<statistics::Similarity *>(new S(alig, context));
+  };
+  backend.gaps = [](Alignment *alig, const simd::Context &context) {
+    return static_cast<statistics::Gaps *>(new G(alig, context));
+  };
+  backend.cleaner = [](Alignment *alig, const simd::Context &context) {
+    return static_cast<Cleaner *>(new C(alig, context));
+  };
+  return backend;
+}
+
+static Backend trimalBackend() {
+  Backend backend;
+  backend.name = nullptr;
+  backend.similarity = [](Alignment *alig, const simd::Context &) {
+    return new statistics::Similarity(alig);
+  };
+  backend.gaps = [](Alignment *alig, const simd::Context &) {
+    return new statistics::Gaps(alig);
+  };
+  backend.cleaner = [](Alignment *alig, const simd::Context &) {
+    return new Cleaner(alig);
+  };
+  return backend;
+}
+
+// Whether the instructions used by a backend are supported by the CPU.
+static bool runtimeSupport(const std::string &name) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (name == "mmx")
+    return __builtin_cpu_supports("mmx");
+  if (name == "sse")
+    return __builtin_cpu_supports("sse2");
+  if (name == "avx")
+    return __builtin_cpu_supports("avx2");
+  if (name == "avx512")
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw");
+#endif
+  return true;
+}
+
+// Get the backends compiled in the benchmark and supported by the CPU.
+static std::vector<Backend> availableBackends() {
+  std::vector<Backend> backends;
+  backends.push_back(trimalBackend());
+  backends.push_back(
+      makeBackend<statistics::GenericSimilarity, statistics::GenericGaps,
+                  GenericCleaner>("generic"));
+  backends.push_back(
+      makeBackend<statistics::BitslicedSimilarity, statistics::BitslicedGaps,
+                  BitslicedCleaner>("bitsliced"));
+#ifdef MMX_BUILD_SUPPORT
+  if (runtimeSupport("mmx"))
+    backends.push_back(
+        makeBackend<statistics::MMXSimilarity, statistics::MMXGaps,
+                    MMXCleaner>("mmx"));
+#endif
+#ifdef SSE2_BUILD_SUPPORT
+  if (runtimeSupport("sse"))
+    backends.push_back(
+        makeBackend<statistics::SSESimilarity, statistics::SSEGaps,
+                    SSECleaner>("sse"));
+#endif
+#ifdef AVX2_BUILD_SUPPORT
+  if (runtimeSupport("avx"))
+    backends.push_back(
+        makeBackend<statistics::AVXSimilarity, statistics::AVXGaps,
+                    AVXCleaner>("avx"));
+#endif
+#ifdef AVX512_BUILD_SUPPORT
+  if (runtimeSupport("avx512"))
+    backends.push_back(
+        makeBackend<statistics::AVX512Similarity, statistics::AVX512Gaps,
+                    AVX512Cleaner>("avx512"));
+#endif
+#ifdef NEON_BUILD_SUPPORT
+  if (runtimeSupport("neon"))
+    backends.push_back(
+        makeBackend<statistics::NEONSimilarity, statistics::NEONGaps,
+                    NEONCleaner>("neon"));
+#endif
+  return backends;
+}
+
+// --- Synthetic alignments ----------------------------------------------------
+
+// A xorshift generator, so that the alignments are the same on all
+// platforms for a given seed.
+class Random {
+public:
+  explicit Random(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+  inline uint64_t next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  // Get a number uniformly distributed in `[0, n)`.
+  inline int below(int n) { return (int)(next() % (uint64_t)n); }
+
+private:
+  uint64_t state;
+};
+
+const char AMINO_ACIDS[] = "ACDEFGHIKLMNPQRSTVWY";
+
+// Build a protein alignment of `sequences` sequences of `residues`
+// columns, mutating a random ancestor so that the sequences have about
+// 60% identity, and adding runs of gaps and a few indeterminations.
+static Alignment *syntheticAlignment(int sequences, int residues,
+                                     uint64_t seed) {
+  Random random(seed);
+  std::string ancestor(residues, 'A');
+  for (int k = 0; k < residues; k++)
+    ancestor[k] = AMINO_ACIDS[random.below(20)];
+
+  Alignment *alig = new Alignment();
+  alig->numberOfSequences = sequences;
+  alig->numberOfResidues = residues;
+  alig->seqsName = new std::string[sequences];
+  alig->sequences = new std::string[sequences];
+  for (int i = 0; i < sequences; i++) {
+    std::string &sequence = alig->sequences[i];
+    sequence = ancestor;
+    for (int k = 0; k < residues; k++) {
+      const int draw = random.below(100);
+      if (draw < 40)
+        sequence[k] = AMINO_ACIDS[random.below(20)];
+      else if (draw == 40)
+        sequence[k] = 'X';
+    }
+    // gap a few random stretches of the sequence
+    for (int g = random.below(4); g > 0; g--) {
+      const int length = 1 + random.below(std::max(1, residues / 20));
+      const int start = random.below(residues);
+      std::fill(sequence.begin() + start,
+                sequence.begin() + std::min(start + length, residues), '-');
+    }
+    alig->seqsName[i] = "seq" + std::to_string(i);
+  }
+
+  alig->fillMatrices(sequences > 1, false);
+  alig->originalNumberOfSequences = sequences;
+  alig->originalNumberOfResidues = residues;
+  return alig;
+}
+
+// --- Kernels -----------------------------------------------------------------
+
+// The statistics created for a run of a kernel, before the timer starts.
+struct State {
+  std::unique_ptr<statistics::Similarity> similarity;
+  std::unique_ptr<statistics::Gaps> gaps;
+  std::unique_ptr<Cleaner> cleaner;
+  std::vector<float> spurious;
+};
+
+// A kernel to benchmark: `prepare` creates the statistics and computes
+// what the kernel depends on without being timed, and `run` is timed.
+struct Kernel {
+  const char *name;
+  // whether the kernel compares all pairs of sequences
+  bool pairwise;
+  std::function<void(State &, const Backend &, Alignment *,
+                     const simd::Context &)>
+      prepare;
+  std::function<void(State &)> run;
+};
+
+static std::vector<Kernel> availableKernels(statistics::similarityMatrix *sm) {
+  std::vector<Kernel> kernels;
+  kernels.push_back(Kernel{
+      "MatrixIdentity", true,
+      [](State &state, const Backend &b, Alignment *alig,
+         const simd::Context &context) {
+        state.similarity.reset(b.similarity(alig, context));
+      },
+      [](State &state) { state.similarity->calculateMatrixIdentity(); }});
+  kernels.push_back(Kernel{
+      "SeqIdentity", true,
+      [](State &state, const Backend &b, Alignment *alig,
+         const simd::Context &context) {
+        state.cleaner.reset(b.cleaner(alig, context));
+      },
+      [](State &state) { state.cleaner->calculateSeqIdentity(); }});
+  kernels.push_back(Kernel{
+      "SpuriousVector", true,
+      [](State &state, const Backend &b, Alignment *alig,
+         const simd::Context &context) {
+        state.cleaner.reset(b.cleaner(alig, context));
+        state.spurious.resize(alig->originalNumberOfSequences);
+      },
+      [](State &state) {
+        state.cleaner->calculateSpuriousVector(0.5F, state.spurious.data());
+      }});
+  kernels.push_back(Kernel{
+      "GapVectors", false,
+      [](State &state, const Backend &b, Alignment *alig,
+         const simd::Context &context) {
+        state.gaps.reset(b.gaps(alig, context));
+      },
+      [](State &state) { state.gaps->CalculateVectors(); }});
+  // the identity matrix is computed beforehand, since it is benchmarked
+  // on its own by `MatrixIdentity`
+  kernels.push_back(Kernel{
+      "SimilarityVectors", true,
+      [sm](State &state, const Backend &b, Alignment *alig,
+           const simd::Context &context) {
+        state.similarity.reset(b.similarity(alig, context));
+        state.similarity->setSimilarityMatrix(sm);
+        state.similarity->calculateMatrixIdentity();
+      },
+      [](State &state) { state.similarity->calculateVectors(false); }});
+  return kernels;
+}
+
+// --- Command line ------------------------------------------------------------
+
+struct Options {
+  int runs = 3;
+  int threads = 1;
+  std::vector<int> sequences = {16, 64, 256, 1024};
+  std::vector<int> residues = {256, 1024, 4096};
+  std::vector<std::string> backends;
+  std::vector<std::string> kernels;
+  std::string output;
+};
+
+static std::vector<std::string> splitList(const std::string &value) {
+  std::vector<std::string> items;
+  std::stringstream stream(value);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+static std::vector<int> splitIntegers(const std::string &value) {
+  std::vector<int> numbers;
+  for (const std::string &item : splitList(value))
+    numbers.push_back(std::atoi(item.c_str()));
+  return numbers;
+}
+
+static void usage(const char *program) {
+  std::cerr
+      << "usage: " << program << " [options]\n"
+      << "  -r, --runs N          number of runs of each benchmark, at least "
+         "2 (3)\n"
+      << "  -t, --threads N       threads used by the kernels (1)\n"
+      << "  -s, --sequences LIST  comma-separated numbers of sequences\n"
+      << "  -l, --residues LIST   comma-separated numbers of residues\n"
+      << "  -b, --backends LIST   comma-separated backends, 'none' for "
+         "trimAl\n"
+      << "  -k, --kernels LIST    comma-separated kernels\n"
+      << "  -o, --output FILE     write the JSON results to FILE\n";
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "-h") || (arg == "--help") || (i + 1 >= argc))
+      return false;
+    const std::string value = argv[++i];
+    if ((arg == "-r") || (arg == "--runs"))
+      options.runs = std::atoi(value.c_str());
+    else if ((arg == "-t") || (arg == "--threads"))
+      options.threads = std::atoi(value.c_str());
+    else if ((arg == "-s") || (arg == "--sequences"))
+      options.sequences = splitIntegers(value);
+    else if ((arg == "-l") || (arg == "--residues"))
+      options.residues = splitIntegers(value);
+    else if ((arg == "-b") || (arg == "--backends"))
+      options.backends = splitList(value);
+    else if ((arg == "-k") || (arg == "--kernels"))
+      options.kernels = splitList(value);
+    else if ((arg == "-o") || (arg == "--output"))
+      options.output = value;
+    else
+      return false;
+  }
+  return (options.runs > 1) && (options.threads > 0);
+}
+
+static bool selected(const std::vector<std::string> &names,
+                     const std::string &name) {
+  return names.empty() ||
+         (std::find(names.begin(), names.end(), name) != names.end());
+}
+
+// --- Results -----------------------------------------------------------------
+
+struct Result {
+  const char *backend;
+  const char *kernel;
+  int sequences;
+  int residues;
+  int threads;
+  bool pairwise;
+  std::vector<double> times;
+};
+
+static void writeResult(std::ostream &out, const Result &result) {
+  std::vector<double> sorted = result.times;
+  std::sort(sorted.begin(), sorted.end());
+  const size_t n = sorted.size();
+  double mean = 0;
+  for (double t : sorted)
+    mean += t;
+  mean /= n;
+  double variance = 0;
+  for (double t : sorted)
+    variance += (t - mean) * (t - mean);
+  const double stddev = std::sqrt(variance / (n - 1));
+  const double median =
+      (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+  // every kernel reads each residue of the alignment at least once
+  const double bytes = (double)result.sequences * result.residues;
+  const double pairs =
+      result.pairwise
+          ? (double)result.sequences * (result.sequences - 1) / 2
+          : 0.0;
+
+  out << "        {\n";
+  out << "            \"backend\": ";
+  if (result.backend == nullptr)
+    out << "null,\n";
+  else
+    out << "\"" << result.backend << "\",\n";
+  out << "            \"gigabytes_per_second\": " << bytes / mean / 1e9
+      << ",\n";
+  out << "            \"max\": " << sorted.back() << ",\n";
+  out << "            \"mean\": " << mean << ",\n";
+  out << "            \"median\": " << median << ",\n";
+  out << "            \"min\": " << sorted.front() << ",\n";
+  out << "            \"pairs_per_second\": " << pairs / mean << ",\n";
+  out << "            \"residues\": " << result.residues << ",\n";
+  out << "            \"sequences\": " << result.sequences << ",\n";
+  out << "            \"statistic\": \"" << result.kernel << "\",\n";
+  out << "            \"stddev\": " << stddev << ",\n";
+  out << "            \"threads\": " << result.threads << ",\n";
+  out << "            \"times\": [\n";
+  for (size_t i = 0; i < result.times.size(); i++)
+    out << "                " << result.times[i]
+        << (i + 1 < result.times.size() ? ",\n" : "\n");
+  out << "            ]\n";
+  out << "        }";
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  statistics::similarityMatrix matrix;
+  matrix.defaultAASimMatrix();
+
+  std::vector<Result> results;
+  for (const Kernel &kernel : availableKernels(&matrix)) {
+    if (!selected(options.kernels, kernel.name))
+      continue;
+    for (const Backend &backend : availableBackends()) {
+      if (!selected(options.backends, backend.name ? backend.name : "none"))
+        continue;
+      for (int sequences : options.sequences) {
+        for (int residues : options.residues) {
+          Result result{backend.name, kernel.name,   sequences, residues,
+                        options.threads, kernel.pairwise, {}};
+          for (int run = 0; run < options.runs; run++) {
+            std::unique_ptr<Alignment> alig(
+                syntheticAlignment(sequences, residues, run + 1));
+            simd::Context context;
+            context.threads = options.threads;
+            State state;
+            kernel.prepare(state, backend, alig.get(), context);
+
+            auto start = std::chrono::steady_clock::now();
+            kernel.run(state);
+            auto stop = std::chrono::steady_clock::now();
+            result.times.push_back(
+                std::chrono::duration<double>(stop - start).count());
+            context.arena->release();
+          }
+          results.push_back(result);
+
+          const double best =
+              *std::min_element(result.times.begin(), result.times.end());
+          fprintf(stderr, "%-18s %-10s %6d x %-6d %10.3f ms %8.3f GB/s",
+                  kernel.name, backend.name ? backend.name : "none",
+                  sequences, residues, best * 1e3,
+                  (double)sequences * residues / best / 1e9);
+          if (kernel.pairwise)
+            fprintf(stderr, " %12.4g pairs/s",
+                    (double)sequences * (sequences - 1) / 2 / best);
+          fprintf(stderr, "\n");
+        }
+      }
+    }
+  }
+
+  std::ofstream file;
+  if (!options.output.empty())
+    file.open(options.output);
+  std::ostream &out = options.output.empty() ? std::cout : file;
+  out.precision(17);
+  out << "{\n    \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    writeResult(out, results[i]);
+    out << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "    ]\n}\n";
+  return 0;
+}
@@ -13,19 +13,31 @@ from palettable.cartocolors.qualitative import Bold_9
 
 
 COLORS = dict(zip(
-    ["None", "Generic", "MMX", "SSE", "AVX", "NEON"], 
+    ["None", "Generic", "MMX", "SSE", "AVX", "NEON", "AVX512", "BITSLICED"],
     Bold_9.hex_colors
 ))
+# statistics whose time grows linearly with the number of sequences
+LINEAR = {"Gaps", "GapVectors"}
 ORDER = {x:i for i,x in enumerate(COLORS)}
 
 parser = argparse.ArgumentParser()
 parser.add_argument("-i", "--input", required=True)
 parser.add_argument("-o", "--output")
 parser.add_argument("-s", "--show", action="store_true")
+parser.add_argument("-r", "--residues", type=int)
 args = parser.parse_args()
 
 with open(args.input) as f:
     data = json.load(f)
+
+# only plot one alignment length, the longest one unless given, since the
+# native benchmark results are computed over a grid of alignment shapes
+residues = args.residues or max(r["residues"] for r in data["results"])
+data["results"] = [r for r in data["results"] if r["residues"] == residues]
+# only plot the fewest threads, since a calibration run also measures
+# every backend with all the CPUs of the machine
+threads = min(r.get("threads", 1) for r in data["results"])
+data["results"] = [r for r in data["results"] if r.get("threads", 1) == threads]
 for result in data["results"]:
     if result["backend"] is None:
         result["backend"] = "None"
@@ -34,13 +46,14 @@ for result in data["results"]:
     else:
         result["backend"] = result["backend"].upper()
 
-plt.figure(1, figsize=(18, 6))
-
 data["results"].sort(key=lambda r: r["statistic"])
+statistics = sorted({r["statistic"] for r in data["results"]})
+plt.figure(1, figsize=(6 * len(statistics), 6))
+
 for i, (statistic, statistic_group) in enumerate(
     itertools.groupby(data["results"], key=lambda r: r["statistic"])
 ):
-    plt.subplot(1, 3, i + 1)
+    plt.subplot(1, len(statistics), i + 1)
     plt.title(statistic)
 
     statistic_group = sorted(
@@ -51,7 +64,7 @@ for i, (statistic, statistic_group) in enumerate(
         X = numpy.array([r["sequences"] for r in group])
         Y = numpy.array([r["mean"] for r in group])
 
-        if statistic == "Gaps":
+        if statistic in LINEAR:
             reg = scipy.stats.linregress(X, Y)
             plt.scatter(
                 X,
@@ -12,6 +12,7 @@ cdef extern from "<istream>" namespace "std" nogil:
     cdef cppclass istream:
         istream(streambuf* sb)
         istream& seekg(streampos pos)
+        void clear()
 
 cdef extern from "<streambuf>" namespace "std" nogil:
     cdef cppclass streambuf:
@@ -19,6 +20,7 @@ cdef extern from "<streambuf>" namespace "std" nogil:
         char* egptr()
         streambuf* pubsetbuf(char* s, streamsize n);
         streambuf* setbuf(char* s, streamsize n);
+        streamsize sputn(const char* s, streamsize n)
         void setg(char* gbeg, char* gnext, char* gend);
 
 cdef extern from "<fstream>" namespace "std" nogil:
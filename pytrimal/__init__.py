@@ -13,6 +13,8 @@ from ._trimal import (
     RepresentativeTrimmer,
     SimilarityMatrix,
     TrimmedAlignment,
+    TrimProfile,
+    TrimStage,
 )
 
 __doc__ = _trimal.__doc__
@@ -26,6 +28,8 @@ __all__ = [
     "ManualTrimmer",
     "OverlapTrimmer",
     "SimilarityMatrix",
+    "TrimProfile",
+    "TrimStage",
 ]
 
 __author__ = "Martin Larralde <martin.larralde@embl.de>"
@@ -4,12 +4,19 @@
 # --- C imports --------------------------------------------------------------
 
 from libcpp cimport bool
+from libcpp.memory cimport shared_ptr
+from libcpp.string cimport string
 
 cimport trimal
 cimport trimal.alignment
 cimport trimal.manager
 cimport trimal.similarity_matrix
 
+from pytrimal.impl.batch cimport TrimBatch, TrimTask
+from pytrimal.impl.context cimport AlignmentCache, Context
+from pytrimal.impl.lease cimport SequenceLease
+from pytrimal.impl.profile cimport Profile
+
 
 # --- Alignment classes ------------------------------------------------------
 
@@ -39,10 +46,18 @@ cdef class Alignment:
     cdef trimal.alignment.Alignment* _ali
     cdef int*                        _sequences_mapping
     cdef int*                        _residues_mapping
-
+    cdef shared_ptr[AlignmentCache]  _cache
+    cdef shared_ptr[SequenceLease]   _lease
+    cdef Py_ssize_t                  _shape[2]
+    cdef Py_ssize_t                  _strides[2]
+    cdef Py_ssize_t                  _exports
+
+    cdef int _load_text(self, const string& text, str format) except 1
+    cdef int _finish_parsing(self) except 1
     cpdef Alignment copy(self)
+    cpdef void clear_cache(self) except *
     cpdef str dumps(self, str format=*, str encoding=*)
-    cpdef void dump(self, object file, str format=*) except *
+    cpdef void dump(self, object file, str format=*, str compression=*) except *
 
 
 cdef class TrimmedAlignment(Alignment):
@@ -56,9 +71,15 @@ cdef class TrimmedAlignment(Alignment):
 
 cdef class BaseTrimmer:
     cdef int _backend
+    cdef int _threads
+    cdef int _identity_format
+    cdef int _similarity_sample
+    cdef shared_ptr[Profile] _profile
 
-    cdef void _setup_simd_code(self, trimal.manager.trimAlManager* manager) nogil
     cdef void _configure_manager(self, trimal.manager.trimAlManager* manager)
+    cdef void _prepare_task(self, TrimTask* task, Alignment alignment, SimilarityMatrix matrix) except *
+    cdef TrimmedAlignment _finish_task(self, TrimTask* task)
+    cdef TrimmedAlignment _next_task(self, TrimBatch* batch, size_t i)
     cpdef TrimmedAlignment trim(self, Alignment alignment, SimilarityMatrix matrix = ?)
 
 
@@ -66,6 +87,7 @@ cdef class AutomaticTrimmer(BaseTrimmer):
     cdef readonly str method
 
     cdef void _configure_manager(self, trimal.manager.trimAlManager* manager)
+    cdef void _configure_method(self, trimal.manager.trimAlManager* manager, str method)
 
 
 cdef class ManualTrimmer(BaseTrimmer):
@@ -87,13 +109,30 @@ cdef class OverlapTrimmer(BaseTrimmer):
     cdef float _residue_overlap
 
     cdef void _configure_manager(self, trimal.manager.trimAlManager* manager)
+    cdef void _prepare_task(self, TrimTask* task, Alignment alignment, SimilarityMatrix matrix) except *
 
 
 cdef class RepresentativeTrimmer(BaseTrimmer):
     cdef int    _clusters
     cdef float  _identity_threshold
+    cdef bint   _greedy
 
     cdef void _configure_manager(self, trimal.manager.trimAlManager* manager)
+    cdef void _prepare_task(self, TrimTask* task, Alignment alignment, SimilarityMatrix matrix) except *
+
+
+# -- Profiling classes -------------------------------------------------------
+
+cdef class TrimProfile:
+    cdef shared_ptr[Profile] _profile
+    cdef BaseTrimmer         _trimmer
+
+
+cdef class TrimStage:
+    cdef readonly str    name
+    cdef readonly double time
+    cdef readonly size_t calls
+    cdef readonly size_t bytes
 
 
 # -- Misc classes ------------------------------------------------------------
@@ -1,8 +1,9 @@
 # --- Python imports ---------------------------------------------------------
 
 import os
+import types
 import typing
-from typing import BinaryIO, Dict, Sequence, List, Optional, Iterable, Union, Sequence, FrozenSet
+from typing import BinaryIO, Dict, Sequence, List, Optional, Iterable, Iterator, Union, Sequence, FrozenSet
 
 try:
     from typing import Literal
@@ -15,7 +16,7 @@ from pyhmmer.easel import TextMSA
 
 # --- Constants --------------------------------------------------------------
 
-TRIMMER_BACKEND = Literal["detect", "sse", "generic", None]
+TRIMMER_BACKEND = Literal["auto", "detect", "sse", "avx", "avx512", "mmx", "neon", "generic", "bitsliced", None]
 AUTOMATIC_TRIMMER_METHODS = Literal[
     "strict",
     "strictplus",
@@ -49,6 +50,10 @@ FORMATS_DUMP = Literal[
     "phylip40_m10",
 ]
 
+COMPRESSION = Literal["gzip", "gz", "zstd", "zst"]
+IDENTITY_FORMAT = Literal["float32", "float16", "uint16"]
+CLUSTERING = Literal["exact", "greedy"]
+
 # --- Alignment classes ------------------------------------------------------
 
 class AlignmentSequences(Sequence[str]):
@@ -74,20 +79,35 @@ class Alignment:
     @classmethod
     def from_pyhmmer(cls, alignment: TextMSA) -> TrimmedAlignment: ...
     def to_pyhmmer(self) -> TextMSA: ...
+    @classmethod
+    def from_buffer(cls, names: Sequence[bytes], buffer: typing.Any) -> Alignment: ...
     @typing.overload
     @classmethod
     def load(
         cls,
         file: Union[str, bytes, os.PathLike[str]],
         format: Optional[FORMATS_LOAD] = None,
+        compression: Optional[COMPRESSION] = None,
     ) -> Alignment: ...
     @typing.overload
     @classmethod
-    def load(cls, file: BinaryIO, format: FORMATS_LOAD) -> Alignment: ...
+    def load(
+        cls,
+        file: BinaryIO,
+        format: FORMATS_LOAD,
+        compression: Optional[COMPRESSION] = None,
+    ) -> Alignment: ...
+    @classmethod
+    def iter_load(
+        cls,
+        file: Union[str, bytes, os.PathLike[str], BinaryIO],
+        format: FORMATS_LOAD = "fasta",
+    ) -> Iterator[Alignment]: ...
     def dump(
         self,
         file: Union[str, bytes, os.PathLike[str], BinaryIO],
         format: FORMATS_DUMP = "fasta",
+        compression: Optional[COMPRESSION] = None,
     ) -> None: ...
     def dumps(self, format: str = "fasta", encoding: str = "utf-8") -> str: ...
     def __init__(self, names: Sequence[bytes], sequences: Sequence[str]) -> None: ...
@@ -100,22 +120,31 @@ class Alignment:
     @property
     def residues(self) -> AlignmentResidues: ...
     def copy(self) -> Alignment: ...
+    def clear_cache(self) -> None: ...
 
 class TrimmedAlignment(Alignment):
     @classmethod
     def from_biopython(cls, alignment: Iterable[SeqRecord]) -> TrimmedAlignment: ...
     @classmethod
     def from_pyhmmer(cls, alignment: TextMSA) -> TrimmedAlignment: ...
+    @classmethod
+    def from_buffer(cls, names: Sequence[bytes], buffer: typing.Any) -> TrimmedAlignment: ...
     @typing.overload
     @classmethod
     def load(
         cls,
         file: Union[str, bytes, os.PathLike[str]],
         format: Optional[FORMATS_LOAD] = None,
+        compression: Optional[COMPRESSION] = None,
     ) -> TrimmedAlignment: ...
     @typing.overload
     @classmethod
-    def load(cls, file: BinaryIO, format: FORMATS_LOAD) -> TrimmedAlignment: ...
+    def load(
+        cls,
+        file: BinaryIO,
+        format: FORMATS_LOAD,
+        compression: Optional[COMPRESSION] = None,
+    ) -> TrimmedAlignment: ...
     def __init__(
         self,
         names: Sequence[bytes],
@@ -127,22 +156,42 @@ class TrimmedAlignment(Alignment):
     def terminal_only(self) -> TrimmedAlignment: ...
     def copy(self) -> TrimmedAlignment: ...
     @property
-    def residues_mask(self) -> List[bool]: ...
+    def residues_mask(self) -> memoryview: ...
     @property
-    def sequences_mask(self) -> List[bool]: ...
+    def sequences_mask(self) -> memoryview: ...
 
 # -- Trimmer classes ---------------------------------------------------------
 
 class BaseTrimmer:
-    def __init__(self, *, backend: TRIMMER_BACKEND = "detect") -> None: ...
+    def __init__(
+        self,
+        *,
+        backend: TRIMMER_BACKEND = "detect",
+        threads: int = 1,
+        identity_format: IDENTITY_FORMAT = "float32",
+        similarity_sample: Optional[int] = None,
+    ) -> None: ...
     def __repr__(self) -> str: ...
     def __getstate__(self) -> Dict[str, object]: ...
     def __setstate__(self, state: Dict[str, object]) -> None: ...
     @property
     def backend(self) -> Optional[str]: ...
+    @property
+    def threads(self) -> int: ...
+    @property
+    def identity_format(self) -> IDENTITY_FORMAT: ...
+    @property
+    def similarity_sample(self) -> Optional[int]: ...
     def trim(
         self, alignment: Alignment, matrix: Optional[SimilarityMatrix] = None
     ) -> TrimmedAlignment: ...
+    def trim_many(
+        self,
+        alignments: Iterable[Alignment],
+        matrix: Optional[SimilarityMatrix] = None,
+        threads: int = 0,
+    ) -> Iterator[TrimmedAlignment]: ...
+    def profile(self) -> TrimProfile: ...
 
 class AutomaticTrimmer(BaseTrimmer):
     METHODS: typing.ClassVar[FrozenSet[AUTOMATIC_TRIMMER_METHODS]]
@@ -151,7 +200,16 @@ class AutomaticTrimmer(BaseTrimmer):
         method: AUTOMATIC_TRIMMER_METHODS = "strict",
         *,
         backend: TRIMMER_BACKEND = "detect",
+        threads: int = 1,
+        identity_format: IDENTITY_FORMAT = "float32",
+        similarity_sample: Optional[int] = None,
     ) -> None: ...
+    def trim_methods(
+        self,
+        alignment: Alignment,
+        methods: Iterable[AUTOMATIC_TRIMMER_METHODS],
+        matrix: Optional[SimilarityMatrix] = None,
+    ) -> List[TrimmedAlignment]: ...
 
 class ManualTrimmer(BaseTrimmer):
     def __init__(
@@ -165,6 +223,9 @@ class ManualTrimmer(BaseTrimmer):
         gap_window: Optional[int] = None,
         similarity_window: Optional[int] = None,
         backend: TRIMMER_BACKEND = "detect",
+        threads: int = 1,
+        identity_format: IDENTITY_FORMAT = "float32",
+        similarity_sample: Optional[int] = None,
     ) -> None: ...
 
 class OverlapTrimmer(BaseTrimmer):
@@ -174,6 +235,7 @@ class OverlapTrimmer(BaseTrimmer):
         residue_overlap: float,
         *,
         backend: TRIMMER_BACKEND = "detect",
+        threads: int = 1,
     ) -> None: ...
 
 class RepresentativeTrimmer(BaseTrimmer):
@@ -184,6 +246,8 @@ class RepresentativeTrimmer(BaseTrimmer):
         clusters: Literal[None] = None,
         identity_threshold: float,
         backend: TRIMMER_BACKEND = "detect",
+        threads: int = 1,
+        clustering: CLUSTERING = "exact",
     ) -> None: ...
     @typing.overload
     def __init__(
@@ -192,7 +256,40 @@ class RepresentativeTrimmer(BaseTrimmer):
         clusters: int,
         identity_threshold: Literal[None] = None,
         backend: TRIMMER_BACKEND = "detect",
+        threads: int = 1,
+        clustering: CLUSTERING = "exact",
     ) -> None: ...
+    @property
+    def clustering(self) -> CLUSTERING: ...
+
+# -- Profiling classes -------------------------------------------------------
+
+class TrimProfile:
+    STAGES: typing.ClassVar[typing.Tuple[str, ...]]
+    def __init__(self, trimmer: BaseTrimmer) -> None: ...
+    def __enter__(self) -> TrimProfile: ...
+    def __exit__(
+        self,
+        exc_type: Optional[typing.Type[BaseException]],
+        exc_value: Optional[BaseException],
+        traceback: Optional[types.TracebackType],
+    ) -> bool: ...
+    def __repr__(self) -> str: ...
+    @property
+    def stages(self) -> Dict[str, TrimStage]: ...
+    @property
+    def time(self) -> float: ...
+
+class TrimStage:
+    @property
+    def name(self) -> str: ...
+    @property
+    def time(self) -> float: ...
+    @property
+    def calls(self) -> int: ...
+    @property
+    def bytes(self) -> int: ...
+    def __repr__(self) -> str: ...
 
 # -- Misc classes ------------------------------------------------------------
 
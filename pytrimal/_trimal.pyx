@@ -49,26 +49,36 @@ References:
 
 cimport cython
 from cpython cimport Py_buffer
-from cpython.buffer cimport PyBUF_FORMAT, PyBUF_READ, PyBuffer_FillInfo
+from cpython.buffer cimport (
+    PyBUF_ANY_CONTIGUOUS,
+    PyBUF_C_CONTIGUOUS,
+    PyBUF_F_CONTIGUOUS,
+    PyBUF_FORMAT,
+    PyBUF_READ,
+    PyBUF_STRIDES,
+    PyBUF_WRITABLE,
+    PyBuffer_FillInfo,
+    PyBuffer_IsContiguous,
+)
 from cpython.bytes cimport PyBytes_FromStringAndSize, PyBytes_AsString
-from cpython.list cimport PyList_New, PyList_SET_ITEM
 from cpython.mem cimport PyMem_Free, PyMem_Malloc
 from cpython.memoryview cimport PyMemoryView_FromMemory, PyMemoryView_GET_BUFFER
-from cpython.ref cimport Py_INCREF
 from cpython.unicode cimport (
     PyUnicode_New,
     PyUnicode_KIND,
     PyUnicode_DATA,
     PyUnicode_WRITE,
+    PyUnicode_1BYTE_KIND,
 )
 
 from libc.errno cimport errno
 from libc.math cimport NAN, isnan, sqrt
 from libc.stdio cimport printf
-from libc.string cimport memset
+from libc.string cimport memcpy
 from libcpp cimport bool
+from libcpp.memory cimport make_shared, shared_ptr
 from libcpp.string cimport string
-from iostream cimport istream, ostream, stringbuf, filebuf, ios_base
+from iostream cimport istream, ostream, streambuf, stringbuf, filebuf, ios_base, streamsize
 
 cimport trimal
 cimport trimal.alignment
@@ -76,9 +86,39 @@ cimport trimal.format_handling
 cimport trimal.manager
 cimport trimal.report_system
 cimport trimal.similarity_matrix
+from trimal.cleaner cimport Cleaner
+from trimal.statistics cimport Gaps, Similarity
 
 from pytrimal.fileobj cimport pyreadbuf, pyreadintobuf, pywritebuf
+from pytrimal.impl.batch cimport TrimBatch, TrimTask
+from pytrimal.impl.bitsliced cimport BitslicedSimilarity, BitslicedGaps, BitslicedCleaner
+from pytrimal.impl.buffer cimport copyResidues
+from pytrimal.impl.compression cimport (
+    CompressedWriteBuffer,
+    NoCompression,
+    Gzip,
+    Zstd,
+    compressionSupported,
+    detectCompression,
+    detectFileCompression,
+    decompressFile,
+    decompressData,
+)
+from pytrimal.impl.context cimport (
+    AlignmentCache,
+    Context,
+    ResidueColumns,
+    StatisticGaps,
+    StatisticSimilarity,
+    StatisticCleaning,
+    alphabetType,
+)
+from pytrimal.impl.fasta cimport formatFasta, loadFasta, parseFasta
 from pytrimal.impl.generic cimport GenericSimilarity, GenericGaps, GenericCleaner
+from pytrimal.impl.identity cimport IdentityFloat32, IdentityFloat16, IdentityFixed16
+from pytrimal.impl.lease cimport SequenceLease
+from pytrimal.impl.profile cimport PROFILE_STAGES, Profile
+from pytrimal.impl.records cimport RecordReader
 if SSE2_BUILD_SUPPORT:
     from pytrimal.impl.sse cimport SSESimilarity, SSEGaps, SSECleaner
 if MMX_BUILD_SUPPORT:
@@ -87,10 +127,14 @@ if NEON_BUILD_SUPPORT:
     from pytrimal.impl.neon cimport NEONSimilarity, NEONGaps, NEONCleaner
 if AVX2_BUILD_SUPPORT:
     from pytrimal.impl.avx cimport AVXSimilarity, AVXGaps, AVXCleaner
+if AVX512_BUILD_SUPPORT:
+    from pytrimal.impl.avx512 cimport AVX512Similarity, AVX512Gaps, AVX512Cleaner
 
 
 # --- Python imports ---------------------------------------------------------
 
+import collections
+import json
 import os
 import threading
 
@@ -113,32 +157,40 @@ cdef extern from *:
 
 # --- Constants --------------------------------------------------------------
 
-_TARGET_CPU           = TARGET_CPU
-_HOST_CPU             = archspec.cpu.host()
-_SSE2_BUILD_SUPPORT   = False
-_SSE2_RUNTIME_SUPPORT = False
-_MMX_BUILD_SUPPORT    = False
-_MMX_RUNTIME_SUPPORT  = False
-_AVX2_BUILD_SUPPORT   = False
-_AVX2_RUNTIME_SUPPORT = False
-_NEON_BUILD_SUPPORT   = False
-_NEON_RUNTIME_SUPPORT = False
+_TARGET_CPU             = TARGET_CPU
+_HOST_CPU               = archspec.cpu.host()
+_SSE2_BUILD_SUPPORT     = False
+_SSE2_RUNTIME_SUPPORT   = False
+_MMX_BUILD_SUPPORT      = False
+_MMX_RUNTIME_SUPPORT    = False
+_AVX2_BUILD_SUPPORT     = False
+_AVX2_RUNTIME_SUPPORT   = False
+_AVX512_BUILD_SUPPORT   = False
+_AVX512_RUNTIME_SUPPORT = False
+_NEON_BUILD_SUPPORT     = False
+_NEON_RUNTIME_SUPPORT   = False
+_GZIP_BUILD_SUPPORT     = compressionSupported(Gzip)
+_ZSTD_BUILD_SUPPORT     = compressionSupported(Zstd)
 
 if TARGET_CPU == "x86" and TARGET_SYSTEM in ("freebsd", "linux_or_android", "macos", "windows"):
-    _MMX_BUILD_SUPPORT    = MMX_BUILD_SUPPORT
-    _SSE2_BUILD_SUPPORT   = SSE2_BUILD_SUPPORT
-    _AVX2_BUILD_SUPPORT   = AVX2_BUILD_SUPPORT
-    _MMX_RUNTIME_SUPPORT  = "mmx" in _HOST_CPU.features
-    _SSE2_RUNTIME_SUPPORT = "sse2" in _HOST_CPU.features
-    _AVX2_RUNTIME_SUPPORT = "avx2" in _HOST_CPU.features
+    _MMX_BUILD_SUPPORT      = MMX_BUILD_SUPPORT
+    _SSE2_BUILD_SUPPORT     = SSE2_BUILD_SUPPORT
+    _AVX2_BUILD_SUPPORT     = AVX2_BUILD_SUPPORT
+    _AVX512_BUILD_SUPPORT   = AVX512_BUILD_SUPPORT
+    _MMX_RUNTIME_SUPPORT    = "mmx" in _HOST_CPU.features
+    _SSE2_RUNTIME_SUPPORT   = "sse2" in _HOST_CPU.features
+    _AVX2_RUNTIME_SUPPORT   = "avx2" in _HOST_CPU.features
+    _AVX512_RUNTIME_SUPPORT = "avx512f" in _HOST_CPU.features and "avx512bw" in _HOST_CPU.features
 elif TARGET_CPU == "arm" and TARGET_SYSTEM == "linux_or_android":
-    _NEON_BUILD_SUPPORT   = NEON_BUILD_SUPPORT
-    _NEON_RUNTIME_SUPPORT = "neon" in _HOST_CPU.features
+    _NEON_BUILD_SUPPORT     = NEON_BUILD_SUPPORT
+    _NEON_RUNTIME_SUPPORT   = "neon" in _HOST_CPU.features
 elif TARGET_CPU == "aarch64":
-    _NEON_BUILD_SUPPORT   = NEON_BUILD_SUPPORT
-    _NEON_RUNTIME_SUPPORT = NEON_BUILD_SUPPORT  # always runtime support on Aarch64
+    _NEON_BUILD_SUPPORT     = NEON_BUILD_SUPPORT
+    _NEON_RUNTIME_SUPPORT   = NEON_BUILD_SUPPORT  # always runtime support on Aarch64
 
-if _AVX2_RUNTIME_SUPPORT:
+if _AVX512_RUNTIME_SUPPORT:
+    _BEST_BACKEND = simd_backend.AVX512
+elif _AVX2_RUNTIME_SUPPORT:
     _BEST_BACKEND = simd_backend.AVX2
 elif _SSE2_RUNTIME_SUPPORT:
     _BEST_BACKEND = simd_backend.SSE2
@@ -156,6 +208,32 @@ cdef enum simd_backend:
     NEON = 3
     AVX2 = 4
     MMX = 5
+    BITSLICED = 6
+    AVX512 = 7
+    AUTO = 8
+
+# the backends that can be selected by the calibration of the `auto` backend
+_AUTO_BACKENDS = {"detect": _BEST_BACKEND, "generic": simd_backend.GENERIC, "bitsliced": simd_backend.BITSLICED}
+if _MMX_BUILD_SUPPORT and _MMX_RUNTIME_SUPPORT:
+    _AUTO_BACKENDS["mmx"] = simd_backend.MMX
+if _SSE2_BUILD_SUPPORT and _SSE2_RUNTIME_SUPPORT:
+    _AUTO_BACKENDS["sse"] = simd_backend.SSE2
+if _AVX2_BUILD_SUPPORT and _AVX2_RUNTIME_SUPPORT:
+    _AUTO_BACKENDS["avx"] = simd_backend.AVX2
+if _AVX512_BUILD_SUPPORT and _AVX512_RUNTIME_SUPPORT:
+    _AUTO_BACKENDS["avx512"] = simd_backend.AVX512
+if _NEON_BUILD_SUPPORT and _NEON_RUNTIME_SUPPORT:
+    _AUTO_BACKENDS["neon"] = simd_backend.NEON
+
+# the rules used by the `auto` backend without a calibration table: the
+# generic code for tiny alignments, where the setup of the vectors costs
+# more than it saves, and threads only for alignments with many sequences
+_DEFAULT_CALIBRATION = [
+    {"sequences": 16, "residues": 1024, "backend": "generic", "threads": 1},
+    {"sequences": 256, "residues": None, "backend": "detect", "threads": 1},
+    {"sequences": None, "residues": None, "backend": "detect", "threads": 0},
+]
+_CALIBRATION = None
 
 
 # --- Utilities --------------------------------------------------------------
@@ -175,9 +253,9 @@ cdef number _check_positive(number value, str name) except *:
         raise ValueError(f"Invalid value for `{name}`: {value!r}")
     return value
 
-cdef int _check_fileobj_read(object fileobj) except 1:
+cdef int _check_fileobj_read(object fileobj, bint seekable = True) except 1:
     cdef str ty = type(fileobj).__name__
-    if not hasattr(fileobj, "seek") or not fileobj.seekable():
+    if seekable and (not hasattr(fileobj, "seek") or not fileobj.seekable()):
         raise TypeError(f"{ty!r} object is not seekable.")
     if not hasattr(fileobj, "readinto") and not hasattr(fileobj, "read"):
         raise TypeError(f"{ty!r} object has no attribute 'read'.")
@@ -188,6 +266,98 @@ cdef int _check_fileobj_read(object fileobj) except 1:
         raise TypeError(f"{ty!r} object is not open in binary mode.") from err
     return 0
 
+cdef int _check_fileobj_buffers(pyreadbuf* rbuffer, pyreadintobuf* r2buffer) except -1:
+    if rbuffer is not NULL:
+        rbuffer.check()
+    if r2buffer is not NULL:
+        r2buffer.check()
+    return 0
+
+cdef object _build_mask(const int* save, int length):
+    # build a read-only buffer of booleans from a trimAl mask, which can be
+    # used as a sequence or converted to an array without copy
+    cdef int    i
+    cdef bytes  mask = PyBytes_FromStringAndSize(NULL, length)
+    cdef char*  data = PyBytes_AsString(mask)
+    with nogil:
+        for i in range(length):
+            data[i] = save is NULL or save[i] != -1
+    return memoryview(mask).cast("?")
+
+cdef int _compression_format(str compression) except -1:
+    cdef int code
+    cdef str name = compression.lower()
+    if name in ("gzip", "gz"):
+        code = Gzip
+    elif name in ("zstd", "zst"):
+        code = Zstd
+    else:
+        raise ValueError(f"Unknown compression format: {compression!r}")
+    if not compressionSupported(code):
+        raise ValueError(f"pytrimal was built without {name} support")
+    return code
+
+cdef int _identity_format(str identity_format) except -1:
+    if identity_format == "float32":
+        return IdentityFloat32
+    elif identity_format == "float16":
+        return IdentityFloat16
+    elif identity_format == "uint16":
+        return IdentityFixed16
+    raise ValueError(f"Invalid value for `identity_format`: {identity_format!r}")
+
+cdef int _similarity_sample(object similarity_sample) except -1:
+    if similarity_sample is None:
+        return 0
+    cdef int samples = similarity_sample
+    if samples < 2:
+        raise ValueError(f"Invalid value for `similarity_sample`: {similarity_sample!r}")
+    return samples
+
+def _calibration_path():
+    # the calibration is only valid for the CPU it was measured on, so
+    # the file is named after the CPU microarchitecture
+    path = os.environ.get("PYTRIMAL_CALIBRATION")
+    if path:
+        return path
+    cache = os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache")
+    return os.path.join(cache, "pytrimal", f"calibration-{_HOST_CPU.name}.json")
+
+cdef list _load_calibration():
+    # load the rules of the `auto` backend from the calibration table
+    # written by `bench/bench.py --calibrate` once, or use the defaults
+    global _CALIBRATION
+    if _CALIBRATION is None:
+        try:
+            with open(_calibration_path()) as f:
+                _CALIBRATION = list(json.load(f)["rules"])
+        except (OSError, ValueError, KeyError, TypeError):
+            _CALIBRATION = _DEFAULT_CALIBRATION
+    return _CALIBRATION
+
+cdef tuple _auto_backend(int sequences, int residues, int threads):
+    # select the backend and threads of the first rule covering the shape
+    # of the alignment, using at most the threads given to the trimmer
+    cdef dict rule
+    for rule in _load_calibration():
+        if rule["sequences"] is not None and sequences > rule["sequences"]:
+            continue
+        if rule["residues"] is not None and residues > rule["residues"]:
+            continue
+        if rule["backend"] not in _AUTO_BACKENDS:
+            continue
+        if rule["threads"] == 0:
+            return _AUTO_BACKENDS[rule["backend"]], threads
+        return _AUTO_BACKENDS[rule["backend"]], min(rule["threads"], threads)
+    return _BEST_BACKEND, threads
+
+cdef int _check_compression(int code, object file) except -1:
+    # check the compression format detected from the magic bytes of a file
+    if code > NoCompression and not compressionSupported(code):
+        name = "gzip" if code == Gzip else "zstd"
+        raise RuntimeError(f"Failed to load alignment from {file!r}: pytrimal was built without {name} support")
+    return code
+
 cdef extern from *:
     """
     template <typename T>
@@ -206,9 +376,11 @@ cdef extern from "<ios>":
     """
     std::ios_base::openmode READMODE = std::ios_base::in;
     std::ios_base::openmode WRITEMODE = std::ios_base::out | std::ios_base::trunc;
+    std::ios_base::openmode BINARYWRITEMODE = WRITEMODE | std::ios_base::binary;
     """
     ios_base.openmode READMODE
     ios_base.openmode WRITEMODE
+    ios_base.openmode BINARYWRITEMODE
 
 
 # --- Alignment classes ------------------------------------------------------
@@ -412,12 +584,13 @@ cdef class AlignmentResidues:
         Return a single residue column in the alignment, creating a new string.
 
         """
-        cdef object col
-        cdef int    kind
-        cdef char*  data
-        cdef size_t x      = 0
-        cdef int    index_ = index
-        cdef int    length = self._ali.numberOfResidues
+        cdef object      col
+        cdef int         kind
+        cdef char*       data
+        cdef const char* column
+        cdef size_t      x      = 0
+        cdef int         index_ = index
+        cdef int         length = self._ali.numberOfResidues
 
         if index_ < 0:
             index_ += length
@@ -427,22 +600,29 @@ cdef class AlignmentResidues:
             index_ = self._index_mapping[index_]
 
         assert index_ < self._ali.originalNumberOfResidues
+        column = self._owner._cache.get().residueColumns(self._ali[0]).column(index_)
         if SYS_VERSION_INFO_MAJOR <= 3 and SYS_VERSION_INFO_MAJOR <= 7 and SYS_IMPLEMENTATION_NAME == "pypy":
             col  = PyBytes_FromStringAndSize(NULL, self._ali.numberOfSequences)
             data = PyBytes_AsString(col)
-            for i in range(self._ali.originalNumberOfSequences):
-                if self._ali.saveSequences is NULL or self._ali.saveSequences[i] != -1:
-                    data[x] = self._ali.sequences[i][index_]
-                    x += 1
+            if self._ali.saveSequences is NULL:
+                memcpy(data, column, self._ali.numberOfSequences)
+            else:
+                for i in range(self._ali.originalNumberOfSequences):
+                    if self._ali.saveSequences[i] != -1:
+                        data[x] = column[i]
+                        x += 1
             return col.decode('ascii')
         else:
             col = PyUnicode_New(self._ali.numberOfSequences, 0x7f)
             data = <char*> PyUnicode_DATA(col)
             kind = PyUnicode_KIND(col)
-            for i in range(self._ali.originalNumberOfSequences):
-                if self._ali.saveSequences is NULL or self._ali.saveSequences[i] != -1:
-                    PyUnicode_WRITE(kind, data, x, self._ali.sequences[i][index_])
-                    x += 1
+            if self._ali.saveSequences is NULL and kind == PyUnicode_1BYTE_KIND:
+                memcpy(data, column, self._ali.numberOfSequences)
+            else:
+                for i in range(self._ali.originalNumberOfSequences):
+                    if self._ali.saveSequences is NULL or self._ali.saveSequences[i] != -1:
+                        PyUnicode_WRITE(kind, data, x, column[i])
+                        x += 1
             return col
 
 
@@ -549,11 +729,85 @@ cdef class Alignment:
             ]
         )
 
+    @classmethod
+    def from_buffer(cls, object names not None, const unsigned char[:, :] buffer not None):
+        """from_buffer(cls, names, buffer)\n--
+
+        Create a new `Alignment` from a 2D buffer of sequence characters.
+
+        Arguments:
+            names (`~collections.abc.Sequence` of `bytes`): The names of
+                the sequences in the alignment.
+            buffer (buffer-like object): A 2D buffer of ``uint8`` storing
+                the ASCII characters of one sequence per row, such as a
+                `numpy.ndarray` of shape ``(len(names), residues)``.
+
+        Returns:
+            `~pytrimal.Alignment`: A new alignment with the given names, and
+            the sequences copied from the rows of ``buffer``.
+
+        Raises:
+            `ValueError`: When the number of names and rows differ, or when
+                the buffer contains characters that are not residues.
+
+        Example:
+            >>> data = memoryview(b"MVVKMVYK").cast("B", (2, 4))
+            >>> alignment = Alignment.from_buffer([b"seq1", b"seq2"], data)
+            >>> list(alignment.sequences)
+            ['MVVK', 'MVYK']
+
+        Hint:
+            The rows are copied and validated in one pass without the GIL,
+            without creating a Python string for each sequence, so this is
+            much faster than the `Alignment` constructor for large
+            alignments. The buffer of an `Alignment` can be given directly
+            together with its names, but not the buffer of a
+            `TrimmedAlignment`, which exports the rows and columns of the
+            original alignment rather than the retained ones.
+
+        .. versionadded:: 0.8.0
+
+        """
+        cdef bytes     name
+        cdef int       i
+        cdef int       invalid   = -1
+        cdef Alignment alignment = cls.__new__(cls)
+
+        if len(names) != buffer.shape[0]:
+            raise ValueError(f"`Alignment` given {len(names)!r} names but {buffer.shape[0]!r} sequences")
+
+        alignment._ali = new trimal.alignment.Alignment()
+        alignment._ali.numberOfSequences = buffer.shape[0]
+        alignment._ali.numberOfResidues = buffer.shape[1] if buffer.shape[0] > 0 else 0
+        alignment._ali.seqsName  = new_array[string](alignment._ali.numberOfSequences)
+        alignment._ali.sequences = new_array[string](alignment._ali.numberOfSequences)
+        for i, name in enumerate(names):
+            alignment._ali.seqsName[i] = name
+
+        if alignment._ali.numberOfResidues > 0:
+            with nogil:
+                invalid = copyResidues(
+                    alignment._ali[0],
+                    <const char*> &buffer[0, 0],
+                    buffer.strides[0],
+                    buffer.strides[1],
+                )
+            # let trimAl report the invalid character, if any
+            alignment._ali.fillMatrices(alignment._ali.numberOfSequences > 1, invalid != -1)
+            if invalid != -1:
+                raise ValueError(f"The sequence {names[invalid]!r} has an unknown character")
+
+        alignment._ali.originalNumberOfSequences = alignment._ali.numberOfSequences
+        alignment._ali.originalNumberOfResidues = alignment._ali.numberOfResidues
+        if isinstance(alignment, TrimmedAlignment):
+            (<TrimmedAlignment> alignment)._build_index_mapping()
+        return alignment
+
     # --- Parser / Loader ----------------------------------------------------
 
     @classmethod
-    def load(cls, object file not None, str format = None):
-        """load(cls, file, format=None)\n--
+    def load(cls, object file not None, str format = None, str compression = None):
+        """load(cls, file, format=None, compression=None)\n--
 
         Load a multiple sequence alignment from a file.
 
@@ -566,6 +820,9 @@ cdef class Alignment:
             format (`str`, *optional*): The file-format the alignment is
                 stored in. Must be given when loading from a file-like
                 object, will be autodetected when reading from a file.
+            compression (`str`, *optional*): The compression format of the
+                file, either ``gzip`` or ``zstd``. If `None` given, the
+                compression is detected from the first bytes of the file.
 
         Returns:
             `~pytrimal.Alignment`: The deserialized alignment.
@@ -578,12 +835,21 @@ cdef class Alignment:
         .. versionchanged:: 0.3.0
            Add support for reading code from a file-like object.
 
+        .. versionchanged:: 0.8.0
+           Add support for reading compressed files with ``compression``.
+
         """
         cdef trimal.format_handling.FormatManager      manager
         cdef trimal.format_handling.BaseFormatHandler* handler
 
+        cdef int            code
+        cdef bool           ok
+        cdef bytes          data
+        cdef const char*    data_
+        cdef size_t         size
+        cdef string         text
+        cdef string         error
         cdef string         path_
-        cdef char           cbuffer[DEFAULT_BUFFER_SIZE]
         cdef filebuf        fbuffer
         cdef pyreadbuf*     rbuffer   = NULL
         cdef pyreadintobuf* r2buffer  = NULL
@@ -600,48 +866,262 @@ cdef class Alignment:
                 raise FileNotFoundError(file)
             elif os.path.isdir(file):
                 raise IsADirectoryError(file)
-            # load the alignment from the given path
             path_ = os.fsencode(file)
-            alignment._ali = manager.loadAlignment(path_)
+            if compression is not None:
+                code = _compression_format(compression)
+            else:
+                with nogil:
+                    code = detectFileCompression(path_.c_str())
+                _check_compression(code, file)
+            if code > NoCompression:
+                # decompress the file in memory without the GIL, so that
+                # other threads can keep running in the meantime
+                with nogil:
+                    ok = decompressFile(path_.c_str(), code, text, error)
+                if not ok:
+                    raise RuntimeError(f"Failed to decompress {file!r}: {error.decode()}")
+                alignment._load_text(text, format)
+            else:
+                # load the alignment from the given path, mapping FASTA
+                # files directly in memory if possible
+                if format is None or format.lower() == "fasta":
+                    with nogil:
+                        alignment._ali = loadFasta(path_.c_str())
+                if alignment._ali is NULL:
+                    alignment._ali = manager.loadAlignment(path_)
+                else:
+                    alignment._finish_parsing()
         else:
             # check the file-like object has all the required features
             _check_fileobj_read(file)
-            # clear buffer (crash on PyPI otherwise)
-            memset(cbuffer, 0, DEFAULT_BUFFER_SIZE*sizeof(char))
             # make sure a format was given
             if format is None:
                 raise ValueError("Format must be specified when loading from a file-like object")
-            # get the right format handler
-            handler = manager.getFormatFromToken(format.lower().encode('ascii'))
-            if handler is NULL:
-                raise ValueError(f"Unknown alignment format: {format!r}")
-            # create a file-like object wrapper
-            # attempt to use `readinto` if available and not on PyPy
+            # detect the compression from the first bytes of the file
+            if compression is not None:
+                code = _compression_format(compression)
+            else:
+                position = file.tell()
+                data = file.read(4)
+                file.seek(position)
+                code = _check_compression(detectCompression(data, len(data)), file)
+            if code > NoCompression:
+                # read the compressed data, and decompress it without the GIL
+                data = file.read()
+                data_ = data
+                size = len(data)
+                with nogil:
+                    ok = decompressData(data_, size, code, text, error)
+                if not ok:
+                    raise RuntimeError(f"Failed to decompress {file!r}: {error.decode()}")
+                alignment._load_text(text, format)
+            else:
+                # get the right format handler
+                handler = manager.getFormatFromToken(format.lower().encode('ascii'))
+                if handler is NULL:
+                    raise ValueError(f"Unknown alignment format: {format!r}")
+                # create a file-like object wrapper
+                # attempt to use `readinto` if available and not on PyPy
+                if SYS_IMPLEMENTATION_NAME == "cpython" and hasattr(file, "readinto"):
+                    r2buffer = new pyreadintobuf(file)
+                    stream = new istream(r2buffer)
+                else:
+                    rbuffer = new pyreadbuf(file)
+                    stream = new istream(rbuffer)
+                # load the alignment from the istream, raising the exceptions
+                # of the file-like object before any trimAl error
+                try:
+                    if handler.CheckAlignment(stream) == 0:
+                        _check_fileobj_buffers(rbuffer, r2buffer)
+                        raise RuntimeError(f"Failed to recognize format {format!r} in {file!r}")
+                    stream.seekg(0)
+                    alignment._ali = handler.LoadAlignment(stream[0])
+                    _check_fileobj_buffers(rbuffer, r2buffer)
+                finally:
+                    del stream
+                    del rbuffer
+                    del r2buffer
+
+        if alignment._ali is NULL:
+            raise RuntimeError(f"Failed to load alignment from {file!r}.")
+        return alignment
+
+    @classmethod
+    def iter_load(cls, object file not None, str format = "fasta"):
+        """iter_load(cls, file, format="fasta")\n--
+
+        Load several multiple sequence alignments stored in the same file.
+
+        Arguments:
+            file (`str`, `bytes`, `os.PathLike` or file-like object): The
+                file from which to read the alignments. If a file-like object
+                is given, it must be open in *binary* mode, but it is only
+                read forward, so pipes or compressed streams can be used.
+                Otherwise, ``file`` is treated as a path.
+            format (`str`): The file-format the alignments are stored in.
+                Only the ``fasta``, ``clustal``, ``mega``, ``nexus`` and
+                ``phylip`` formats and their variants are supported.
+
+        Yields:
+            `~pytrimal.Alignment`: The alignments, in the order they appear
+            in the file.
+
+        Raises:
+            `ValueError`: When ``format`` is not a recognized file format,
+                or is a format that can't be read as a stream.
+            `RuntimeError`: When one of the alignments could not be loaded.
+                The error is raised when reaching that alignment, after all
+                the previous alignments were yielded.
+
+        Hint:
+            Alignments are separated by the header line of the following
+            alignment (such as ``CLUSTAL`` or ``#NEXUS``, or the line with
+            the number of sequences and residues for PHYLIP). FASTA files
+            have no header, so the alignments must be separated by at least
+            one blank line.
+
+        Example:
+            >>> alignments = Alignment.iter_load("example.001.AA.clw", "clustal")
+            >>> [msa.names[0] for msa in alignments]
+            [b'Sp8']
+
+        .. versionadded:: 0.8.0
+
+        """
+        cdef trimal.format_handling.FormatManager      manager
+        cdef trimal.format_handling.BaseFormatHandler* handler
+        cdef string                                    token
+        cdef string                                    record
+        cdef string                                    path_
+        cdef bool                                      fasta
+        cdef bool                                      more
+        cdef filebuf*                                  fbuffer   = NULL
+        cdef pyreadbuf*                                rbuffer   = NULL
+        cdef pyreadintobuf*                            r2buffer  = NULL
+        cdef istream*                                  stream    = NULL
+        cdef RecordReader*                             reader    = NULL
+        cdef stringbuf*                                sbuffer   = NULL
+        cdef istream*                                  rstream   = NULL
+        cdef Alignment                                 alignment
+
+        token = format.lower().encode('ascii')
+        handler = manager.getFormatFromToken(token)
+        if handler is NULL:
+            raise ValueError(f"Unknown alignment format: {format!r}")
+        if not RecordReader.supports(token):
+            raise ValueError(f"Alignment format can't be read as a stream: {format!r}")
+        fasta = format.lower().startswith("fasta")
+
+        if SYS_VERSION_INFO_MAJOR == 3 and SYS_VERSION_INFO_MINOR < 6:
+            TYPES = (str, bytes)
+        else:
+            TYPES = (str, bytes, os.PathLike)
+        if isinstance(file, TYPES):
+            # check that file exists and is not a directory
+            if not os.path.exists(file):
+                raise FileNotFoundError(file)
+            elif os.path.isdir(file):
+                raise IsADirectoryError(file)
+            path_ = os.fsencode(file)
+            fbuffer = new filebuf()
+            if fbuffer.open(path_.c_str(), READMODE) is NULL:
+                del fbuffer
+                raise OSError(errno, f"Failed to open {file!r}")
+            stream = new istream(fbuffer)
+        else:
+            # the file-like object is only read, never rewinded
+            _check_fileobj_read(file, seekable=False)
             if SYS_IMPLEMENTATION_NAME == "cpython" and hasattr(file, "readinto"):
                 r2buffer = new pyreadintobuf(file)
-                r2buffer.pubsetbuf(cbuffer, 512)
                 stream = new istream(r2buffer)
             else:
                 rbuffer = new pyreadbuf(file)
-                rbuffer.pubsetbuf(cbuffer, 512)
                 stream = new istream(rbuffer)
-            # load the alignment from the istream
-            try:
-                if handler.CheckAlignment(stream) == 0:
-                    raise RuntimeError(f"Failed to recognize format {format!r} in {file!r}")
+
+        try:
+            # the record and the stream used to parse it are reused for
+            # every alignment
+            reader = new RecordReader(stream[0], token)
+            sbuffer = new stringbuf()
+            rstream = new istream(sbuffer)
+            while True:
+                # read the text of the next alignment, without the GIL
+                # unless reading from a Python file-like object
+                if fbuffer is not NULL:
+                    with nogil:
+                        more = reader.next(record)
+                else:
+                    more = reader.next(record)
+                    _check_fileobj_buffers(rbuffer, r2buffer)
+                if not more:
+                    break
+                # parse FASTA alignments directly, or use the trimAl parser
+                alignment = Alignment.__new__(Alignment)
+                if fasta:
+                    with nogil:
+                        alignment._ali = parseFasta(record.data(), record.size())
+                if alignment._ali is not NULL:
+                    alignment._finish_parsing()
+                else:
+                    sbuffer.str(record)
+                    rstream.clear()
+                    alignment._ali = handler.LoadAlignment(rstream[0])
+                if alignment._ali is NULL:
+                    raise RuntimeError(f"Failed to load alignment from {file!r}.")
+                yield alignment
+        finally:
+            del rstream
+            del sbuffer
+            del reader
+            del stream
+            del rbuffer
+            del r2buffer
+            del fbuffer
+
+    cdef int _load_text(self, const string& text, str format) except 1:
+        # load an alignment from its decompressed text, detecting its
+        # format if none was given
+        assert self._ali is NULL
+
+        cdef trimal.format_handling.FormatManager      manager
+        cdef trimal.format_handling.BaseFormatHandler* handler = NULL
+        cdef stringbuf*                                sbuffer = NULL
+        cdef istream*                                  stream  = NULL
+
+        if format is not None:
+            handler = manager.getFormatFromToken(format.lower().encode('ascii'))
+            if handler is NULL:
+                raise ValueError(f"Unknown alignment format: {format!r}")
+        if format is None or format.lower() == "fasta":
+            with nogil:
+                self._ali = parseFasta(text.data(), text.size())
+            if self._ali is not NULL:
+                return self._finish_parsing()
+
+        sbuffer = new stringbuf(text)
+        stream = new istream(sbuffer)
+        try:
+            if handler is NULL:
+                self._ali = manager.loadAlignment(stream[0])
+            elif handler.CheckAlignment(stream) != 0:
                 stream.seekg(0)
-                alignment._ali = handler.LoadAlignment(stream[0])
-            finally:
-                del stream
-                del rbuffer
-                del r2buffer
+                self._ali = handler.LoadAlignment(stream[0])
+        finally:
+            del stream
+            del sbuffer
+        return 0
 
-        if alignment._ali is NULL:
-            raise RuntimeError(f"Failed to load alignment from {file!r}.")
-        return alignment
+    cdef int _finish_parsing(self) except 1:
+        # check the residues of an alignment parsed by `parseFasta` or
+        # `loadFasta`, as trimAl would do after loading it
+        assert self._ali is not NULL
+        self._ali.fillMatrices(True, True)
+        self._ali.originalNumberOfSequences = self._ali.numberOfSequences
+        self._ali.originalNumberOfResidues = self._ali.numberOfResidues
+        return 0
 
-    cpdef void dump(self, object file, str format="fasta") except *:
-        """dump(self, file, format="fasta")\n--
+    cpdef void dump(self, object file, str format="fasta", str compression=None) except *:
+        """dump(self, file, format="fasta", compression=None)\n--
 
         Dump the alignment to a file or a file-like object.
 
@@ -652,10 +1132,15 @@ cdef class Alignment:
                 ``file`` is treated as a path.
             format (`str`): The name of the alignment format to write. See
                 below for a list of supported formats.
+            compression (`str`, *optional*): The compression format to
+                use, either ``gzip`` or ``zstd``, or `None` to write the
+                alignment uncompressed.
 
         Raises:
-            `ValueError`: When ``format`` is not a recognized file format.
-            `OSError`: When the path given as ``file`` could not be opened.
+            `ValueError`: When ``format`` is not a recognized file format,
+                or ``compression`` is not a supported compression format.
+            `OSError`: When the path given as ``file`` could not be opened,
+                or the compressed data could not be written.
 
         Hint:
             The alignment can be written in one of the following formats:
@@ -702,20 +1187,32 @@ cdef class Alignment:
 
         .. versionadded:: 0.2.2
 
+        .. versionchanged:: 0.8.0
+           Add support for writing compressed files with ``compression``.
+
         """
         assert self._ali != NULL
 
         cdef bool                                      is_fileobj
+        cdef bool                                      ok
+        cdef bool                                      formatted  = False
+        cdef int                                       code       = NoCompression
         cdef bytes                                     path_
+        cdef string                                    text
         cdef trimal.format_handling.FormatManager      manager
         cdef trimal.format_handling.BaseFormatHandler* handler
         cdef filebuf                                   fbuffer
+        cdef stringbuf                                 sbuffer
+        cdef streambuf*                                sink
         cdef pywritebuf*                               pbuffer    = NULL
+        cdef CompressedWriteBuffer*                    zbuffer    = NULL
         cdef ostream*                                  stream     = NULL
 
         handler = manager.getFormatFromToken(format.lower().encode('ascii'))
         if handler is NULL:
             raise ValueError(f"Could not recognize alignment format: {format!r}")
+        if compression is not None:
+            code = _compression_format(compression)
 
         if SYS_VERSION_INFO_MAJOR == 3 and SYS_VERSION_INFO_MINOR < 6:
             TYPES = (str, bytes)
@@ -723,17 +1220,60 @@ cdef class Alignment:
             TYPES = (str, bytes, os.PathLike)
         if isinstance(file, TYPES):
             path_ = os.fsencode(file)
-            if fbuffer.open(<const char*> path_, WRITEMODE) is NULL:
+            if fbuffer.open(<const char*> path_, WRITEMODE if code == NoCompression else BINARYWRITEMODE) is NULL:
                 raise OSError(errno, f"Failed to open {file!r}")
-            stream = new ostream(&fbuffer)
+            sink = &fbuffer
         else:
             pbuffer = new pywritebuf(file)
-            stream = new ostream(pbuffer)
+            sink = pbuffer
+
+        # render compressed alignments in memory first, so that they can be
+        # compressed without the GIL unless writing to a file-like object
+        if code == NoCompression:
+            stream = new ostream(sink)
+        else:
+            stream = new ostream(&sbuffer)
 
         try:
-            handler.SaveAlignment(self._ali[0], stream)
+            # format FASTA records without the GIL when possible, and fall
+            # back to the trimAl format handler otherwise
+            if format.lower() == "fasta":
+                with nogil:
+                    formatted = formatFasta(self._ali[0], text)
+            if not formatted:
+                handler.SaveAlignment(self._ali[0], stream)
+            if code != NoCompression:
+                if not formatted:
+                    text = sbuffer.str()
+                zbuffer = new CompressedWriteBuffer(sink, code, -1)
+                if pbuffer is NULL:
+                    with nogil:
+                        ok = zbuffer.sputn(text.data(), text.size()) == <streamsize> text.size()
+                        ok = zbuffer.finish() and ok
+                else:
+                    ok = zbuffer.sputn(text.data(), text.size()) == <streamsize> text.size()
+                    ok = zbuffer.finish() and ok
+                    # raise the exception of the file-like object, if any
+                    if not ok:
+                        pbuffer.flush()
+                if not ok:
+                    raise OSError(f"Failed to write compressed data to {file!r}: {zbuffer.error.decode()}")
+            elif formatted:
+                if pbuffer is NULL:
+                    with nogil:
+                        ok = sink.sputn(text.data(), text.size()) == <streamsize> text.size()
+                else:
+                    ok = sink.sputn(text.data(), text.size()) == <streamsize> text.size()
+                    # raise the exception of the file-like object, if any
+                    if not ok:
+                        pbuffer.flush()
+                if not ok:
+                    raise OSError(f"Failed to write data to {file!r}")
+            if pbuffer is not NULL:
+                pbuffer.flush()
         finally:
             del stream
+            del zbuffer
             if pbuffer is not NULL:
                 del pbuffer
             fbuffer.close()
@@ -758,6 +1298,8 @@ cdef class Alignment:
         assert self._ali != NULL
 
         cdef stringbuf                                 buffer
+        cdef string                                    text
+        cdef bool                                      formatted = False
         cdef ostream*                                  stream
         cdef trimal.format_handling.FormatManager      manager
         cdef trimal.format_handling.BaseFormatHandler* handler
@@ -766,6 +1308,12 @@ cdef class Alignment:
         if handler is NULL:
             raise ValueError(f"Could not recognize alignment format: {format!r}")
 
+        if format.lower() == "fasta":
+            with nogil:
+                formatted = formatFasta(self._ali[0], text)
+            if formatted:
+                return text.decode(encoding)
+
         buffer = stringbuf()
         stream = new ostream(&buffer)
 
@@ -781,10 +1329,13 @@ cdef class Alignment:
         self._ali = NULL
         self._sequences_mapping = NULL
         self._residues_mapping = NULL
+        self._cache = make_shared[AlignmentCache]()
 
     def __dealloc__(self):
         if self._ali is not NULL:
             del self._ali
+        # release the sequences once the alignment sharing them is deleted
+        self._lease.reset()
         if self._sequences_mapping is not NULL:
             PyMem_Free(self._sequences_mapping)
         if self._residues_mapping is not NULL:
@@ -879,6 +1430,61 @@ cdef class Alignment:
     def __copy__(self):
         return self.copy()
 
+    if SYS_IMPLEMENTATION_NAME == "cpython":
+
+        def __getbuffer__(self, Py_buffer* buffer, int flags):
+            """Export the residues of the alignment as a 2D buffer of bytes.
+
+            The buffer views the column-major copy of the residues kept by
+            the alignment, so that no data is copied after the first access.
+            Its shape is the number of sequences and residues of the
+            *original* alignment, which can be combined with the masks
+            of a `TrimmedAlignment` to select the retained residues.
+
+            """
+            assert self._ali is not NULL
+
+            cdef const ResidueColumns* columns
+
+            if flags & PyBUF_WRITABLE:
+                raise BufferError("alignment buffers are read-only")
+            if (flags & PyBUF_STRIDES) != PyBUF_STRIDES:
+                raise BufferError("alignment buffers are strided")
+
+            columns = &self._cache.get().residueColumns(self._ali[0])
+            # setup indexing information
+            self._shape[0] = columns.sequences
+            self._shape[1] = columns.residues
+            self._strides[0] = sizeof(char)
+            self._strides[1] = columns.stride
+            # update buffer information
+            if flags & PyBUF_FORMAT:
+                buffer.format = b"B"
+            else:
+                buffer.format = NULL
+            buffer.buf = <void*> columns.column(0)
+            buffer.internal = NULL
+            buffer.itemsize = sizeof(char)
+            buffer.len = self._shape[0] * self._shape[1] * sizeof(char)
+            buffer.ndim = 2
+            buffer.obj = self
+            buffer.readonly = 1
+            buffer.shape = &self._shape[0]
+            buffer.suboffsets = NULL
+            buffer.strides = &self._strides[0]
+            # check the layout matches the requested contiguity
+            if (flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS and not PyBuffer_IsContiguous(buffer, b'C'):
+                raise BufferError("alignment buffers are not C-contiguous")
+            if (flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS and not PyBuffer_IsContiguous(buffer, b'F'):
+                raise BufferError("alignment buffers are not Fortran-contiguous")
+            if (flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS and not PyBuffer_IsContiguous(buffer, b'A'):
+                raise BufferError("alignment buffers are not contiguous")
+            # record the export so that the cache is not cleared under it
+            self._exports += 1
+
+        def __releasebuffer__(self, Py_buffer* buffer):
+            self._exports -= 1
+
     # --- Properties ---------------------------------------------------------
 
     @property
@@ -924,8 +1530,36 @@ cdef class Alignment:
         assert self._ali is not NULL
         cdef Alignment copy = (type(self)).__new__(type(self))
         copy._ali = new trimal.alignment.Alignment(self._ali[0])
+        copy._cache = self._cache
+        copy._lease = self._lease
         return copy
 
+    cpdef void clear_cache(self) except *:
+        """clear_cache(self)\n--
+
+        Release the statistics and the derived data kept with the alignment.
+
+        The statistics computed by the SIMD backends, such as the gap
+        counts or the identity matrices, are kept with the alignment so
+        that trimming it again only recomputes the statistics whose
+        parameters changed, within a limit of 256 MiB per alignment. Use
+        this method to release them once the alignment will not be
+        trimmed anymore. Copies of the alignment keep sharing the
+        statistics until they are cleared as well.
+
+        Raises:
+            `BufferError`: When the residues of the alignment are exported
+                through the buffer protocol, since the exported buffer
+                views data kept with the statistics.
+
+        .. versionadded:: 0.8.0
+
+        """
+        if self._exports > 0:
+            raise BufferError("cannot clear the cache of an alignment with exported buffers")
+        # trimmings in progress keep the previous cache alive until they end
+        self._cache = make_shared[AlignmentCache]()
+
 
 cdef class TrimmedAlignment(Alignment):
     """A multiple sequence alignment that has been trimmed.
@@ -968,10 +1602,10 @@ cdef class TrimmedAlignment(Alignment):
     # --- Parser / Loader ----------------------------------------------------
 
     @classmethod
-    def load(cls, object file not None, str format = None):
+    def load(cls, object file not None, str format = None, str compression = None):
         # For compatibility, allow loading a trimmed alignment from a file
         # even though it makes it effectively not trimmed
-        cdef Alignment alignment = Alignment.load(file, format)
+        cdef Alignment alignment = Alignment.load(file, format, compression)
         cdef TrimmedAlignment trimmed = TrimmedAlignment.__new__(TrimmedAlignment)
         trimmed._ali = alignment._ali
         alignment._ali = NULL
@@ -1071,41 +1705,25 @@ cdef class TrimmedAlignment(Alignment):
 
     @property
     def residues_mask(self):
-        """sequence of `bool`: Which residues are kept in the alignment.
-        """
-        assert self._ali is not NULL
-
-        cdef int    i
-        cdef object mask = PyList_New(self._ali.originalNumberOfResidues)
-
-        for i in range(self._ali.originalNumberOfResidues):
-            if self._ali.saveResidues is NULL or self._ali.saveResidues[i] != -1:
-                Py_INCREF(True)
-                PyList_SET_ITEM(mask, i, True)
-            else:
-                Py_INCREF(False)
-                PyList_SET_ITEM(mask, i, False)
+        """`memoryview` of `bool`: Which residues are kept in the alignment.
 
-        return mask
+        .. versionchanged:: 0.8.0
+           Return a read-only `memoryview` of booleans instead of a `list`.
 
-    @property
-    def sequences_mask(self):
-        """sequence of `bool`: Which sequences are kept in the alignment.
         """
         assert self._ali is not NULL
+        return _build_mask(self._ali.saveResidues, self._ali.originalNumberOfResidues)
 
-        cdef int    i
-        cdef object mask = PyList_New(self._ali.originalNumberOfSequences)
+    @property
+    def sequences_mask(self):
+        """`memoryview` of `bool`: Which sequences are kept in the alignment.
 
-        for i in range(self._ali.originalNumberOfSequences):
-            if self._ali.saveSequences is NULL or self._ali.saveSequences[i] != -1:
-                Py_INCREF(True)
-                PyList_SET_ITEM(mask, i, True)
-            else:
-                Py_INCREF(False)
-                PyList_SET_ITEM(mask, i, False)
+        .. versionchanged:: 0.8.0
+           Return a read-only `memoryview` of booleans instead of a `list`.
 
-        return mask
+        """
+        assert self._ali is not NULL
+        return _build_mask(self._ali.saveSequences, self._ali.originalNumberOfSequences)
 
     # --- Functions ----------------------------------------------------------
 
@@ -1122,6 +1740,7 @@ cdef class TrimmedAlignment(Alignment):
         assert self._ali is not NULL
         cdef Alignment orig = Alignment.__new__(Alignment)
         orig._ali = new trimal.alignment.Alignment(self._ali[0])
+        orig._lease = self._lease
         del_array[int](orig._ali.saveSequences)
         del_array[int](orig._ali.saveResidues)
         orig._ali.saveSequences = NULL
@@ -1143,6 +1762,7 @@ cdef class TrimmedAlignment(Alignment):
         assert self._ali is not NULL
         cdef TrimmedAlignment term_only = TrimmedAlignment.__new__(TrimmedAlignment)
         term_only._ali = new trimal.alignment.Alignment(self._ali[0])
+        term_only._lease = self._lease
         term_only._ali.Cleaning.removeOnlyTerminal()
         term_only._build_index_mapping()
         return term_only
@@ -1155,12 +1775,96 @@ cdef class TrimmedAlignment(Alignment):
         """
         cdef TrimmedAlignment copy = TrimmedAlignment.__new__(TrimmedAlignment)
         copy._ali = new trimal.alignment.Alignment(self._ali[0])
+        copy._lease = self._lease
         copy._build_index_mapping()
         return copy
 
 
 # -- Trimmer classes ---------------------------------------------------------
 
+cdef void _setup_simd_code(int backend, trimal.manager.trimAlManager* manager, const Context& base) noexcept nogil:
+    cdef Similarity* similarity = NULL
+    cdef Cleaner*    cleaner    = NULL
+    cdef Gaps*       gaps       = NULL
+
+    if backend == simd_backend.NONE:
+        return
+
+    # detect the alphabet once, so that the statistics all dispatch to the
+    # kernels specialized for the alphabet without checking it again
+    cdef Context context = base
+    context.alphabet = alphabetType(manager.origAlig[0])
+
+    # only create the statistics used by the trimmer, the others being left
+    # to trimAl, which only computes them if they are ever needed
+    if backend == simd_backend.GENERIC:
+        if context.statistics & StatisticSimilarity:
+            similarity = new GenericSimilarity(manager.origAlig, context)
+        if context.statistics & StatisticCleaning:
+            cleaner = new GenericCleaner(manager.origAlig, context)
+        if context.statistics & StatisticGaps:
+            gaps = new GenericGaps(manager.origAlig, context)
+    if backend == simd_backend.BITSLICED:
+        if context.statistics & StatisticSimilarity:
+            similarity = new BitslicedSimilarity(manager.origAlig, context)
+        if context.statistics & StatisticCleaning:
+            cleaner = new BitslicedCleaner(manager.origAlig, context)
+        if context.statistics & StatisticGaps:
+            gaps = new BitslicedGaps(manager.origAlig, context)
+    if MMX_BUILD_SUPPORT:
+        if backend == simd_backend.MMX:
+            if context.statistics & StatisticSimilarity:
+                similarity = new MMXSimilarity(manager.origAlig, context)
+            if context.statistics & StatisticCleaning:
+                cleaner = new MMXCleaner(manager.origAlig, context)
+            if context.statistics & StatisticGaps:
+                gaps = new MMXGaps(manager.origAlig, context)
+    if AVX2_BUILD_SUPPORT:
+        if backend == simd_backend.AVX2:
+            if context.statistics & StatisticSimilarity:
+                similarity = new AVXSimilarity(manager.origAlig, context)
+            if context.statistics & StatisticCleaning:
+                cleaner = new AVXCleaner(manager.origAlig, context)
+            if context.statistics & StatisticGaps:
+                gaps = new AVXGaps(manager.origAlig, context)
+    if AVX512_BUILD_SUPPORT:
+        if backend == simd_backend.AVX512:
+            if context.statistics & StatisticSimilarity:
+                similarity = new AVX512Similarity(manager.origAlig, context)
+            if context.statistics & StatisticCleaning:
+                cleaner = new AVX512Cleaner(manager.origAlig, context)
+            if context.statistics & StatisticGaps:
+                gaps = new AVX512Gaps(manager.origAlig, context)
+    if SSE2_BUILD_SUPPORT:
+        if backend == simd_backend.SSE2:
+            if context.statistics & StatisticSimilarity:
+                similarity = new SSESimilarity(manager.origAlig, context)
+            if context.statistics & StatisticCleaning:
+                cleaner = new SSECleaner(manager.origAlig, context)
+            if context.statistics & StatisticGaps:
+                gaps = new SSEGaps(manager.origAlig, context)
+    if NEON_BUILD_SUPPORT:
+        if backend == simd_backend.NEON:
+            if context.statistics & StatisticSimilarity:
+                similarity = new NEONSimilarity(manager.origAlig, context)
+            if context.statistics & StatisticCleaning:
+                cleaner = new NEONCleaner(manager.origAlig, context)
+            if context.statistics & StatisticGaps:
+                gaps = new NEONGaps(manager.origAlig, context)
+
+    if similarity != NULL:
+        del manager.origAlig.Statistics.similarity
+        manager.origAlig.Statistics.similarity = similarity
+    if cleaner != NULL:
+        del manager.origAlig.Cleaning
+        manager.origAlig.Cleaning = cleaner
+    # trimAl expects the gap statistics to be computed once created
+    if gaps != NULL:
+        del manager.origAlig.Statistics.gaps
+        manager.origAlig.Statistics.gaps = gaps
+        gaps.CalculateVectors()
+
+
 cdef class BaseTrimmer:
     """A sequence alignment trimmer.
 
@@ -1171,21 +1875,87 @@ cdef class BaseTrimmer:
 
     # --- Magic methods ------------------------------------------------------
 
-    def __init__(self, *, str backend = "detect"):
-        """__init__(self, *, backend="detect")\n--
+    def __init__(
+        self,
+        *,
+        str backend = "detect",
+        int threads = 1,
+        str identity_format = "float32",
+        object similarity_sample = None,
+    ):
+        """__init__(self, *, backend="detect", threads=1, identity_format="float32", similarity_sample=None)\n--
 
         Create a new base trimmer.
 
         Keyword Arguments:
             backend (`str`, *optional*): The SIMD extension backend to use
                 to accelerate computation of pairwise similarity statistics.
-                If `None` given, use the original code from trimAl.
+                If `None` given, use the original code from trimAl. Use
+                ``"bitsliced"`` to compute the pairwise identities from
+                bit-plane encoded sequences with popcounts. Use ``"auto"``
+                to select the backend and the number of threads for each
+                alignment from its shape, see the *Note* below.
+            threads (`int`, *optional*): The number of threads to use to
+                compute the pairwise sequence statistics. Pass ``0`` to
+                use as many threads as there are CPUs on the machine.
+                With the ``"auto"`` backend, this is the maximum number
+                of threads to use.
+            identity_format (`str`, *optional*): The encoding of the
+                pairwise identity matrix used by the similarity statistic,
+                stored as a packed upper triangle. Use ``"float16"`` or
+                ``"uint16"`` to halve its memory usage on large alignments,
+                at the cost of slightly approximate similarity scores.
+            similarity_sample (`int`, *optional*): The number of sequences
+                to sample to estimate the similarity statistic, or `None`
+                to use the pairs of all sequences. See the *Note* below.
+
+        Note:
+            The similarity of a column is computed from a weighted average
+            of the distances between the residues of all pairs of
+            sequences, which takes quadratic time in the number of
+            sequences. When ``similarity_sample`` is given, only the pairs
+            between a deterministic random sample of *k* sequences are
+            used, reducing the computation to *k²* pairs. The weighted
+            average is the ratio of two averages over the sampled pairs,
+            and by Hoeffding's inequality for U-statistics, each of them
+            deviates from its exact value by more than *t* with a
+            probability of at most :math:`2 e^{-2 \lfloor k / 2 \rfloor
+            t^2 / R^2}`, where *R* is the range of the averaged values:
+            the identities are in :math:`[0, 1]`, and the distances in
+            the range of the similarity matrix. With *k* = 1000 sampled
+            sequences, each average is within 0.09 *R* of its exact
+            value with a probability of 99.9%, and in practice the column
+            similarities differ by a few hundredths. All sequences are
+            still checked for invalid characters.
+
+        Note:
+            The ``"auto"`` backend selects the backend and the number of
+            threads from the number of sequences and residues of each
+            alignment, using a calibration table measured on the local
+            machine with ``python bench/bench.py --calibrate``. The table
+            is read from the path in the ``PYTRIMAL_CALIBRATION``
+            environment variable, or from the user cache directory.
+            Without a calibration table, conservative default rules are
+            used. Sampled similarities are never selected automatically.
 
         .. versionadded:: 0.2.0
            The ``backend`` keyword argument.
 
+        .. versionadded:: 0.8.0
+           The ``threads``, ``identity_format`` and ``similarity_sample``
+           keyword arguments, and the ``bitsliced``, ``avx512`` and
+           ``auto`` backends.
+
         """
-        if TARGET_CPU == "x86":
+        if threads == 0:
+            threads = os.cpu_count() or 1
+        self._threads = _check_positive[int](threads, "threads")
+        self._identity_format = _identity_format(identity_format)
+        self._similarity_sample = _similarity_sample(similarity_sample)
+
+        if backend == "auto":
+            self._backend = simd_backend.AUTO
+        elif TARGET_CPU == "x86":
             if backend =="detect":
                 self._backend = simd_backend.GENERIC
                 if MMX_BUILD_SUPPORT and _MMX_RUNTIME_SUPPORT:
@@ -1194,6 +1964,8 @@ cdef class BaseTrimmer:
                     self._backend = simd_backend.SSE2
                 if AVX2_BUILD_SUPPORT and _AVX2_RUNTIME_SUPPORT:
                     self._backend = simd_backend.AVX2
+                if AVX512_BUILD_SUPPORT and _AVX512_RUNTIME_SUPPORT:
+                    self._backend = simd_backend.AVX512
             elif backend == "mmx":
                 if not MMX_BUILD_SUPPORT:
                     raise RuntimeError("Extension was compiled without MMX support")
@@ -1208,6 +1980,13 @@ cdef class BaseTrimmer:
                     raise RuntimeError("Cannot run AVX2 instructions on this machine")
                 else:
                     self._backend = simd_backend.AVX2
+            elif backend == "avx512":
+                if not AVX512_BUILD_SUPPORT:
+                    raise RuntimeError("Extension was compiled without AVX-512 support")
+                elif not _AVX512_RUNTIME_SUPPORT:
+                    raise RuntimeError("Cannot run AVX-512 instructions on this machine")
+                else:
+                    self._backend = simd_backend.AVX512
             elif backend == "sse":
                 if not SSE2_BUILD_SUPPORT:
                     raise RuntimeError("Extension was compiled without SSE2 support")
@@ -1217,6 +1996,8 @@ cdef class BaseTrimmer:
                     self._backend = simd_backend.SSE2
             elif backend == "generic":
                 self._backend = simd_backend.GENERIC
+            elif backend == "bitsliced":
+                self._backend = simd_backend.BITSLICED
             elif backend is None:
                 self._backend = simd_backend.NONE
             else:
@@ -1235,6 +2016,8 @@ cdef class BaseTrimmer:
                     self._backend = simd_backend.NEON
             elif backend == "generic":
                 self._backend = simd_backend.GENERIC
+            elif backend == "bitsliced":
+                self._backend = simd_backend.BITSLICED
             elif backend is None:
                 self._backend = simd_backend.NONE
             else:
@@ -1242,28 +2025,42 @@ cdef class BaseTrimmer:
         else:
             if backend == "detect" or backend == "generic":
                 self._backend = simd_backend.GENERIC
+            elif backend == "bitsliced":
+                self._backend = simd_backend.BITSLICED
             elif backend is None:
                 self._backend = simd_backend.NONE
             else:
                 raise ValueError(f"Unsupported backend on this architecture: {backend}")
 
     def __repr__(self):
-        cdef str ty  = type(self).__name__
-        cdef str arg = ""
+        cdef str ty    = type(self).__name__
+        cdef list args = []
         if self._backend != _BEST_BACKEND:
-            arg = f"backend={self.backend!r}"
-        return f"{ty}({arg})"
+            args.append(f"backend={self.backend!r}")
+        if self._threads != 1:
+            args.append(f"threads={self._threads!r}")
+        if self._identity_format != IdentityFloat32:
+            args.append(f"identity_format={self.identity_format!r}")
+        if self._similarity_sample != 0:
+            args.append(f"similarity_sample={self._similarity_sample!r}")
+        return f"{ty}({', '.join(args)})"
 
     def __getstate__(self):
         return {
             "backend": self.backend,
+            "threads": self._threads,
+            "identity_format": self.identity_format,
+            "similarity_sample": self.similarity_sample,
         }
 
     def __setstate__(self, dict state):
+        cdef int threads = state.get("threads", 1)
+        cdef str identity_format = state.get("identity_format", "float32")
+        cdef object similarity_sample = state.get("similarity_sample")
         try:
-            self.__init__(backend=state["backend"])
+            self.__init__(backend=state["backend"], threads=threads, identity_format=identity_format, similarity_sample=similarity_sample)
         except (ValueError, RuntimeError):
-            self.__init__(backend="detect")
+            self.__init__(backend="detect", threads=threads, identity_format=identity_format, similarity_sample=similarity_sample)
 
     # --- Properties ---------------------------------------------------------
 
@@ -1278,66 +2075,112 @@ cdef class BaseTrimmer:
             return "sse"
         elif self._backend == simd_backend.AVX2:
             return "avx"
+        elif self._backend == simd_backend.AVX512:
+            return "avx512"
         elif self._backend == simd_backend.MMX:
             return "mmx"
         elif self._backend == simd_backend.NEON:
             return "neon"
         elif self._backend == simd_backend.GENERIC:
             return "generic"
+        elif self._backend == simd_backend.BITSLICED:
+            return "bitsliced"
+        elif self._backend == simd_backend.AUTO:
+            return "auto"
         else:
             return None
 
-    # --- Utils --------------------------------------------------------------
+    @property
+    def threads(self):
+        """`int`: The number of threads used to compute pairwise statistics.
+
+        .. versionadded:: 0.8.0
+
+        """
+        return self._threads
 
-    cdef void _setup_simd_code(self, trimal.manager.trimAlManager* manager) nogil:
-        if self._backend == simd_backend.GENERIC:
-            del manager.origAlig.Statistics.similarity
-            manager.origAlig.Statistics.similarity = new GenericSimilarity(manager.origAlig)
-            del manager.origAlig.Cleaning
-            manager.origAlig.Cleaning = new GenericCleaner(manager.origAlig)
-            del manager.origAlig.Statistics.gaps
-            manager.origAlig.Statistics.gaps = new GenericGaps(manager.origAlig)
-            manager.origAlig.Statistics.gaps.CalculateVectors()
-        if MMX_BUILD_SUPPORT:
-            if self._backend == simd_backend.MMX:
-                del manager.origAlig.Statistics.similarity
-                manager.origAlig.Statistics.similarity = new MMXSimilarity(manager.origAlig)
-                del manager.origAlig.Cleaning
-                manager.origAlig.Cleaning = new MMXCleaner(manager.origAlig)
-                del manager.origAlig.Statistics.gaps
-                manager.origAlig.Statistics.gaps = new MMXGaps(manager.origAlig)
-                manager.origAlig.Statistics.gaps.CalculateVectors()
-        if AVX2_BUILD_SUPPORT:
-            if self._backend == simd_backend.AVX2:
-                del manager.origAlig.Statistics.similarity
-                manager.origAlig.Statistics.similarity = new AVXSimilarity(manager.origAlig)
-                del manager.origAlig.Cleaning
-                manager.origAlig.Cleaning = new AVXCleaner(manager.origAlig)
-                del manager.origAlig.Statistics.gaps
-                manager.origAlig.Statistics.gaps = new AVXGaps(manager.origAlig)
-                manager.origAlig.Statistics.gaps.CalculateVectors()
-        if SSE2_BUILD_SUPPORT:
-            if self._backend == simd_backend.SSE2:
-                del manager.origAlig.Statistics.similarity
-                manager.origAlig.Statistics.similarity = new SSESimilarity(manager.origAlig)
-                del manager.origAlig.Cleaning
-                manager.origAlig.Cleaning = new SSECleaner(manager.origAlig)
-                del manager.origAlig.Statistics.gaps
-                manager.origAlig.Statistics.gaps = new SSEGaps(manager.origAlig)
-                manager.origAlig.Statistics.gaps.CalculateVectors()
-        if NEON_BUILD_SUPPORT:
-            if self._backend == simd_backend.NEON:
-                del manager.origAlig.Statistics.similarity
-                manager.origAlig.Statistics.similarity = new NEONSimilarity(manager.origAlig)
-                del manager.origAlig.Cleaning
-                manager.origAlig.Cleaning = new NEONCleaner(manager.origAlig)
-                del manager.origAlig.Statistics.gaps
-                manager.origAlig.Statistics.gaps = new NEONGaps(manager.origAlig)
-                manager.origAlig.Statistics.gaps.CalculateVectors()
+    @property
+    def identity_format(self):
+        """`str`: The encoding of the pairwise identity matrix.
+
+        .. versionadded:: 0.8.0
+
+        """
+        if self._identity_format == IdentityFloat16:
+            return "float16"
+        elif self._identity_format == IdentityFixed16:
+            return "uint16"
+        else:
+            return "float32"
+
+    @property
+    def similarity_sample(self):
+        """`int` or `None`: The number of sequences sampled to estimate
+        the similarity statistic, or `None` to use all sequences.
+
+        .. versionadded:: 0.8.0
+
+        """
+        return self._similarity_sample or None
+
+    # --- Utils --------------------------------------------------------------
 
     cdef void _configure_manager(self, trimal.manager.trimAlManager* manager):
         pass
 
+    cdef void _prepare_task(self, TrimTask* task, Alignment alignment, SimilarityMatrix matrix) except *:
+        # for trimmed alignments, we must first extract the saved sequences
+        # and residues, otherwise the trimming will occur on the orignal
+        # alignment instead of the trimmed one! this is done by the task
+        # itself, so that the copy happens without the GIL
+        if isinstance(alignment, TrimmedAlignment):
+            task.alignment = alignment._ali
+            task.compact = True
+        # otherwise the manager works on a copy of the alignment that only
+        # owns its masks, so that the original alignment is left untouched,
+        # while the sequences are shared through a lease that outlives the
+        # trimmed alignment
+        else:
+            task.lease = make_shared[SequenceLease](alignment._ali[0])
+            task.alignment = task.lease.get().copy()
+            task.compact = False
+            # share the data derived from the alignment content (such as
+            # the gap masks) with other calls using the same alignment
+            task.context.cache = alignment._cache
+        # select the backend from the shape of the alignment if needed
+        if self._backend == simd_backend.AUTO:
+            task.backend, task.context.threads = _auto_backend(
+                alignment._ali.numberOfSequences,
+                alignment._ali.numberOfResidues,
+                self._threads,
+            )
+        else:
+            task.backend = self._backend
+            task.context.threads = self._threads
+        task.context.identityFormat = self._identity_format
+        task.context.similaritySample = self._similarity_sample
+        task.context.profile = self._profile
+
+        # use the similarity matrix from the argument if any
+        if matrix is not None:
+            task.matrix = &matrix._smx
+
+        # configure the manager (to be implemented by the different subclasses)
+        self._configure_manager(&task.manager)
+
+    cdef TrimmedAlignment _finish_task(self, TrimTask* task):
+        # raise the errors and warnings reported while trimming
+        task.reports.restore()
+        if task.trimmed is NULL:
+            raise RuntimeError("Failed to trim alignment")
+        # create a TrimmedAlignment object from the trimmed alignment
+        cdef TrimmedAlignment trimmed = TrimmedAlignment.__new__(TrimmedAlignment)
+        trimmed._ali = task.trimmed
+        trimmed._lease = task.lease
+        task.trimmed = NULL
+        trimmed._build_index_mapping()
+        return trimmed
+
     # --- Functions ----------------------------------------------------------
 
     cpdef TrimmedAlignment trim(self, Alignment alignment, SimilarityMatrix matrix = None):
@@ -1365,50 +2208,132 @@ cdef class BaseTrimmer:
            Added the ``matrix`` optional argument.
 
         """
-        # use a local manager object so that this method is re-entrant
-        cdef Alignment                    copy
-        cdef trimal.manager.trimAlManager manager
-
-        # copy the alignment to the manager object so that the original
-        # alignment is left untouched; for trimmed alignments, we must
-        # first extract the saved sequences and residues, otherwise the
-        # trimming will occur on the orignal alignment instead of the
-        # trimmed one!
-        if isinstance(alignment, TrimmedAlignment):
-            copy = Alignment(alignment.names, alignment.sequences)
-            manager.origAlig = copy._ali
-            copy._ali = NULL
-        else:
-            manager.origAlig = new trimal.alignment.Alignment(alignment._ali[0])
-
-        # configure the manager (to be implemented by the different subclasses)
-        self._configure_manager(&manager)
+        # use a local task object so that this method is re-entrant
+        cdef TrimTask task
 
+        self._prepare_task(&task, alignment, matrix)
         with nogil:
-            # setup computation of optimized statistics with SIMD
-            self._setup_simd_code(&manager)
-            # set flags
-            manager.set_window_size()
-            if manager.blockSize != -1:
-                manager.origAlig.setBlockSize(manager.blockSize)
-            # set similarity matrix from argument or load a default one
-            if matrix is not None:
-                manager.origAlig.Statistics.setSimilarityMatrix(&matrix._smx)
-            else:
-                manager.create_or_use_similarity_matrix()
-            # clean alignment
-            manager.clean_alignment()
-            # use original alignment as single alignment if needed
-            if manager.singleAlig == NULL:
-                manager.singleAlig = manager.origAlig
-                manager.origAlig = NULL
-
-        # trim alignment and create a TrimmedAlignment object
-        cdef TrimmedAlignment trimmed = TrimmedAlignment.__new__(TrimmedAlignment)
-        trimmed._ali = new trimal.alignment.Alignment(manager.singleAlig[0])
-        trimmed._build_index_mapping()
+            task.run(_setup_simd_code)
+        return self._finish_task(&task)
+
+    def trim_many(self, object alignments, SimilarityMatrix matrix = None, int threads = 0):
+        """trim_many(self, alignments, matrix=None, threads=0)\n--
+
+        Trim several alignments in parallel.
+
+        Arguments:
+            alignments (iterable of `~pytrimal.Alignment`): The multiple
+                sequence alignments to trim.
+            matrix (`~pytrimal.SimilarityMatrix`, optional): An alternative
+                similarity matrix to use for computing the similarity
+                statistic. If `None`, a default matrix will be used based
+                on the type of each alignment.
+            threads (`int`): The number of alignments to trim concurrently.
+                Pass ``0`` to use as many threads as there are CPUs on the
+                machine.
+
+        Yields:
+            `~pytrimal.TrimmedAlignment`: The trimmed alignments, in the
+            same order as the input alignments.
+
+        Raises:
+            `ValueError`: When one of the alignments contains invalid
+                characters. The error is raised when reaching the invalid
+                alignment, after all the previous alignments were yielded.
+
+        Hint:
+            The input iterable is consumed lazily, keeping at most four
+            alignments per thread in flight: new alignments are read as
+            the trimmed alignments are yielded. The alignments are trimmed
+            in the background by a pool of threads that do not hold the
+            GIL, which steal work from each other so that a large alignment
+            does not delay all the alignments following it. Each alignment
+            is still trimmed with the number of threads given to the
+            trimmer constructor to compute its pairwise statistics.
+
+        .. versionadded:: 0.8.0
+
+        """
+        cdef Alignment             alignment
+        cdef size_t                i
+        cdef size_t                window
+        cdef object                inputs    = collections.deque()
+        cdef TrimmedAlignment      trimmed
+        cdef shared_ptr[TrimBatch] batch     = make_shared[TrimBatch]()
+
+        if threads == 0:
+            threads = os.cpu_count() or 1
+        _check_positive[int](threads, "threads")
+        window = 4 * threads
+
+        try:
+            batch.get().start(threads, _setup_simd_code)
+            i = 0
+            # configure and submit a task for every alignment, keeping a
+            # reference to the inputs so that they stay alive until they are
+            # trimmed, and yield the oldest one once the window is full
+            for alignment in alignments:
+                self._prepare_task(&batch.get().add(), alignment, matrix)
+                inputs.append(alignment)
+                batch.get().submit(batch.get().size() - 1)
+                if batch.get().size() - i >= window:
+                    trimmed = self._next_task(batch.get(), i)
+                    inputs.popleft()
+                    i += 1
+                    yield trimmed
+            # yield the alignments still in flight
+            while i < batch.get().size():
+                trimmed = self._next_task(batch.get(), i)
+                inputs.popleft()
+                i += 1
+                yield trimmed
+        finally:
+            # stop the workers before releasing the inputs they may be
+            # reading, in case the generator is not exhausted, without
+            # holding the GIL while they finish their current task
+            with nogil:
+                batch.get().stop()
+                batch.reset()
+
+    cdef TrimmedAlignment _next_task(self, TrimBatch* batch, size_t i):
+        # wait for the task `i` of a batch and release it once trimmed
+        cdef TrimmedAlignment trimmed
+        try:
+            with nogil:
+                batch.wait(i)
+            trimmed = self._finish_task(&batch.task(i))
+        finally:
+            batch.release(i)
         return trimmed
 
+    def profile(self):
+        """profile(self)\n--
+
+        Profile the alignments trimmed by this trimmer.
+
+        Returns:
+            `~pytrimal.TrimProfile`: A context manager recording the time
+            spent in each stage of the trimming of all the alignments
+            trimmed by this trimmer while the context is active.
+
+        Example:
+            >>> msa = Alignment.load("example.001.AA.clw")
+            >>> trimmer = ManualTrimmer(gap_threshold=0.5)
+            >>> with trimmer.profile() as profile:
+            ...     trimmed = trimmer.trim(msa)
+            >>> profile.stages["gaps"].calls > 0
+            True
+
+        Hint:
+            Only the statistics computed by the SIMD backends are timed
+            separately, so with ``backend=None`` all the statistics are
+            recorded in the ``cleaning`` stage.
+
+        .. versionadded:: 0.8.0
+
+        """
+        return TrimProfile(self)
+
 
 cdef class AutomaticTrimmer(BaseTrimmer):
     """A sequence alignment trimmer with automatic parameter detection.
@@ -1459,8 +2384,16 @@ cdef class AutomaticTrimmer(BaseTrimmer):
 
     # --- Magic methods ------------------------------------------------------
 
-    def __init__(self, str method="strict", *, str backend="detect"):
-        """__init__(self, method="strict", *, backend="detect")\n--
+    def __init__(
+        self,
+        str method="strict",
+        *,
+        str backend="detect",
+        int threads=1,
+        str identity_format="float32",
+        object similarity_sample=None,
+    ):
+        """__init__(self, method="strict", *, backend="detect", threads=1, identity_format="float32", similarity_sample=None)\n--
 
         Create a new automatic alignment trimmer using the given method.
 
@@ -1473,6 +2406,16 @@ cdef class AutomaticTrimmer(BaseTrimmer):
             backend (`str`, *optional*): The SIMD extension backend to use
                 to accelerate computation of pairwise similarity statistics.
                 If `None` given, use the original code from trimAl.
+            threads (`int`, *optional*): The number of threads to use to
+                compute the pairwise sequence statistics. Pass ``0`` to
+                use as many threads as there are CPUs on the machine.
+            identity_format (`str`, *optional*): The encoding of the
+                pairwise identity matrix used by the similarity statistic,
+                either ``"float32"``, ``"float16"`` or ``"uint16"``.
+            similarity_sample (`int`, *optional*): The number of sequences
+                to sample to estimate the similarity statistic, or `None`
+                to use all sequences. See `BaseTrimmer` for the error
+                bounds of the estimate.
 
         Raises:
             `ValueError`: When ``method`` is not one of the automatic
@@ -1485,7 +2428,12 @@ cdef class AutomaticTrimmer(BaseTrimmer):
            The ``noduplicateseqs`` method.
 
         """
-        super().__init__(backend=backend)
+        super().__init__(
+            backend=backend,
+            threads=threads,
+            identity_format=identity_format,
+            similarity_sample=similarity_sample,
+        )
 
         if method not in self.METHODS:
             raise ValueError(f"Invalid value for `method`: {method!r}")
@@ -1496,40 +2444,122 @@ cdef class AutomaticTrimmer(BaseTrimmer):
         cdef list args = [repr(self.method)]
         if self._backend != _BEST_BACKEND:
             args.append(f"backend={self.backend!r}")
+        if self._threads != 1:
+            args.append(f"threads={self._threads!r}")
+        if self._identity_format != IdentityFloat32:
+            args.append(f"identity_format={self.identity_format!r}")
+        if self._similarity_sample != 0:
+            args.append(f"similarity_sample={self._similarity_sample!r}")
         return f"{ty}({', '.join(args)})"
 
     def __getstate__(self):
         return {
             "method":  self.method,
             "backend": self.backend,
+            "threads": self._threads,
+            "identity_format": self.identity_format,
+            "similarity_sample": self.similarity_sample,
         }
 
     def __setstate__(self, dict state):
+        cdef int threads = state.get("threads", 1)
+        cdef str identity_format = state.get("identity_format", "float32")
+        cdef object similarity_sample = state.get("similarity_sample")
         try:
-            BaseTrimmer.__init__(self, backend=state["backend"])
+            BaseTrimmer.__init__(self, backend=state["backend"], threads=threads, identity_format=identity_format, similarity_sample=similarity_sample)
         except (ValueError, RuntimeError):
-            BaseTrimmer.__init__(self, backend="detect")
+            BaseTrimmer.__init__(self, backend="detect", threads=threads, identity_format=identity_format, similarity_sample=similarity_sample)
         self.method = state["method"]
 
     # --- Utils --------------------------------------------------------------
 
     cdef void _configure_manager(self, trimal.manager.trimAlManager* manager):
         BaseTrimmer._configure_manager(self, manager)
+        self._configure_method(manager, self.method)
+
+    cdef void _configure_method(self, trimal.manager.trimAlManager* manager, str method):
         manager.automatedMethodCount = 1
-        if self.method == "strict":
-            manager.strict = True
-        elif self.method == "strictplus":
-            manager.strictplus = True
-        elif self.method == "gappyout":
-            manager.gappyout = True
-        elif self.method == "nogaps":
-            manager.nogaps = True
-        elif self.method == "noallgaps":
-            manager.noallgaps = True
-        elif self.method == "automated1":
-            manager.automated1 = True
-        elif self.method == "noduplicateseqs":
-            manager.removeDuplicates = True
+        manager.strict               = method == "strict"
+        manager.strictplus           = method == "strictplus"
+        manager.gappyout             = method == "gappyout"
+        manager.nogaps               = method == "nogaps"
+        manager.noallgaps            = method == "noallgaps"
+        manager.automated1           = method == "automated1"
+        manager.removeDuplicates     = method == "noduplicateseqs"
+
+    # --- Functions ----------------------------------------------------------
+
+    def trim_methods(self, Alignment alignment not None, object methods, SimilarityMatrix matrix = None):
+        """trim_methods(self, alignment, methods, matrix=None)\n--
+
+        Trim an alignment with several automatic methods.
+
+        Arguments:
+            alignment (`~pytrimal.Alignment`): A multiple sequence
+                alignment to trim.
+            methods (iterable of `str`): The automatic trimming methods
+                to use, in place of the method of the trimmer. See the
+                documentation for `AutomaticTrimmer` for a list of
+                supported values.
+            matrix (`~pytrimal.SimilarityMatrix`, optional): An alternative
+                similarity matrix to use for computing the similarity
+                statistic. If `None`, a default matrix will be used based
+                on the type of the alignment.
+
+        Returns:
+            `list` of `~pytrimal.TrimmedAlignment`: The alignment trimmed
+            with each method, in the same order as ``methods``.
+
+        Raises:
+            `ValueError`: When one of ``methods`` is not one of the
+                automatic alignment trimming methods supported by trimAl.
+
+        Hint:
+            The alignment is trimmed with each method in turn without
+            releasing the statistics computed by the SIMD backends, so
+            the gap counts and similarity scores are only computed once
+            for all methods, and only the selection of the cut points is
+            done for every method. With ``backend=None``, the statistics
+            are computed again for every method.
+
+        Example:
+            >>> msa = Alignment.load("example.001.AA.clw")
+            >>> trimmer = AutomaticTrimmer()
+            >>> gappyout, strict = trimmer.trim_methods(msa, ["gappyout", "strict"])
+            >>> len(gappyout.sequences) == len(strict.sequences)
+            True
+
+        .. versionadded:: 0.8.0
+
+        """
+        cdef str                   method
+        cdef size_t                i
+        cdef TrimTask*             task
+        cdef list                  names   = list(methods)
+        cdef list                  results = []
+        cdef shared_ptr[TrimBatch] batch   = make_shared[TrimBatch]()
+
+        for method in names:
+            if method not in self.METHODS:
+                raise ValueError(f"Invalid value for `method`: {method!r}")
+
+        # configure a task for every method, sharing the statistics of the
+        # first task, which also covers trimmed alignments copied by the
+        # task rather than trimmed with the cache of the alignment
+        for method in names:
+            task = &batch.get().add()
+            self._prepare_task(task, alignment, matrix)
+            self._configure_method(&task.manager, method)
+            task.context.cache = batch.get().task(0).context.cache
+
+        # run the tasks in order on the current thread, so that each method
+        # reuses the statistics computed by the previous ones
+        with nogil:
+            for i in range(batch.get().size()):
+                batch.get().task(i).run(_setup_simd_code)
+        for i in range(batch.get().size()):
+            results.append(self._finish_task(&batch.get().task(i)))
+        return results
 
 
 cdef class ManualTrimmer(BaseTrimmer):
@@ -1572,8 +2602,11 @@ cdef class ManualTrimmer(BaseTrimmer):
         object gap_window              = None,
         object similarity_window       = None,
         str    backend                 = "detect",
+        int    threads                 = 1,
+        str    identity_format         = "float32",
+        object similarity_sample       = None,
     ):
-        """__init__(self, *, gap_threshold=None, gap_absolute_threshold=None, similarity_threshold=None, conservation_percentage=None, window=None, gap_window=None, similarity_window=None, backend="detect")\n--
+        """__init__(self, *, gap_threshold=None, gap_absolute_threshold=None, similarity_threshold=None, conservation_percentage=None, window=None, gap_window=None, similarity_window=None, backend="detect", threads=1, identity_format="float32", similarity_sample=None)\n--
 
         Create a new manual alignment trimmer with the given parameters.
 
@@ -1600,6 +2633,16 @@ cdef class ManualTrimmer(BaseTrimmer):
             backend (`str`, *optional*): The SIMD extension backend to use
                 to accelerate computation of pairwise similarity statistics.
                 If `None` given, use the original code from trimAl.
+            threads (`int`, *optional*): The number of threads to use to
+                compute the pairwise sequence statistics. Pass ``0`` to
+                use as many threads as there are CPUs on the machine.
+            identity_format (`str`, *optional*): The encoding of the
+                pairwise identity matrix used by the similarity statistic,
+                either ``"float32"``, ``"float16"`` or ``"uint16"``.
+            similarity_sample (`int`, *optional*): The number of sequences
+                to sample to estimate the similarity statistic, or `None`
+                to use all sequences. See `BaseTrimmer` for the error
+                bounds of the estimate.
 
         .. versionadded:: 0.2.0
            The ``backend`` keyword argument.
@@ -1611,7 +2654,12 @@ cdef class ManualTrimmer(BaseTrimmer):
            Removed ``consistency_threshold`` and ``consistency_window``.
 
         """
-        super().__init__(backend=backend)
+        super().__init__(
+            backend=backend,
+            threads=threads,
+            identity_format=identity_format,
+            similarity_sample=similarity_sample,
+        )
 
         if gap_threshold is not None and gap_absolute_threshold is not None:
             raise ValueError("Cannot specify both `gap_threshold` and `gap_absolute_threshold`")
@@ -1652,11 +2700,20 @@ cdef class ManualTrimmer(BaseTrimmer):
             args.append(f"similarity_window={self._similarity_window!r}")
         if self._backend != _BEST_BACKEND:
             args.append(f"backend={self.backend!r}")
+        if self._threads != 1:
+            args.append(f"threads={self._threads!r}")
+        if self._identity_format != IdentityFloat32:
+            args.append(f"identity_format={self.identity_format!r}")
+        if self._similarity_sample != 0:
+            args.append(f"similarity_sample={self._similarity_sample!r}")
         return f"{ty}({', '.join(args)})"
 
     def __getstate__(self):
         return {
             "backend":                 self.backend,
+            "threads":                 self._threads,
+            "identity_format":         self.identity_format,
+            "similarity_sample":       self.similarity_sample,
             "gap_threshold":           self._gap_threshold,
             "gap_absolute_threshold":  self._gap_absolute_threshold,
             "similarity_threshold":    self._similarity_threshold,
@@ -1667,10 +2724,13 @@ cdef class ManualTrimmer(BaseTrimmer):
         }
 
     def __setstate__(self, dict state):
+        cdef int threads = state.get("threads", 1)
+        cdef str identity_format = state.get("identity_format", "float32")
+        cdef object similarity_sample = state.get("similarity_sample")
         try:
-            BaseTrimmer.__init__(self, backend=state["backend"])
+            BaseTrimmer.__init__(self, backend=state["backend"], threads=threads, identity_format=identity_format, similarity_sample=similarity_sample)
         except (ValueError, RuntimeError):
-            BaseTrimmer.__init__(self, backend="detect")
+            BaseTrimmer.__init__(self, backend="detect", threads=threads, identity_format=identity_format, similarity_sample=similarity_sample)
         self._gap_threshold           = state["gap_threshold"]
         self._gap_absolute_threshold  = state["gap_absolute_threshold"]
         self._similarity_threshold    = state["similarity_threshold"]
@@ -1747,9 +2807,10 @@ cdef class OverlapTrimmer(BaseTrimmer):
         float sequence_overlap,
         float residue_overlap,
         *,
-        str backend="detect"
+        str backend="detect",
+        int threads=1,
     ):
-        """__init__(self, sequence_overlap, residue_overlap, *, backend="detect")\n--
+        """__init__(self, sequence_overlap, residue_overlap, *, backend="detect", threads=1)\n--
 
         Create a new overlap trimmer with the given thresholds.
 
@@ -1764,9 +2825,12 @@ cdef class OverlapTrimmer(BaseTrimmer):
             backend (`str`, *optional*): The SIMD extension backend to use
                 to accelerate computation of pairwise similarity statistics.
                 If `None` given, use the original code from trimAl.
+            threads (`int`, *optional*): The number of threads to use to
+                compute the pairwise sequence statistics. Pass ``0`` to
+                use as many threads as there are CPUs on the machine.
 
         """
-        super().__init__(backend=backend)
+        super().__init__(backend=backend, threads=threads)
         self._sequence_overlap = _check_range[float](sequence_overlap, "sequence_overlap", 0, 100)
         self._residue_overlap = _check_range[float](residue_overlap, "residue_overlap", 0, 1)
 
@@ -1775,20 +2839,24 @@ cdef class OverlapTrimmer(BaseTrimmer):
         cdef list args = [repr(self._sequence_overlap), repr(self._residue_overlap)]
         if self._backend != _BEST_BACKEND:
             args.append(f"backend={self.backend!r}")
+        if self._threads != 1:
+            args.append(f"threads={self._threads!r}")
         return f"{ty}({', '.join(args)})"
 
     def __getstate__(self):
         return {
             "backend":          self.backend,
+            "threads":          self._threads,
             "sequence_overlap": self._sequence_overlap,
             "residue_overlap":  self._residue_overlap,
         }
 
     def __setstate__(self, dict state):
+        cdef int threads = state.get("threads", 1)
         try:
-            BaseTrimmer.__init__(self, backend=state["backend"])
+            BaseTrimmer.__init__(self, backend=state["backend"], threads=threads)
         except (ValueError, RuntimeError):
-            BaseTrimmer.__init__(self, backend="detect")
+            BaseTrimmer.__init__(self, backend="detect", threads=threads)
         self._sequence_overlap = state["sequence_overlap"]
         self._residue_overlap  = state["residue_overlap"]
 
@@ -1799,6 +2867,11 @@ cdef class OverlapTrimmer(BaseTrimmer):
         manager.residuesOverlap       = self._residue_overlap
         manager.sequenceOverlap       = self._sequence_overlap
 
+    cdef void _prepare_task(self, TrimTask* task, Alignment alignment, SimilarityMatrix matrix) except *:
+        BaseTrimmer._prepare_task(self, task, alignment, matrix)
+        # the spurious sequences are found without gap or similarity statistics
+        task.context.statistics = StatisticCleaning
+
 
 cdef class RepresentativeTrimmer(BaseTrimmer):
     """A sequence alignment trimmer for selecting representative sequences.
@@ -1818,15 +2891,18 @@ cdef class RepresentativeTrimmer(BaseTrimmer):
     def __cinit__(self):
         self._clusters = -1
         self._identity_threshold = -1
+        self._greedy = False
 
     def __init__(
         self,
         object clusters = None,
         object identity_threshold = None,
         *,
-        str backend="detect"
+        str backend="detect",
+        int threads=1,
+        str clustering="exact",
     ):
-        """__init__(self, clusters=None, identity_threshold=None, *, backend="detect")\n--
+        """__init__(self, clusters=None, identity_threshold=None, *, backend="detect", threads=1, clustering="exact")\n--
 
         Create a new representative alignment trimmer.
 
@@ -1842,14 +2918,46 @@ cdef class RepresentativeTrimmer(BaseTrimmer):
             backend (`str`, *optional*): The SIMD extension backend to use
                 to accelerate computation of pairwise similarity statistics.
                 If `None` given, use the original code from trimAl.
+            threads (`int`, *optional*): The number of threads to use to
+                compute the pairwise sequence statistics. Pass ``0`` to
+                use as many threads as there are CPUs on the machine.
+            clustering (`str`, *optional*): The algorithm used to select
+                the representative sequences, either ``"exact"`` to use
+                the pairwise identities of all sequences like trimAl, or
+                ``"greedy"`` to only compare sequences to the cluster
+                representatives. See the *Note* below.
 
         Raises:
             `ValueError`: When both ``clusters`` and ``identity_threshold``
                 are provided at the same time, or when they don't fall in
                 a valid range.
 
+        Note:
+            trimAl visits the sequences from the longest to the shortest,
+            and makes a sequence the representative of a new cluster if
+            its identity to all previous representatives is below the
+            threshold, but computes the identity between all pairs of
+            sequences beforehand. The ``"greedy"`` clustering only
+            computes the identities to the representatives, which takes
+            time proportional to the number of clusters rather than to
+            the number of sequences, and selects the same representatives
+            with an ``identity_threshold``. With a number of ``clusters``,
+            the identity threshold giving that many clusters is searched
+            by bisection, which may select slightly different sequences
+            than trimAl, and less than ``clusters`` sequences when no
+            threshold gives exactly that many clusters. The ``"greedy"``
+            clustering is only supported by the SIMD backends, and the
+            ``"exact"`` clustering is used with ``backend=None``.
+
+        .. versionadded:: 0.8.0
+           The ``threads`` and ``clustering`` keyword arguments.
+
         """
-        super().__init__(backend=backend)
+        super().__init__(backend=backend, threads=threads)
+        if clustering == "greedy":
+            self._greedy = True
+        elif clustering != "exact":
+            raise ValueError(f"Invalid value for `clustering`: {clustering!r}")
         if clusters is not None and identity_threshold is not None:
             raise ValueError("Cannot specify both `clusters` and `identity_threshold`")
         if clusters is not None:
@@ -1866,22 +2974,41 @@ cdef class RepresentativeTrimmer(BaseTrimmer):
             args.append(f"identity_threshold={self._identity_threshold!r}")
         if self._backend != _BEST_BACKEND:
             args.append(f"backend={self.backend!r}")
+        if self._threads != 1:
+            args.append(f"threads={self._threads!r}")
+        if self._greedy:
+            args.append(f"clustering={self.clustering!r}")
         return f"{ty}({', '.join(args)})"
 
     def __getstate__(self):
         return {
             "backend":            self.backend,
+            "threads":            self._threads,
             "clusters":           self._clusters,
             "identity_threshold": self._identity_threshold,
+            "clustering":         self.clustering,
         }
 
     def __setstate__(self, dict state):
+        cdef int threads = state.get("threads", 1)
         try:
-            BaseTrimmer.__init__(self, backend=state["backend"])
+            BaseTrimmer.__init__(self, backend=state["backend"], threads=threads)
         except (ValueError, RuntimeError):
-            BaseTrimmer.__init__(self, backend="detect")
+            BaseTrimmer.__init__(self, backend="detect", threads=threads)
         self._clusters           = state["clusters"]
         self._identity_threshold = state["identity_threshold"]
+        self._greedy             = state.get("clustering", "exact") == "greedy"
+
+    # --- Properties ---------------------------------------------------------
+
+    @property
+    def clustering(self):
+        """`str`: The algorithm used to select representative sequences.
+
+        .. versionadded:: 0.8.0
+
+        """
+        return "greedy" if self._greedy else "exact"
 
     # --- Utils --------------------------------------------------------------
 
@@ -1890,6 +3017,134 @@ cdef class RepresentativeTrimmer(BaseTrimmer):
         manager.clusters              = self._clusters
         manager.maxIdentity           = self._identity_threshold
 
+    cdef void _prepare_task(self, TrimTask* task, Alignment alignment, SimilarityMatrix matrix) except *:
+        BaseTrimmer._prepare_task(self, task, alignment, matrix)
+        # the representatives are selected from the sequence identities only
+        task.context.statistics = StatisticCleaning
+        task.context.greedyClustering = self._greedy
+
+
+# -- Profiling classes -------------------------------------------------------
+
+cdef class TrimProfile:
+    """A profile of the time spent in each stage of trimming alignments.
+
+    Profiles are created with `BaseTrimmer.profile`, and record the
+    alignments trimmed by the trimmer while used as a context manager,
+    including the alignments trimmed by `BaseTrimmer.trim_many` or from
+    other threads. The statistics reused from a previous trimming of the
+    same alignment are recorded as well, so the number of calls of a
+    stage may be higher than the number of times it was computed.
+
+    The stages are the following:
+
+    - ``copy``: Copying the retained residues of a `TrimmedAlignment`
+      given as input.
+    - ``setup``: Creating the statistics of the backend, and loading the
+      similarity matrix.
+    - ``gaps``: Counting the gaps of each column.
+    - ``identity``: Computing the identity between pairs of sequences.
+    - ``similarity``: Computing the similarity of each column.
+    - ``overlap``: Computing the overlap of each sequence.
+    - ``cleaning``: Selecting the sequences and columns to keep, and
+      computing the statistics not supported by the backend.
+
+    The time of a stage excludes the time of the stages run by it, so that
+    the times of all stages add up to the time spent trimming.
+
+    .. versionadded:: 0.8.0
+
+    """
+
+    STAGES = (
+        "copy",
+        "setup",
+        "gaps",
+        "identity",
+        "similarity",
+        "overlap",
+        "cleaning",
+    )
+
+    def __init__(self, BaseTrimmer trimmer not None):
+        """__init__(self, trimmer)\n--
+
+        Create a new profile for the given trimmer.
+
+        """
+        self._profile = make_shared[Profile]()
+        self._trimmer = trimmer
+
+    def __enter__(self):
+        if self._trimmer._profile.get() != NULL:
+            raise RuntimeError("A profile is already active for this trimmer")
+        self._trimmer._profile = self._profile
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if self._trimmer._profile.get() == self._profile.get():
+            self._trimmer._profile.reset()
+        return False
+
+    def __repr__(self):
+        cdef str ty = type(self).__name__
+        return f"<{ty} time={self.time!r}>"
+
+    @property
+    def stages(self):
+        """`dict` of `str` to `~pytrimal.TrimStage`: The profile of each
+        stage, indexed by stage name.
+        """
+        assert self._profile.get() != NULL
+
+        cdef int       i
+        cdef TrimStage stage
+        cdef dict      stages = {}
+
+        for i in range(PROFILE_STAGES):
+            stage = TrimStage.__new__(TrimStage)
+            stage.name = self.STAGES[i]
+            stage.time = self._profile.get().nanoseconds(i) / 1e9
+            stage.calls = self._profile.get().calls(i)
+            stage.bytes = self._profile.get().bytes(i)
+            stages[stage.name] = stage
+        return stages
+
+    @property
+    def time(self):
+        """`float`: The total time spent trimming, in seconds.
+        """
+        assert self._profile.get() != NULL
+
+        cdef int    i
+        cdef double time = 0
+
+        for i in range(PROFILE_STAGES):
+            time += self._profile.get().nanoseconds(i) / 1e9
+        return time
+
+
+cdef class TrimStage:
+    """The time spent in a stage of trimming alignments.
+
+    Attributes:
+        name (`str`): The name of the stage.
+        time (`float`): The wall time spent in the stage, in seconds.
+        calls (`int`): The number of times the stage was run.
+        bytes (`int`): The number of residues of the alignments processed
+            by the stage, or zero for stages not reading residues.
+
+    .. versionadded:: 0.8.0
+
+    """
+
+    def __repr__(self):
+        cdef str ty = type(self).__name__
+        return (
+            f"{ty}(name={self.name!r}, time={self.time!r}, "
+            f"calls={self.calls!r}, bytes={self.bytes!r})"
+        )
+
 
 # -- Misc classes ------------------------------------------------------------
 
@@ -4,15 +4,21 @@ cdef extern from "pywritebuf.h" nogil:
 
     cdef cppclass pywritebuf(streambuf):
         pywritebuf(object)
+        pywritebuf(object, size_t bufsize)
+        int flush() except -1
 
 
 cdef extern from "pyreadbuf.h" nogil:
 
     cdef cppclass pyreadbuf(streambuf):
         pyreadbuf(object)
+        pyreadbuf(object, size_t bufsize)
+        int check() except -1
 
 
 cdef extern from "pyreadintobuf.h" nogil:
 
     cdef cppclass pyreadintobuf(streambuf):
         pyreadintobuf(object)
+        pyreadintobuf(object, size_t bufsize)
+        int check() except -1
@@ -1,69 +1,121 @@
+#include <algorithm>
+#include <cstring>
+
 #include "pyreadbuf.h"
 
-pyreadbuf::pyreadbuf(PyObject *handle) : std::streambuf(), handle(handle) {
+pyreadbuf::pyreadbuf(PyObject *handle, size_t bufsize)
+    : std::streambuf(), handle(handle), buffer(std::max<size_t>(bufsize, 1)),
+      failed(false) {
   Py_INCREF(handle);
   if (PyObject_HasAttrString(handle, "read1")) {
     method = PyUnicode_FromString("read1");
   } else {
     method = PyUnicode_FromString("read");
   }
-  bufsize_py = PyLong_FromLong(1);
-  setbuf(buffer, 1);
+  setg(buffer.data(), buffer.data(), buffer.data());
 }
 
 pyreadbuf::~pyreadbuf() {
   Py_DECREF(handle);
-  Py_DECREF(method);
-  Py_DECREF(bufsize_py);
+  Py_XDECREF(method);
 }
 
-std::streampos pyreadbuf::seekpos(std::streampos sp,
-                                  std::ios_base::openmode which) {
-  PyObject *n = PyObject_CallMethod(handle, "seek", "i", sp);
-  if (n == nullptr)
-    return std::streampos(std::streamoff(-1));
-
-  long l = PyLong_AsLong(n);
-  Py_DECREF(n);
+int pyreadbuf::check() const { return failed ? -1 : 0; }
 
-  setg(eback(), eback(), eback());
-  return std::streampos(std::streamoff(l));
-}
-
-pyreadbuf *pyreadbuf::setbuf(char *s, std::streamsize n) {
-  setg(s, &s[n], &s[n]);
-  bufsize = n;
-  Py_DECREF(bufsize_py);
-  bufsize_py = PyLong_FromLongLong(n);
-  return this;
-}
+Py_ssize_t pyreadbuf::read(char *s, Py_ssize_t n) {
+  // do not call the file-like object again after an exception was raised
+  if (failed || method == nullptr) {
+    failed = true;
+    return -1;
+  }
 
-int pyreadbuf::underflow() {
-  PyObject *bytes =
-      PyObject_CallMethodObjArgs(handle, method, bufsize_py, NULL);
+  PyObject *size = PyLong_FromSsize_t(n);
+  if (size == nullptr) {
+    failed = true;
+    return -1;
+  }
+  PyObject *bytes = PyObject_CallMethodObjArgs(handle, method, size, NULL);
+  Py_DECREF(size);
   if (bytes == nullptr) {
-    return EOF;
+    failed = true;
+    return -1;
   }
   if (!PyBytes_Check(bytes)) {
     Py_DECREF(bytes);
     PyErr_SetString(PyExc_TypeError, "a bytes-like object is required");
-    return EOF;
+    failed = true;
+    return -1;
   }
-  Py_ssize_t size = PyBytes_Size(bytes);
-  if (size <= 0) {
-    // EOF
-    Py_DECREF(bytes);
-    return EOF;
-  } else if (size > bufsize) {
-    // error
+
+  Py_ssize_t size_read = PyBytes_GET_SIZE(bytes);
+  if (size_read > n) {
     Py_DECREF(bytes);
     PyErr_SetString(PyExc_BufferError,
                     "more data returned by `read` than can fit in buffer");
-    return EOF;
-  } else {
-    // OK: copy bytes to the internal buffer and reset pointers.
-    memcpy(eback(), PyBytes_AS_STRING(bytes), size * sizeof(char));
-    setg(eback(), eback(), eback() + size);
-    return (size == 0) ? EOF : *eback();
+    failed = true;
+    return -1;
   }
+  memcpy(s, PyBytes_AS_STRING(bytes), size_read * sizeof(char));
+  Py_DECREF(bytes);
+  return size_read;
+}
+
+int pyreadbuf::underflow() {
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  Py_ssize_t n = read(buffer.data(), buffer.size());
+  if (n <= 0)
+    return traits_type::eof();
+  setg(buffer.data(), buffer.data(), buffer.data() + n);
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize pyreadbuf::xsgetn(char *s, std::streamsize n) {
+  std::streamsize done = 0;
+  while (done < n) {
+    std::streamsize available = egptr() - gptr();
+    if (available > 0) {
+      // copy the bytes already buffered
+      std::streamsize k = std::min(available, n - done);
+      memcpy(&s[done], gptr(), k * sizeof(char));
+      setg(eback(), gptr() + k, egptr());
+      done += k;
+    } else if (n - done >= (std::streamsize)buffer.size()) {
+      // read large blocks directly to the destination
+      Py_ssize_t k = read(&s[done], n - done);
+      if (k <= 0)
+        break;
+      done += k;
+    } else if (underflow() == traits_type::eof()) {
+      break;
+    }
+  }
+  return done;
+}
+
+std::streampos pyreadbuf::seekpos(std::streampos sp,
+                                  std::ios_base::openmode which) {
+  if (failed)
+    return std::streampos(std::streamoff(-1));
+
+  PyObject *n =
+      PyObject_CallMethod(handle, "seek", "L", (long long)std::streamoff(sp));
+  if (n == nullptr) {
+    failed = true;
+    return std::streampos(std::streamoff(-1));
+  }
+
+  // some file-like objects return `None` rather than the new position
+  long long l = (n == Py_None) ? (long long)std::streamoff(sp)
+                               : PyLong_AsLongLong(n);
+  Py_DECREF(n);
+  if ((l == -1) && PyErr_Occurred()) {
+    failed = true;
+    return std::streampos(std::streamoff(-1));
+  }
+
+  // discard the buffered bytes
+  setg(buffer.data(), buffer.data(), buffer.data());
+  return std::streampos(std::streamoff(l));
 }
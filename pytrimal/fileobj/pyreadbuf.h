@@ -1,25 +1,36 @@
 #include <Python.h>
 #include <streambuf>
+#include <vector>
 
 // Wrapper class that exposes a Python file-like object for reading operations.
-// Internally uses `read1` if possible, and `read` otherwise.
+// Internally uses `read1` if possible, and `read` otherwise, to fill a buffer
+// of `bufsize` bytes; reads larger than the buffer bypass it.
 class pyreadbuf : public std::streambuf {
-protected:
-  PyObject *handle;
-  PyObject *method;
-  char buffer[1];
-  PyObject *bufsize_py;
-  std::streamsize bufsize;
-
 public:
-  pyreadbuf(PyObject *handle);
+  static const size_t DEFAULT_BUFSIZE = 1 << 16;
+
+  pyreadbuf(PyObject *handle, size_t bufsize = DEFAULT_BUFSIZE);
   ~pyreadbuf();
 
+  // Return -1 if the file-like object raised an exception, which is left
+  // set for the caller to handle, or 0 otherwise.
+  int check() const;
+
 protected:
+  PyObject *handle;
+  PyObject *method;
+  std::vector<char> buffer;
+  bool failed;
+
   int underflow() override;
-  pyreadbuf *setbuf(char *s, std::streamsize n) override;
+  std::streamsize xsgetn(char *s, std::streamsize n) override;
   std::streampos
   seekpos(std::streampos sp,
           std::ios_base::openmode which = std::ios_base::in |
                                           std::ios_base::out) override;
+
+private:
+  // Read up to `n` bytes into `s`, and return the number of bytes read,
+  // or -1 if an exception was raised.
+  Py_ssize_t read(char *s, Py_ssize_t n);
 };
@@ -1,51 +1,115 @@
+#include <algorithm>
+#include <cstring>
+
 #include "pyreadintobuf.h"
 
-pyreadintobuf::pyreadintobuf(PyObject *handle)
-    : std::streambuf(), handle(handle) {
+pyreadintobuf::pyreadintobuf(PyObject *handle, size_t bufsize)
+    : std::streambuf(), handle(handle), buffer(std::max<size_t>(bufsize, 1)),
+      failed(false) {
+  Py_INCREF(handle);
   method = PyUnicode_FromString("readinto");
-  mview = PyMemoryView_FromMemory(buffer, 1, PyBUF_READ);
-  setbuf(buffer, 1);
+  setg(buffer.data(), buffer.data(), buffer.data());
 }
 
 pyreadintobuf::~pyreadintobuf() {
   Py_DECREF(handle);
-  Py_DECREF(method);
-  Py_DECREF(mview);
+  Py_XDECREF(method);
 }
 
-std::streampos pyreadintobuf::seekpos(std::streampos sp,
-                                      std::ios_base::openmode which) {
-  PyObject *n = PyObject_CallMethod(handle, "seek", "i", sp);
-  if (n == nullptr)
-    return std::streampos(std::streamoff(-1));
+int pyreadintobuf::check() const { return failed ? -1 : 0; }
 
-  long l = PyLong_AsLong(n);
-  Py_DECREF(n);
-
-  setg(eback(), eback(), eback());
-  return std::streampos(std::streamoff(l));
-}
+Py_ssize_t pyreadintobuf::readinto(char *s, Py_ssize_t n) {
+  // do not call the file-like object again after an exception was raised
+  if (failed || method == nullptr) {
+    failed = true;
+    return -1;
+  }
 
-pyreadintobuf *pyreadintobuf::setbuf(char *s, std::streamsize n) {
-  setg(s, &s[n], &s[n]);
-  bufsize = n;
+  // expose the destination to Python so that it is written in place
+  PyObject *mview = PyMemoryView_FromMemory(s, n, PyBUF_WRITE);
+  if (mview == nullptr) {
+    failed = true;
+    return -1;
+  }
+  PyObject *nread = PyObject_CallMethodObjArgs(handle, method, mview, NULL);
   Py_DECREF(mview);
-  mview = PyMemoryView_FromMemory(s, bufsize, PyBUF_WRITE);
-  return this;
+  if (nread == nullptr) {
+    failed = true;
+    return -1;
+  }
+
+  // non-blocking streams return `None` when no data is available
+  Py_ssize_t size_read = (nread == Py_None) ? 0 : PyLong_AsSsize_t(nread);
+  Py_DECREF(nread);
+  if ((size_read == -1) && PyErr_Occurred()) {
+    failed = true;
+    return -1;
+  }
+  if ((size_read < 0) || (size_read > n)) {
+    PyErr_SetString(PyExc_BufferError,
+                    "invalid number of bytes returned by `readinto`");
+    failed = true;
+    return -1;
+  }
+  return size_read;
 }
 
 int pyreadintobuf::underflow() {
-  PyObject *nread = PyObject_CallMethodObjArgs(handle, method, mview, NULL);
-  if (nread == nullptr) {
-    Py_DECREF(mview);
-    return EOF;
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  Py_ssize_t n = readinto(buffer.data(), buffer.size());
+  if (n <= 0)
+    return traits_type::eof();
+  setg(buffer.data(), buffer.data(), buffer.data() + n);
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize pyreadintobuf::xsgetn(char *s, std::streamsize n) {
+  std::streamsize done = 0;
+  while (done < n) {
+    std::streamsize available = egptr() - gptr();
+    if (available > 0) {
+      // copy the bytes already buffered
+      std::streamsize k = std::min(available, n - done);
+      memcpy(&s[done], gptr(), k * sizeof(char));
+      setg(eback(), gptr() + k, egptr());
+      done += k;
+    } else if (n - done >= (std::streamsize)buffer.size()) {
+      // read large blocks directly to the destination
+      Py_ssize_t k = readinto(&s[done], n - done);
+      if (k <= 0)
+        break;
+      done += k;
+    } else if (underflow() == traits_type::eof()) {
+      break;
+    }
   }
+  return done;
+}
+
+std::streampos pyreadintobuf::seekpos(std::streampos sp,
+                                  std::ios_base::openmode which) {
+  if (failed)
+    return std::streampos(std::streamoff(-1));
 
-  long n = PyLong_AsLong(nread);
-  int c = (n == 0) ? EOF : *eback();
+  PyObject *n =
+      PyObject_CallMethod(handle, "seek", "L", (long long)std::streamoff(sp));
+  if (n == nullptr) {
+    failed = true;
+    return std::streampos(std::streamoff(-1));
+  }
 
-  Py_DECREF(nread);
+  // some file-like objects return `None` rather than the new position
+  long long l = (n == Py_None) ? (long long)std::streamoff(sp)
+                               : PyLong_AsLongLong(n);
+  Py_DECREF(n);
+  if ((l == -1) && PyErr_Occurred()) {
+    failed = true;
+    return std::streampos(std::streamoff(-1));
+  }
 
-  setg(eback(), eback(), eback() + n);
-  return c;
+  // discard the buffered bytes
+  setg(buffer.data(), buffer.data(), buffer.data());
+  return std::streampos(std::streamoff(l));
 }
@@ -1,25 +1,37 @@
 #include <Python.h>
 #include <streambuf>
+#include <vector>
 
 // Wrapper class that exposes a Python file-like object for reading operations.
-// Internally uses `readinto` for zero-copy read from Python to the C++ buffer.
+// Internally uses `readinto` for zero-copy read from Python to a buffer of
+// `bufsize` bytes; reads larger than the buffer are done directly into the
+// destination.
 class pyreadintobuf : public std::streambuf {
-protected:
-  PyObject *handle;
-  PyObject *method;
-  PyObject *mview;
-  char buffer[1];
-  std::streamsize bufsize;
-
 public:
-  pyreadintobuf(PyObject *handle);
+  static const size_t DEFAULT_BUFSIZE = 1 << 16;
+
+  pyreadintobuf(PyObject *handle, size_t bufsize = DEFAULT_BUFSIZE);
   ~pyreadintobuf();
 
+  // Return -1 if the file-like object raised an exception, which is left
+  // set for the caller to handle, or 0 otherwise.
+  int check() const;
+
 protected:
+  PyObject *handle;
+  PyObject *method;
+  std::vector<char> buffer;
+  bool failed;
+
   int underflow() override;
-  pyreadintobuf *setbuf(char *s, std::streamsize n) override;
+  std::streamsize xsgetn(char *s, std::streamsize n) override;
   std::streampos
   seekpos(std::streampos sp,
           std::ios_base::openmode which = std::ios_base::in |
                                           std::ios_base::out) override;
+
+private:
+  // Read up to `n` bytes into `s`, and return the number of bytes read,
+  // or -1 if an exception was raised.
+  Py_ssize_t readinto(char *s, Py_ssize_t n);
 };
@@ -1,25 +1,96 @@
+#include <algorithm>
+#include <cstring>
+
 #include "pywritebuf.h"
 
-pywritebuf::pywritebuf(PyObject *handle) : std::streambuf(), handle(handle) {
+pywritebuf::pywritebuf(PyObject *handle, size_t bufsize)
+    : std::streambuf(), handle(handle), buffer(std::max<size_t>(bufsize, 1)),
+      failed(false) {
   Py_INCREF(handle);
   method = PyUnicode_FromString("write");
-  mview = PyMemoryView_FromMemory(buffer, 1, PyBUF_READ);
+  setp(buffer.data(), buffer.data() + buffer.size());
 }
 
 pywritebuf::~pywritebuf() {
+  // errors can't be reported from here, callers should flush beforehand
+  if (!failed && (pptr() > pbase())) {
+    if (flush() != 0)
+      PyErr_Clear();
+  }
   Py_DECREF(handle);
-  Py_DECREF(method);
-  Py_DECREF(mview);
+  Py_XDECREF(method);
 }
 
-int pywritebuf::overflow(int c) {
-  PyObject *result;
-  if (c != EOF) {
-    buffer[0] = c;
-    result = PyObject_CallMethodObjArgs(handle, method, mview, NULL);
-    if (result == nullptr)
-      return EOF;
+bool pywritebuf::write(const char *s, Py_ssize_t n) {
+  // do not call the file-like object again after an exception was raised
+  if (failed || method == nullptr) {
+    failed = true;
+    return false;
+  }
+
+  while (n > 0) {
+    PyObject *mview =
+        PyMemoryView_FromMemory(const_cast<char *>(s), n, PyBUF_READ);
+    if (mview == nullptr) {
+      failed = true;
+      return false;
+    }
+    PyObject *result = PyObject_CallMethodObjArgs(handle, method, mview, NULL);
+    Py_DECREF(mview);
+    if (result == nullptr) {
+      failed = true;
+      return false;
+    }
+
+    // raw streams may write less than requested and return the number of
+    // bytes written, other streams write everything or return `None`
+    Py_ssize_t written = n;
+    if (PyLong_Check(result))
+      written = PyLong_AsSsize_t(result);
     Py_DECREF(result);
+    if ((written == -1) && PyErr_Occurred()) {
+      failed = true;
+      return false;
+    }
+    if ((written <= 0) || (written > n)) {
+      PyErr_SetString(PyExc_OSError,
+                      "invalid number of bytes returned by `write`");
+      failed = true;
+      return false;
+    }
+
+    s += written;
+    n -= written;
+  }
+  return true;
+}
+
+int pywritebuf::flush() {
+  bool ok = write(pbase(), pptr() - pbase());
+  setp(buffer.data(), buffer.data() + buffer.size());
+  return ok ? 0 : -1;
+}
+
+int pywritebuf::overflow(int c) {
+  if (flush() != 0)
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
   }
-  return c;
+  return traits_type::not_eof(c);
+}
+
+std::streamsize pywritebuf::xsputn(const char *s, std::streamsize n) {
+  // make room in the buffer if needed
+  if ((n > epptr() - pptr()) && (flush() != 0))
+    return 0;
+  // pass large blocks directly to the file-like object
+  if (n >= (std::streamsize)buffer.size())
+    return write(s, n) ? n : 0;
+  memcpy(pptr(), s, n * sizeof(char));
+  pbump(n);
+  return n;
 }
+
+int pywritebuf::sync() { return flush(); }
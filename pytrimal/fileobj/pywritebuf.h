@@ -1,18 +1,34 @@
 #include <Python.h>
 #include <streambuf>
+#include <vector>
 
 // Wrapper class that exposes a Python file-like object for writing operations.
+// Characters are collected in a buffer of `bufsize` bytes which is passed to
+// `write` once full or when the stream is flushed; writes larger than the
+// buffer are passed to `write` directly.
 class pywritebuf : public std::streambuf {
+public:
+  static const size_t DEFAULT_BUFSIZE = 1 << 16;
+
+  pywritebuf(PyObject *handle, size_t bufsize = DEFAULT_BUFSIZE);
+  ~pywritebuf();
+
+  // Write the buffered characters to the file-like object, and return -1
+  // if it raised an exception, which is left set for the caller to handle,
+  // or 0 otherwise.
+  int flush();
+
 private:
   PyObject *handle;
   PyObject *method;
-  PyObject *mview;
-  char buffer[1];
+  std::vector<char> buffer;
+  bool failed;
 
-public:
-  pywritebuf(PyObject *handle);
-  ~pywritebuf();
+  // Write `n` bytes from `s`, and return `false` if an exception was raised.
+  bool write(const char *s, Py_ssize_t n);
 
 protected:
   int overflow(int c) override;
+  std::streamsize xsputn(const char *s, std::streamsize n) override;
+  int sync() override;
 };
@@ -0,0 +1,53 @@
+#ifndef _PYTRIMAL_IMPL_ALPHABET
+#define _PYTRIMAL_IMPL_ALPHABET
+
+#include "Alignment/Alignment.h"
+#include "defines.h"
+
+namespace simd {
+
+// The alphabets of the alignments, for which the statistics encoding
+// symbols have specialized kernels.
+enum AlphabetType {
+  // detect the alphabet from the alignment when computing a statistic
+  AlphabetDetect = -1,
+  AlphabetAminoAcids = 0,
+  AlphabetNucleotides = 1,
+  AlphabetDegenerateNucleotides = 2,
+};
+
+// The indetermination symbol of each alphabet, known at compile time so
+// that the kernels specialized for an alphabet compare to a constant.
+struct AminoAcids {
+  static const char INDET = 'X';
+};
+
+// The degenerate nucleotides share the symbols of the nucleotides.
+struct Nucleotides {
+  static const char INDET = 'N';
+};
+
+// Get the alphabet of an alignment from its sequence type.
+static inline int alphabetType(Alignment &alig) {
+  const int type = alig.getAlignmentType();
+  if (type & SequenceTypes::AA)
+    return AlphabetAminoAcids;
+  if (type & SequenceTypes::DEG)
+    return AlphabetDegenerateNucleotides;
+  return AlphabetNucleotides;
+}
+
+// Get the alphabet of an alignment, unless it was already given.
+static inline int alphabetType(Alignment &alig, int alphabet) {
+  return alphabet == AlphabetDetect ? alphabetType(alig) : alphabet;
+}
+
+// Get the indetermination symbol of an alphabet.
+static inline char indeterminationSymbol(int alphabet) {
+  return alphabet == AlphabetAminoAcids ? AminoAcids::INDET
+                                        : Nucleotides::INDET;
+}
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _PYTRIMAL_IMPL_ARENA
+#define _PYTRIMAL_IMPL_ARENA
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace simd {
+
+// A region of memory from which the temporary buffers of the statistics
+// computed while trimming an alignment are allocated.
+//
+// Allocations are carved out of large blocks with a bump pointer, so that
+// the statistics of a trimming only perform a handful of calls to the
+// system allocator, rather than one per row or per worker buffer, which
+// contend with each other when many trimmings run concurrently. Nothing is
+// freed individually: all allocations are released at once with `release`
+// at the end of the trimming.
+//
+// Only buffers of trivial types can be allocated, as destructors are never
+// called.
+class Arena {
+public:
+  // The minimum size of the blocks requested to the system allocator.
+  static const size_t BLOCK_SIZE = 1 << 20;
+
+  Arena() : used(0) {}
+  ~Arena() { release(); }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // Allocate an uninitialized array of `n` elements, aligned to at least
+  // `alignment` bytes, which must be a power of two.
+  template <class T> T *allocate(size_t n, size_t alignment = alignof(T)) {
+    alignment = std::max<size_t>(alignment, alignof(T));
+    return static_cast<T *>(allocateBytes(n * sizeof(T), alignment));
+  }
+
+  // Release all the allocations at once, after which the arena can be
+  // used again.
+  void release() {
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto &block : blocks)
+      free(block.data);
+    blocks.clear();
+    used = 0;
+  }
+
+private:
+  struct Block {
+    char *data;
+    size_t size;
+  };
+
+  void *allocateBytes(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> guard(lock);
+    // never return the same address for empty allocations
+    size = std::max<size_t>(size, 1);
+    if (!blocks.empty()) {
+      const Block &block = blocks.back();
+      uintptr_t start = reinterpret_cast<uintptr_t>(block.data) + used;
+      size_t padding = (alignment - start % alignment) % alignment;
+      if (used + padding + size <= block.size) {
+        used += padding + size;
+        return block.data + (used - size);
+      }
+    }
+    // start a new block, large enough for the allocation once aligned
+    Block block;
+    // (compared without `std::max`, which would odr-use `BLOCK_SIZE`)
+    block.size =
+        (size + alignment > BLOCK_SIZE) ? (size + alignment) : BLOCK_SIZE;
+    block.data = static_cast<char *>(malloc(block.size));
+    if (block.data == nullptr)
+      throw std::bad_alloc();
+    blocks.push_back(block);
+    uintptr_t start = reinterpret_cast<uintptr_t>(block.data);
+    size_t padding = (alignment - start % alignment) % alignment;
+    used = padding + size;
+    return block.data + padding;
+  }
+
+  std::mutex lock;
+  // the blocks allocated so far, allocating from the last one
+  std::vector<Block> blocks;
+  // the number of bytes used in the last block
+  size_t used;
+};
+
+} // namespace simd
+
+#endif
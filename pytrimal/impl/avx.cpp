@@ -72,8 +72,12 @@ public:
 
   inline uint16_t sum() const {
     __m256i vsum = _mm256_sad_epu8(vector, _mm256_setzero_si256());
-    return _mm256_extract_epi8(vsum, 0) + _mm256_extract_epi8(vsum, 4) +
-           _mm256_extract_epi8(vsum, 8) + _mm256_extract_epi8(vsum, 12);
+    return _mm256_extract_epi16(vsum, 0) + _mm256_extract_epi16(vsum, 4) +
+           _mm256_extract_epi16(vsum, 8) + _mm256_extract_epi16(vsum, 12);
+  }
+
+  inline uint64_t mask() const {
+    return (uint32_t)_mm256_movemask_epi8(vector);
   }
 
   inline void clear() { vector = _mm256_setzero_si256(); }
@@ -82,28 +86,47 @@ public:
 namespace statistics {
 void AVXSimilarity::calculateMatrixIdentity() {
   StartTiming("void AVXSimilarity::calculateMatrixIdentity() ");
-  simd::calculateMatrixIdentity<AVXVector>(*this);
+  identity = simd::calculateMatrixIdentity<AVXVector>(*this, context);
 }
 
 bool AVXSimilarity::calculateVectors(bool cutByGap) {
   StartTiming("bool AVXSimilarity::calculateVectors(bool cutByGap) ");
-  return simd::calculateSimilarityVectors<AVXVector>(*this, cutByGap);
+  return simd::calculateSimilarityVectors<AVXVector>(*this, cutByGap,
+                                                     identity, context);
+}
+
+bool AVXSimilarity::applyWindow(int halfW) {
+  StartTiming("bool AVXSimilarity::applyWindow(int halfW) ");
+  return simd::applySimilarityWindow(*this, halfW);
 }
 
 void AVXGaps::CalculateVectors() {
   StartTiming("bool AVXGaps::CalculateVectors() ");
-  simd::calculateGapVectors<AVXVector>(*this);
+  simd::calculateGapVectors<AVXVector>(*this, context);
+}
+
+bool AVXGaps::applyWindow(int halfW) {
+  StartTiming("bool AVXGaps::applyWindow(int halfW) ");
+  return simd::applyGapWindow(*this, halfW, context);
 }
 } // namespace statistics
 
 void AVXCleaner::calculateSeqIdentity() {
   StartTiming("void AVXCleaner::calculateSeqIdentity() ");
-  simd::calculateSeqIdentity<AVXVector>(*this);
+  simd::calculateSeqIdentity<AVXVector>(*this, context);
 }
 
 bool AVXCleaner::calculateSpuriousVector(float overlap, float *spuriousVector) {
   StartTiming("bool AVXCleaner::calculateSpuriousVector(float overlap, float "
               "*spuriousVector) ");
   return simd::calculateSpuriousVector<AVXVector>(*this, overlap,
-                                                  spuriousVector);
+                                                  spuriousVector, context);
+}
+
+Alignment *AVXCleaner::getGreedyClustering(int clusters,
+                                           float identityThreshold) {
+  StartTiming("Alignment *AVXCleaner::getGreedyClustering(int clusters, "
+              "float identityThreshold) ");
+  return simd::getGreedyClustering<AVXVector>(*this, clusters,
+                                              identityThreshold, context);
 }
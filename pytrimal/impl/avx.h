@@ -5,25 +5,50 @@
 #include "Statistics/Gaps.h"
 #include "Statistics/Similarity.h"
 
+#include "clustering.h"
+#include "context.h"
+
 namespace statistics {
 class AVXSimilarity : public Similarity {
 public:
-  AVXSimilarity(Alignment *parentAlignment) : Similarity(parentAlignment) {}
+  AVXSimilarity(Alignment *parentAlignment,
+                const simd::Context &context = simd::Context())
+      : Similarity(parentAlignment), context(context) {}
   void calculateMatrixIdentity() override;
   bool calculateVectors(bool cutByGap) override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
+  // the identity matrix between the sequences, kept while the statistic
+  // is alive even if the alignment cache could not store it
+  simd::AlignmentCache::IdentityValues identity;
 };
 class AVXGaps : public Gaps {
 public:
-  AVXGaps(Alignment *parentAlignment) : Gaps(parentAlignment) {}
+  AVXGaps(Alignment *parentAlignment,
+          const simd::Context &context = simd::Context())
+      : Gaps(parentAlignment), context(context) {}
   void CalculateVectors() override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
 };
 } // namespace statistics
 
-class AVXCleaner : public Cleaner {
+class AVXCleaner : public Cleaner, public simd::GreedyClustering {
 public:
-  AVXCleaner(Alignment *parent) : Cleaner(parent) {}
+  AVXCleaner(Alignment *parent,
+             const simd::Context &context = simd::Context())
+      : Cleaner(parent), context(context) {}
   void calculateSeqIdentity() override;
   bool calculateSpuriousVector(float overlap, float *spuriousVector) override;
+  Alignment *getGreedyClustering(int clusters,
+                                 float identityThreshold) override;
+
+private:
+  simd::Context context;
 };
 
 #endif
\ No newline at end of file
@@ -2,13 +2,18 @@ from trimal.alignment cimport Alignment
 from trimal.cleaner cimport Cleaner
 from trimal.statistics cimport Similarity, Gaps
 
+from .context cimport Context
+
 
 cdef extern from "impl/avx.h" namespace "statistics" nogil:
     cdef cppclass AVXSimilarity(Similarity):
          AVXSimilarity(Alignment * parentAlignment)
+         AVXSimilarity(Alignment * parentAlignment, const Context& context)
     cdef cppclass AVXGaps(Gaps):
          AVXGaps(Alignment* parentAlignment)
+         AVXGaps(Alignment* parentAlignment, const Context& context)
 
 cdef extern from "impl/avx.h" nogil:
     cdef cppclass AVXCleaner(Cleaner):
         AVXCleaner(Alignment* parentAlignment)
+        AVXCleaner(Alignment* parentAlignment, const Context& context)
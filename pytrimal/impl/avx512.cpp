@@ -0,0 +1,151 @@
+#include <climits>
+#include <cstdint>
+#include <immintrin.h>
+
+#include "Alignment/Alignment.h"
+#include "InternalBenchmarker.h"
+#include "Statistics/Gaps.h"
+#include "Statistics/Manager.h"
+#include "Statistics/Similarity.h"
+#include "defines.h"
+#include "reportsystem.h"
+#include "utils.h"
+
+#include "avx512.h"
+#include "template.h"
+
+class AVX512Vector {
+private:
+  __m512i vector;
+  inline AVX512Vector(__m512i vec) : vector(vec) {}
+
+public:
+  const static size_t LANES = 64;
+  const static size_t SIZE = sizeof(__m512i);
+
+  inline AVX512Vector() : vector(_mm512_setzero_si512()) {}
+
+  inline static AVX512Vector duplicate(const uint8_t value) {
+    return AVX512Vector(_mm512_set1_epi8(value));
+  }
+
+  inline static AVX512Vector load(const uint8_t *data) {
+    return AVX512Vector(_mm512_load_si512((const void *)data));
+  }
+
+  inline static AVX512Vector loadu(const uint8_t *data) {
+    return AVX512Vector(_mm512_loadu_si512((const void *)data));
+  }
+
+  inline void store(uint8_t *data) const {
+    _mm512_store_si512((void *)data, vector);
+  }
+
+  inline void storeu(uint8_t *data) const {
+    _mm512_storeu_si512((void *)data, vector);
+  }
+
+  inline AVX512Vector &operator+=(const AVX512Vector &rhs) {
+    vector = _mm512_add_epi8(vector, rhs.vector);
+    return *this;
+  }
+
+  inline AVX512Vector operator==(const AVX512Vector &rhs) const {
+    return AVX512Vector(
+        _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(vector, rhs.vector)));
+  }
+
+  inline AVX512Vector operator&(const AVX512Vector &rhs) const {
+    return AVX512Vector(_mm512_and_si512(vector, rhs.vector));
+  }
+
+  inline AVX512Vector operator|(const AVX512Vector &rhs) const {
+    return AVX512Vector(_mm512_or_si512(vector, rhs.vector));
+  }
+
+  inline AVX512Vector operator!() const {
+    return AVX512Vector(_mm512_andnot_si512(vector, _mm512_set1_epi8(0xFF)));
+  }
+
+  inline AVX512Vector andnot(const AVX512Vector &rhs) const {
+    return AVX512Vector(_mm512_andnot_si512(rhs.vector, vector));
+  }
+
+  inline uint16_t sum() const {
+    __m512i vsum = _mm512_sad_epu8(vector, _mm512_setzero_si512());
+    return _mm512_reduce_add_epi64(vsum);
+  }
+
+  inline uint64_t mask() const { return _mm512_movepi8_mask(vector); }
+
+  inline void clear() { vector = _mm512_setzero_si512(); }
+
+  // Compare 64 characters at once into a mask register, without going
+  // through a vector of comparison results.
+  inline static uint64_t equalMask(const uint8_t *datai,
+                                   const uint8_t *dataj) {
+    return _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *)datai),
+                                  _mm512_loadu_si512((const void *)dataj));
+  }
+};
+
+namespace simd {
+namespace {
+// A vector spans a whole mask word, so the comparison can directly
+// produce the mask.
+template <>
+inline uint64_t equalMask<AVX512Vector>(const uint8_t *datai,
+                                        const uint8_t *dataj) {
+  return AVX512Vector::equalMask(datai, dataj);
+}
+} // namespace
+} // namespace simd
+
+namespace statistics {
+void AVX512Similarity::calculateMatrixIdentity() {
+  StartTiming("void AVX512Similarity::calculateMatrixIdentity() ");
+  identity = simd::calculateMatrixIdentity<AVX512Vector>(*this, context);
+}
+
+bool AVX512Similarity::calculateVectors(bool cutByGap) {
+  StartTiming("bool AVX512Similarity::calculateVectors(bool cutByGap) ");
+  return simd::calculateSimilarityVectors<AVX512Vector>(*this, cutByGap,
+                                                        identity, context);
+}
+
+bool AVX512Similarity::applyWindow(int halfW) {
+  StartTiming("bool AVX512Similarity::applyWindow(int halfW) ");
+  return simd::applySimilarityWindow(*this, halfW);
+}
+
+void AVX512Gaps::CalculateVectors() {
+  StartTiming("bool AVX512Gaps::CalculateVectors() ");
+  simd::calculateGapVectors<AVX512Vector>(*this, context);
+}
+
+bool AVX512Gaps::applyWindow(int halfW) {
+  StartTiming("bool AVX512Gaps::applyWindow(int halfW) ");
+  return simd::applyGapWindow(*this, halfW, context);
+}
+} // namespace statistics
+
+void AVX512Cleaner::calculateSeqIdentity() {
+  StartTiming("void AVX512Cleaner::calculateSeqIdentity() ");
+  simd::calculateSeqIdentity<AVX512Vector>(*this, context);
+}
+
+bool AVX512Cleaner::calculateSpuriousVector(float overlap,
+                                            float *spuriousVector) {
+  StartTiming("bool AVX512Cleaner::calculateSpuriousVector(float overlap, "
+              "float *spuriousVector) ");
+  return simd::calculateSpuriousVector<AVX512Vector>(*this, overlap,
+                                                     spuriousVector, context);
+}
+
+Alignment *AVX512Cleaner::getGreedyClustering(int clusters,
+                                              float identityThreshold) {
+  StartTiming("Alignment *AVX512Cleaner::getGreedyClustering(int clusters, "
+              "float identityThreshold) ");
+  return simd::getGreedyClustering<AVX512Vector>(*this, clusters,
+                                                 identityThreshold, context);
+}
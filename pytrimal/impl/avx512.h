@@ -0,0 +1,54 @@
+#ifndef _PYTRIMAL_IMPL_AVX512
+#define _PYTRIMAL_IMPL_AVX512
+
+#include "Cleaner.h"
+#include "Statistics/Gaps.h"
+#include "Statistics/Similarity.h"
+
+#include "clustering.h"
+#include "context.h"
+
+namespace statistics {
+class AVX512Similarity : public Similarity {
+public:
+  AVX512Similarity(Alignment *parentAlignment,
+                   const simd::Context &context = simd::Context())
+      : Similarity(parentAlignment), context(context) {}
+  void calculateMatrixIdentity() override;
+  bool calculateVectors(bool cutByGap) override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
+  // the identity matrix between the sequences, kept while the statistic
+  // is alive even if the alignment cache could not store it
+  simd::AlignmentCache::IdentityValues identity;
+};
+class AVX512Gaps : public Gaps {
+public:
+  AVX512Gaps(Alignment *parentAlignment,
+             const simd::Context &context = simd::Context())
+      : Gaps(parentAlignment), context(context) {}
+  void CalculateVectors() override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
+};
+} // namespace statistics
+
+class AVX512Cleaner : public Cleaner, public simd::GreedyClustering {
+public:
+  AVX512Cleaner(Alignment *parent,
+                const simd::Context &context = simd::Context())
+      : Cleaner(parent), context(context) {}
+  void calculateSeqIdentity() override;
+  bool calculateSpuriousVector(float overlap, float *spuriousVector) override;
+  Alignment *getGreedyClustering(int clusters,
+                                 float identityThreshold) override;
+
+private:
+  simd::Context context;
+};
+
+#endif
\ No newline at end of file
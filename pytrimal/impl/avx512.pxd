@@ -0,0 +1,19 @@
+from trimal.alignment cimport Alignment
+from trimal.cleaner cimport Cleaner
+from trimal.statistics cimport Similarity, Gaps
+
+from .context cimport Context
+
+
+cdef extern from "impl/avx512.h" namespace "statistics" nogil:
+    cdef cppclass AVX512Similarity(Similarity):
+         AVX512Similarity(Alignment * parentAlignment)
+         AVX512Similarity(Alignment * parentAlignment, const Context& context)
+    cdef cppclass AVX512Gaps(Gaps):
+         AVX512Gaps(Alignment* parentAlignment)
+         AVX512Gaps(Alignment* parentAlignment, const Context& context)
+
+cdef extern from "impl/avx512.h" nogil:
+    cdef cppclass AVX512Cleaner(Cleaner):
+        AVX512Cleaner(Alignment* parentAlignment)
+        AVX512Cleaner(Alignment* parentAlignment, const Context& context)
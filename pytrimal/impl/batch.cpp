@@ -0,0 +1,154 @@
+#include <string>
+
+#include "Alignment/Alignment.h"
+#include "Cleaner.h"
+#include "Statistics/Manager.h"
+#include "trimalManager.h"
+
+#include "batch.h"
+#include "clustering.h"
+#include "profile.h"
+
+namespace simd {
+
+// Copy the sequences and residues retained in a trimmed alignment to a
+// new alignment, so that it can be trimmed again.
+static Alignment *compactAlignment(const Alignment &trimmed) {
+  Alignment *compact = new Alignment();
+  compact->numberOfSequences = trimmed.numberOfSequences;
+  compact->numberOfResidues = trimmed.numberOfResidues;
+  compact->seqsName = new std::string[trimmed.numberOfSequences];
+  compact->sequences = new std::string[trimmed.numberOfSequences];
+
+  int x = 0;
+  for (int i = 0; i < trimmed.originalNumberOfSequences; i++) {
+    if ((trimmed.saveSequences != nullptr) && (trimmed.saveSequences[i] == -1))
+      continue;
+    std::string &sequence = compact->sequences[x];
+    sequence.reserve(trimmed.numberOfResidues);
+    for (int k = 0; k < trimmed.originalNumberOfResidues; k++) {
+      if ((trimmed.saveResidues == nullptr) || (trimmed.saveResidues[k] != -1))
+        sequence.push_back(trimmed.sequences[i][k]);
+    }
+    compact->seqsName[x++] = trimmed.seqsName[i];
+  }
+
+  // the residues were already checked when the original was created
+  if (compact->numberOfSequences == 0)
+    compact->numberOfResidues = 0;
+  if (compact->numberOfResidues > 0)
+    compact->fillMatrices(compact->numberOfSequences > 1, false);
+  compact->originalNumberOfSequences = compact->numberOfSequences;
+  compact->originalNumberOfResidues = compact->numberOfResidues;
+  return compact;
+}
+
+TrimTask::TrimTask()
+    : alignment(nullptr), compact(false), matrix(nullptr), backend(0),
+      trimmed(nullptr) {}
+
+TrimTask::~TrimTask() {
+  if (!compact)
+    delete alignment;
+  delete trimmed;
+}
+
+void TrimTask::run(SetupFunction setup) {
+  reports.start();
+  runManager(setup);
+  // release the buffers of the statistics all at once
+  context.arena->release();
+  reports.stop();
+}
+
+void TrimTask::runManager(SetupFunction setup) {
+  Profile *profile = context.profile.get();
+
+  // give the alignment to the manager, which only ever modifies the masks
+  // of the alignments sharing the input sequences
+  if (compact) {
+    ProfileTimer timer(profile, ProfileCopy, residueBytes(*alignment));
+    manager.origAlig = compactAlignment(*alignment);
+  } else {
+    manager.origAlig = alignment;
+  }
+  alignment = nullptr;
+  compact = false;
+
+  {
+    ProfileTimer timer(profile, ProfileSetup);
+    // setup computation of optimized statistics with SIMD
+    setup(backend, &manager, context);
+    // set flags
+    manager.set_window_size();
+    if (manager.blockSize != -1)
+      manager.origAlig->setBlockSize(manager.blockSize);
+    // set similarity matrix from argument or load a default one
+    if (matrix != nullptr) {
+      manager.origAlig->Statistics->setSimilarityMatrix(matrix);
+    } else if (!manager.create_or_use_similarity_matrix()) {
+      return;
+    }
+  }
+  // select the representative sequences with the greedy clustering of the
+  // backend if requested, or clean alignment
+  auto *clustering =
+      dynamic_cast<GreedyClustering *>(manager.origAlig->Cleaning);
+  const bool representatives =
+      (manager.clusters != -1) || (manager.maxIdentity != -1);
+  {
+    ProfileTimer timer(profile, ProfileCleaning);
+    if (context.greedyClustering && representatives &&
+        (clustering != nullptr) &&
+        (manager.clusters <= manager.origAlig->numberOfSequences)) {
+      manager.singleAlig = clustering->getGreedyClustering(
+          manager.clusters, manager.maxIdentity);
+    } else {
+      manager.clean_alignment();
+    }
+  }
+  if (reports.failed())
+    return;
+  // use original alignment as single alignment if needed
+  if (manager.singleAlig == nullptr) {
+    manager.singleAlig = manager.origAlig;
+    manager.origAlig = nullptr;
+  }
+  // take the trimmed alignment from the manager rather than copying it
+  trimmed = manager.singleAlig;
+  manager.singleAlig = nullptr;
+}
+
+TrimTask &TrimBatch::add() {
+  std::lock_guard<std::mutex> guard(lock);
+  tasks.emplace_back(new TrimTask());
+  return *tasks.back();
+}
+
+void TrimBatch::start(int threads, SetupFunction setup) {
+  auto job = [this, setup](size_t i) {
+    TrimTask *task;
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      task = tasks[i].get();
+    }
+    task->run(setup);
+  };
+  pool.reset(new WorkStealingPool(threads, job));
+}
+
+void TrimBatch::submit(size_t i) { pool->submit(i); }
+
+void TrimBatch::wait(size_t i) { pool->wait(i); }
+
+void TrimBatch::release(size_t i) {
+  std::unique_ptr<TrimTask> task;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    task.swap(tasks[i]);
+  }
+}
+
+void TrimBatch::stop() { pool.reset(); }
+
+} // namespace simd
@@ -0,0 +1,99 @@
+#ifndef _PYTRIMAL_IMPL_BATCH
+#define _PYTRIMAL_IMPL_BATCH
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Alignment/Alignment.h"
+#include "Statistics/similarityMatrix.h"
+#include "trimalManager.h"
+
+#include "context.h"
+#include "lease.h"
+#include "pool.h"
+#include "reports.h"
+
+namespace simd {
+
+// The function called to replace the statistics of the alignment of a
+// manager with the implementations of a SIMD backend.
+typedef void (*SetupFunction)(int backend, trimAlManager *manager,
+                              const Context &context);
+
+// The configuration, input and output of the trimming of one alignment.
+class TrimTask {
+public:
+  // the lease of the input sequences, if the alignment to trim shares
+  // them with the input; declared first so that it outlives the manager
+  std::shared_ptr<SequenceLease> lease;
+  // the manager, configured by the caller before running the task
+  trimAlManager manager;
+  // the options and data shared by the statistics of the alignment
+  Context context;
+  // the alignment to trim, owned by the task, or a trimmed alignment
+  // borrowed from the caller and compacted by `run` if `compact` is set
+  Alignment *alignment;
+  bool compact;
+  // an alternative similarity matrix, or `nullptr` to use the default one
+  statistics::similarityMatrix *matrix;
+  // the backend passed to the setup function
+  int backend;
+  // the trimmed alignment once the task is done, taken from the manager
+  // without copy, and owned by the task until taken by the caller
+  Alignment *trimmed;
+  // the reports emitted while running the task
+  ReportCapture reports;
+
+  TrimTask();
+  ~TrimTask();
+
+  TrimTask(const TrimTask &) = delete;
+  TrimTask &operator=(const TrimTask &) = delete;
+
+  // Trim the alignment on the current thread, capturing all reports, and
+  // using `setup` to configure the statistics for the task backend.
+  void run(SetupFunction setup);
+
+private:
+  // Run the manager, stopping at the first failure.
+  void runManager(SetupFunction setup);
+};
+
+// A batch of alignments trimmed in the background by a pool of threads.
+//
+// Tasks can be added while the workers are running, so that only a window
+// of the alignments to trim needs to be kept in memory at once.
+class TrimBatch {
+public:
+  // Add a new task at the end of the batch, to be configured by the caller
+  // before it is submitted.
+  TrimTask &add();
+  // Get the task `i`, which must not have been released.
+  inline TrimTask &task(size_t i) { return *tasks[i]; }
+  inline size_t size() const { return tasks.size(); }
+
+  // Start the pool of up to `threads` workers running the tasks.
+  void start(int threads, SetupFunction setup);
+  // Queue the task `i` for the workers. Must only be called after `start`.
+  void submit(size_t i);
+  // Block until task `i` is done. Must only be called after `submit(i)`.
+  void wait(size_t i);
+  // Destroy the task `i` once it is done and its result was taken.
+  void release(size_t i);
+  // Stop the workers once they are done with their current task, and
+  // join them.
+  void stop();
+
+private:
+  // guards `tasks` against the workers while tasks are added or released
+  std::mutex lock;
+  std::vector<std::unique_ptr<TrimTask>> tasks;
+  // destroyed first, so that the tasks outlive the workers
+  std::unique_ptr<WorkStealingPool> pool;
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,39 @@
+from libcpp cimport bool
+from libcpp.memory cimport shared_ptr
+
+from trimal.alignment cimport Alignment
+from trimal.manager cimport trimAlManager
+from trimal.similarity_matrix cimport similarityMatrix
+
+from .context cimport Context
+from .lease cimport SequenceLease
+from .reports cimport ReportCapture
+
+
+cdef extern from "impl/batch.h" namespace "simd" nogil:
+    ctypedef void (*SetupFunction)(int backend, trimAlManager* manager, const Context& context) noexcept nogil
+
+    cdef cppclass TrimTask:
+        trimAlManager manager
+        Context context
+        shared_ptr[SequenceLease] lease
+        Alignment* alignment
+        bool compact
+        similarityMatrix* matrix
+        int backend
+        Alignment* trimmed
+        ReportCapture reports
+
+        TrimTask()
+        void run(SetupFunction setup)
+
+    cdef cppclass TrimBatch:
+        TrimBatch()
+        TrimTask& add()
+        TrimTask& task(size_t i)
+        size_t size()
+        void start(int threads, SetupFunction setup) except +
+        void submit(size_t i)
+        void wait(size_t i)
+        void release(size_t i)
+        void stop()
@@ -0,0 +1,35 @@
+#ifndef _PYTRIMAL_IMPL_BITS
+#define _PYTRIMAL_IMPL_BITS
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace simd {
+
+// Number of columns stored in each word of a residue mask.
+const int MASK_BITS = 64;
+
+// Count the number of bits set in a 64-bit word.
+static inline uint32_t popcount(const uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(x);
+#else
+  uint64_t v = x - ((x >> 1) & 0x5555555555555555ULL);
+  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+  v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (uint32_t)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Collect the lowest bit of each of the 8 bytes of a word into the 8
+// lowest bits of the result.
+static inline uint64_t collect_bits(const uint64_t x) {
+  return ((x & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Alignment/Alignment.h"
+#include "InternalBenchmarker.h"
+#include "Statistics/Manager.h"
+#include "Statistics/Similarity.h"
+#include "defines.h"
+#include "reportsystem.h"
+#include "utils.h"
+
+#include "bits.h"
+#include "bitsliced.h"
+#include "context.h"
+#include "parallel.h"
+#include "tiling.h"
+
+namespace simd {
+
+// Compare the bit planes of `MASK_BITS` columns of two sequences, and
+// return a word with the bits set for the columns with equal symbols.
+template <int PLANES>
+inline uint64_t equalPlanes(const uint64_t *planesi, const uint64_t *planesj) {
+  uint64_t diff = 0;
+  for (int p = 0; p < PLANES; p++)
+    diff |= planesi[p] ^ planesj[p];
+  return ~diff;
+}
+
+// Count the identical positions (`sum`) and the positions where at least one
+// of the two sequences has a residue (`length`) in the mask words
+// `[begin, end)`, only considering the columns set in the `keep` mask if
+// one is given.
+template <int PLANES>
+inline void countPlanesIdentity(const uint64_t *planesi,
+                                const uint64_t *planesj,
+                                const uint64_t *residuesi,
+                                const uint64_t *residuesj, const uint64_t *keep,
+                                const int begin, const int end, uint32_t &sum,
+                                uint32_t &length) {
+  // the residue masks are zero past the last column, so there is no need
+  // for a tail loop when the last word is not full
+  for (int w = begin; w < end; w++) {
+    const uint64_t eq =
+        equalPlanes<PLANES>(&planesi[w * PLANES], &planesj[w * PLANES]);
+    uint64_t mask = residuesi[w] | residuesj[w];
+    if (keep != nullptr)
+      mask &= keep[w];
+    sum += popcount(eq & residuesi[w] & residuesj[w] & mask);
+    length += popcount(mask);
+  }
+}
+
+// Compute the identity counts of all pairs of sequences `(i, j)` with
+// `i < j`, calling `store(i, j, sum, length)` once all columns of a pair
+// have been processed; sequences with `skip(i)` are ignored.
+template <int PLANES, class Skip, class Store>
+inline void calculatePlanesIdentity(Alignment *alig, const Context &context,
+                                    const uint64_t *keep, Skip skip,
+                                    Store store) {
+  const int sequences = alig->originalNumberOfSequences;
+  const int residues = alig->originalNumberOfResidues;
+  int threads = context.threads;
+
+  // Get the bit planes and residue masks shared by all statistics
+  const ResidueMasks &masks = context.cache->residueMasks(*alig);
+  const BitPlanes &encoded = context.cache->bitPlanes(*alig);
+
+  // Split the alignment in tiles of sequences and columns sized so that
+  // the planes of a tile stay in cache while the other sequences are
+  // compared to them.
+  const Tile tile = tile_size(sequences, residues, 1, threads);
+  const int blocks = (sequences + tile.rows - 1) / tile.rows;
+  const int tileWords = (tile.columns + MASK_BITS - 1) / MASK_BITS;
+
+  // prepare the counters of each worker, with one row of counters
+  // for every sequence of a tile
+  if (threads > blocks)
+    threads = blocks;
+  if (threads < 1)
+    threads = 1;
+  const size_t counters = (size_t)tile.rows * sequences;
+  std::vector<uint32_t *> sums(threads);
+  std::vector<uint32_t *> lengths(threads);
+  for (int t = 0; t < threads; t++) {
+    sums[t] = context.arena->allocate<uint32_t>(counters);
+    lengths[t] = context.arena->allocate<uint32_t>(counters);
+  }
+
+  parallel_rows(blocks, threads, [&](int block, int worker) {
+    int i, j;
+
+    const int first = block * tile.rows;
+    const int last = std::min(first + tile.rows, sequences);
+
+    uint32_t *sum = sums[worker];
+    uint32_t *length = lengths[worker];
+    std::fill(sum, sum + counters, 0);
+    std::fill(length, length + counters, 0);
+
+    // compare the tile to every sequence one block of words at a time,
+    // so that each sequence is loaded once for the whole tile
+    for (int begin = 0; begin < masks.words; begin += tileWords) {
+      const int end = std::min(begin + tileWords, masks.words);
+      for (j = first + 1; j < sequences; j++) {
+        if (skip(j))
+          continue;
+        for (i = first; (i < last) && (i < j); i++) {
+          if (skip(i))
+            continue;
+          countPlanesIdentity<PLANES>(
+              encoded.sequencePlanes(i), encoded.sequencePlanes(j),
+              masks.residueMask(i), masks.residueMask(j), keep, begin, end,
+              sum[(i - first) * sequences + j],
+              length[(i - first) * sequences + j]);
+        }
+      }
+    }
+
+    for (i = first; i < last; i++) {
+      if (skip(i))
+        continue;
+      for (j = i + 1; j < sequences; j++) {
+        if (skip(j))
+          continue;
+        const int index = (i - first) * sequences + j;
+        store(i, j, sum[index], length[index]);
+      }
+    }
+  });
+}
+
+// Dispatch to the implementation unrolled for the number of planes of the
+// alignment, which is at most 8 since symbols are 8-bit characters.
+template <class Skip, class Store>
+inline void calculatePlanesIdentity(Alignment *alig, const Context &context,
+                                    const uint64_t *keep, Skip skip,
+                                    Store store) {
+  switch (context.cache->bitPlanes(*alig).planes) {
+  case 1:
+    return calculatePlanesIdentity<1>(alig, context, keep, skip, store);
+  case 2:
+    return calculatePlanesIdentity<2>(alig, context, keep, skip, store);
+  case 3:
+    return calculatePlanesIdentity<3>(alig, context, keep, skip, store);
+  case 4:
+    return calculatePlanesIdentity<4>(alig, context, keep, skip, store);
+  case 5:
+    return calculatePlanesIdentity<5>(alig, context, keep, skip, store);
+  case 6:
+    return calculatePlanesIdentity<6>(alig, context, keep, skip, store);
+  case 7:
+    return calculatePlanesIdentity<7>(alig, context, keep, skip, store);
+  default:
+    return calculatePlanesIdentity<8>(alig, context, keep, skip, store);
+  }
+}
+
+} // namespace simd
+
+namespace statistics {
+void BitslicedSimilarity::calculateMatrixIdentity() {
+  StartTiming("void BitslicedSimilarity::calculateMatrixIdentity() ");
+  simd::ProfileTimer timer(context.profile.get(), simd::ProfileIdentity,
+                           simd::residueBytes(*alig));
+
+  // abort if identity matrix computation was already done, possibly by
+  // a previous trimming of the same alignment
+  identity = context.cache->matrixIdentity(context.identityFormat);
+  if (identity)
+    return;
+
+  // Allocate memory for the upper triangle of the matrix identity
+  const int sequences = alig->originalNumberOfSequences;
+  auto values = std::make_shared<simd::IdentityMatrix>(
+      sequences, context.identityFormat);
+
+  // Calculate the value of matrix idn for columns j and i
+  simd::calculatePlanesIdentity(
+      alig, context, nullptr, [](int) { return false; },
+      [&](int i, int j, uint32_t sum, uint32_t length) {
+        values->store(i, j, (1.0F - ((float)sum / length)));
+      });
+
+  identity = context.cache->storeMatrixIdentity(std::move(values));
+}
+} // namespace statistics
+
+void BitslicedCleaner::calculateSeqIdentity() {
+  StartTiming("void BitslicedCleaner::calculateSeqIdentity() ");
+  simd::ProfileTimer timer(context.profile.get(), simd::ProfileIdentity,
+                           simd::residueBytes(*alig));
+
+  const int sequences = alig->originalNumberOfSequences;
+  const int residues = alig->originalNumberOfResidues;
+
+  // create identities matrix to store identities scores
+  alig->identities = new float *[sequences];
+  for (int i = 0; i < sequences; i++) {
+    if (alig->saveSequences[i] == -1)
+      continue;
+    alig->identities[i] = new float[sequences];
+    alig->identities[i][i] = 0;
+  }
+
+  // Reuse the identities computed by a previous trimming for the same
+  // sequences and residues, or compute and store them
+  std::vector<int> key = simd::seqIdentityKey(*alig);
+  if (auto cached = context.cache->seqIdentity(key)) {
+    simd::unpackSeqIdentity(*cached, *alig);
+  } else {
+    // create a mask of residues to keep
+    std::vector<uint64_t> keep((residues + simd::MASK_BITS - 1) /
+                                   simd::MASK_BITS,
+                               0);
+    for (int k = 0; k < residues; k++) {
+      if (alig->saveResidues[k] != -1)
+        keep[k / simd::MASK_BITS] |= 1ULL << (k % simd::MASK_BITS);
+    }
+
+    // For each seq, compute its identity score against the others in the
+    // MSA
+    simd::calculatePlanesIdentity(
+        alig, context, keep.data(),
+        [&](int i) { return alig->saveSequences[i] == -1; },
+        [&](int i, int j, uint32_t hit, uint32_t dst) {
+          // mark pairs without residues in common with a negative score,
+          // they will be reported once all workers are done
+          alig->identities[i][j] = alig->identities[j][i] =
+              (dst == 0) ? -1.0F : (float)hit / dst;
+        });
+
+    simd::storeSeqIdentity(*context.cache, std::move(key), *alig);
+  }
+
+  // report pairs without any residue in common from the main thread,
+  // in the same order as the sequential loop would have done
+  for (int i = 0; i < sequences; i++) {
+    if (alig->saveSequences[i] == -1)
+      continue;
+    for (int j = i + 1; j < sequences; j++) {
+      if (alig->saveSequences[j] == -1)
+        continue;
+      if (alig->identities[i][j] < 0.0F) {
+        debug.report(ErrorCode::NoResidueSequences,
+                     new std::string[2]{alig->seqsName[i], alig->seqsName[j]});
+        alig->identities[i][j] = alig->identities[j][i] = 0;
+      }
+    }
+  }
+}
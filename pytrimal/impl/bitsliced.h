@@ -0,0 +1,38 @@
+#ifndef _PYTRIMAL_IMPL_BITSLICED
+#define _PYTRIMAL_IMPL_BITSLICED
+
+#include "Cleaner.h"
+#include "Statistics/Gaps.h"
+#include "Statistics/Similarity.h"
+
+#include "context.h"
+#include "generic.h"
+
+// The bit-sliced backend only computes the pairwise identity statistics
+// differently, and uses the generic code for everything else.
+
+namespace statistics {
+class BitslicedSimilarity : public GenericSimilarity {
+public:
+  BitslicedSimilarity(Alignment *parentAlignment,
+                      const simd::Context &context = simd::Context())
+      : GenericSimilarity(parentAlignment, context) {}
+  void calculateMatrixIdentity() override;
+};
+class BitslicedGaps : public GenericGaps {
+public:
+  BitslicedGaps(Alignment *parentAlignment,
+                const simd::Context &context = simd::Context())
+      : GenericGaps(parentAlignment, context) {}
+};
+} // namespace statistics
+
+class BitslicedCleaner : public GenericCleaner {
+public:
+  BitslicedCleaner(Alignment *parent,
+                   const simd::Context &context = simd::Context())
+      : GenericCleaner(parent, context) {}
+  void calculateSeqIdentity() override;
+};
+
+#endif
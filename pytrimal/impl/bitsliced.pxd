@@ -0,0 +1,20 @@
+from trimal.alignment cimport Alignment
+from trimal.cleaner cimport Cleaner
+from trimal.statistics cimport Similarity, Gaps
+
+from .context cimport Context
+
+
+cdef extern from "impl/bitsliced.h" namespace "statistics" nogil:
+    cdef cppclass BitslicedSimilarity(Similarity):
+        BitslicedSimilarity(Alignment* parentAlignment)
+        BitslicedSimilarity(Alignment* parentAlignment, const Context& context)
+    cdef cppclass BitslicedGaps(Gaps):
+        BitslicedGaps(Alignment* parentAlignment)
+        BitslicedGaps(Alignment* parentAlignment, const Context& context)
+
+
+cdef extern from "impl/bitsliced.h" nogil:
+    cdef cppclass BitslicedCleaner(Cleaner):
+        BitslicedCleaner(Alignment* parentAlignment)
+        BitslicedCleaner(Alignment* parentAlignment, const Context& context)
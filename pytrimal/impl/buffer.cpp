@@ -0,0 +1,54 @@
+#include <cstddef>
+#include <string>
+
+#include "Alignment/Alignment.h"
+
+#include "buffer.h"
+
+namespace simd {
+
+// Whether any of the `n` characters of `s` is not a valid residue.
+static inline bool anyInvalid(const unsigned char *s, size_t n) {
+  unsigned char invalid = 0;
+  for (size_t k = 0; k < n; k++) {
+    // outside of '!'..'~', or a digit
+    invalid |= (unsigned char)(s[k] - 0x21) > (0x7E - 0x21);
+    invalid |= (unsigned char)(s[k] - '0') < 10;
+  }
+  return invalid != 0;
+}
+
+bool validResidues(const char *data, size_t size) {
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(data);
+  // check blocks of a constant size without an early exit, so that the
+  // inner loop is always vectorized, but stop at the first invalid block
+  const size_t block = 256;
+  size_t k = 0;
+  for (; k + block <= size; k += block) {
+    if (anyInvalid(s + k, block))
+      return false;
+  }
+  return !anyInvalid(s + k, size - k);
+}
+
+int copyResidues(Alignment &alig, const char *data, ptrdiff_t rowStride,
+                 ptrdiff_t columnStride) {
+  int invalid = -1;
+  const size_t residues = alig.numberOfResidues;
+  for (int i = 0; i < alig.numberOfSequences; i++) {
+    const char *row = data + i * rowStride;
+    std::string &sequence = alig.sequences[i];
+    if (columnStride == 1) {
+      sequence.assign(row, residues);
+    } else {
+      sequence.resize(residues);
+      for (size_t k = 0; k < residues; k++)
+        sequence[k] = row[k * columnStride];
+    }
+    if ((invalid == -1) && !validResidues(sequence.data(), residues))
+      invalid = i;
+  }
+  return invalid;
+}
+
+} // namespace simd
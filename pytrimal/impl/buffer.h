@@ -0,0 +1,32 @@
+#ifndef _PYTRIMAL_IMPL_BUFFER
+#define _PYTRIMAL_IMPL_BUFFER
+
+#include <cstddef>
+
+#include "Alignment/Alignment.h"
+
+namespace simd {
+
+// Whether all `size` characters of `data` are residues accepted by trimAl,
+// i.e. letters or punctuation marks in the C locale, which are exactly the
+// printable ASCII characters except space and digits.
+//
+// This only compares characters to constant ranges and accumulates the
+// results without branching, so that compilers can vectorize it.
+bool validResidues(const char *data, size_t size);
+
+// Copy a 2D buffer of characters to the sequences of `alig`, which must
+// already be allocated for `numberOfSequences` sequences, overwriting
+// them with `numberOfResidues` characters each. Consecutive sequences are
+// `rowStride` bytes apart in the buffer, and consecutive residues
+// `columnStride` bytes apart.
+//
+// Return the index of the first sequence containing a character rejected
+// by `validResidues`, or -1 if all sequences are valid. Safe to call
+// without the GIL.
+int copyResidues(Alignment &alig, const char *data, ptrdiff_t rowStride,
+                 ptrdiff_t columnStride);
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,6 @@
+from trimal.alignment cimport Alignment
+
+
+cdef extern from "impl/buffer.h" namespace "simd" nogil:
+    bint validResidues(const char* data, size_t size)
+    int copyResidues(Alignment& alig, const char* data, ptrdiff_t rowStride, ptrdiff_t columnStride) except +
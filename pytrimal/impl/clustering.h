@@ -0,0 +1,28 @@
+#ifndef _PYTRIMAL_IMPL_CLUSTERING
+#define _PYTRIMAL_IMPL_CLUSTERING
+
+#include "Alignment/Alignment.h"
+
+namespace simd {
+
+// The interface of the cleaners able to select representative sequences
+// by greedy clustering, comparing each sequence to the representatives
+// only, rather than from the full identity matrix like trimAl.
+//
+// The cleaners of the SIMD backends implement it in addition to `Cleaner`,
+// so that a trimming task can check whether the cleaner of an alignment
+// supports it with `dynamic_cast`.
+class GreedyClustering {
+public:
+  virtual ~GreedyClustering() {}
+
+  // Get an alignment with the representatives of `clusters` clusters, or
+  // of the clusters at `identityThreshold` if `clusters` is -1, like
+  // `Cleaner::getClustering`.
+  virtual Alignment *getGreedyClustering(int clusters,
+                                         float identityThreshold) = 0;
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compression.h"
+
+namespace simd {
+
+bool compressionSupported(int compression) {
+  switch (compression) {
+  case NoCompression:
+    return true;
+#ifdef HAS_ZLIB
+  case Gzip:
+    return true;
+#endif
+#ifdef HAS_ZSTD
+  case Zstd:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+int detectCompression(const char *data, size_t size) {
+  const unsigned char *magic = reinterpret_cast<const unsigned char *>(data);
+  if ((size >= 2) && (magic[0] == 0x1F) && (magic[1] == 0x8B))
+    return Gzip;
+  if ((size >= 4) && (magic[0] == 0x28) && (magic[1] == 0xB5) &&
+      (magic[2] == 0x2F) && (magic[3] == 0xFD))
+    return Zstd;
+  return NoCompression;
+}
+
+int detectFileCompression(const char *path) {
+  char magic[4];
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+    return -1;
+  size_t size = fread(magic, sizeof(char), sizeof(magic), file);
+  fclose(file);
+  return detectCompression(magic, size);
+}
+
+bool decompressFile(const char *path, int compression, std::string &output,
+                    std::string &error) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    error = "failed to open file";
+    return false;
+  }
+
+  // read the whole compressed file, which is much smaller than the
+  // decompressed alignment in most cases
+  std::string data;
+  std::vector<char> block(1 << 16);
+  size_t n;
+  while ((n = fread(block.data(), sizeof(char), block.size(), file)) > 0)
+    data.append(block.data(), n);
+  bool failed = ferror(file) != 0;
+  fclose(file);
+  if (failed) {
+    error = "failed to read file";
+    return false;
+  }
+
+  return decompressData(data.data(), data.size(), compression, output, error);
+}
+
+// Make room for at least one more block at the end of `output`.
+static inline void grow(std::string &output, size_t produced) {
+  if (produced == output.size())
+    output.resize(std::max<size_t>(output.size() * 2, 1 << 16));
+}
+
+#ifdef HAS_ZLIB
+static bool inflateData(const char *data, size_t size, std::string &output,
+                        std::string &error) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // decode gzip headers only
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+    error = "failed to initialize zlib";
+    return false;
+  }
+
+  // most alignments compress to a fourth of their size or less
+  size_t remaining = size;
+  size_t produced = 0;
+  output.resize(size * 4);
+
+  bool ok = true;
+  while (ok) {
+    // zlib counts bytes with `unsigned int`, so feed large inputs in chunks
+    if ((stream.avail_in == 0) && (remaining > 0)) {
+      size_t n = std::min<size_t>(remaining, UINT_MAX);
+      stream.next_in = (Bytef *)(data + (size - remaining));
+      stream.avail_in = n;
+      remaining -= n;
+    }
+    grow(output, produced);
+    size_t available = std::min<size_t>(output.size() - produced, UINT_MAX);
+    stream.next_out = (Bytef *)&output[produced];
+    stream.avail_out = available;
+
+    int status = inflate(&stream, Z_NO_FLUSH);
+    produced += available - stream.avail_out;
+    if (status == Z_STREAM_END) {
+      // stop at the end of the data, or decode the next gzip member
+      if ((stream.avail_in == 0) && (remaining == 0))
+        break;
+      ok = inflateReset(&stream) == Z_OK;
+    } else if ((status == Z_BUF_ERROR) && (stream.avail_in == 0) &&
+               (remaining == 0)) {
+      error = "unexpected end of gzip data";
+      ok = false;
+    } else if ((status != Z_OK) && (status != Z_BUF_ERROR)) {
+      error = (stream.msg != nullptr) ? stream.msg : "invalid gzip data";
+      ok = false;
+    }
+  }
+
+  inflateEnd(&stream);
+  output.resize(produced);
+  return ok;
+}
+#endif
+
+#ifdef HAS_ZSTD
+static bool decompressZstd(const char *data, size_t size, std::string &output,
+                           std::string &error) {
+  ZSTD_DCtx *context = ZSTD_createDCtx();
+  if (context == nullptr) {
+    error = "failed to initialize zstd";
+    return false;
+  }
+
+  // use the size recorded in the frame header if present, without trusting
+  // it for more than the initial allocation
+  unsigned long long expected = ZSTD_getFrameContentSize(data, size);
+  if ((expected == ZSTD_CONTENTSIZE_UNKNOWN) ||
+      (expected == ZSTD_CONTENTSIZE_ERROR))
+    expected = size * 4;
+  output.resize(std::min<unsigned long long>(expected, 1 << 30));
+
+  ZSTD_inBuffer input = {data, size, 0};
+  size_t produced = 0;
+  size_t status = 0;
+  bool ok = true;
+  while (true) {
+    grow(output, produced);
+    ZSTD_outBuffer out = {&output[produced], output.size() - produced, 0};
+    status = ZSTD_decompressStream(context, &out, &input);
+    produced += out.pos;
+    if (ZSTD_isError(status)) {
+      error = ZSTD_getErrorName(status);
+      ok = false;
+      break;
+    }
+    // stop once the input was consumed and the output was fully flushed
+    if ((input.pos == input.size) && (out.pos < out.size))
+      break;
+  }
+  if (ok && (status != 0)) {
+    error = "unexpected end of zstd data";
+    ok = false;
+  }
+
+  ZSTD_freeDCtx(context);
+  output.resize(produced);
+  return ok;
+}
+#endif
+
+bool decompressData(const char *data, size_t size, int compression,
+                    std::string &output, std::string &error) {
+  switch (compression) {
+  case NoCompression:
+    output.assign(data, size);
+    return true;
+#ifdef HAS_ZLIB
+  case Gzip:
+    return inflateData(data, size, output, error);
+#endif
+#ifdef HAS_ZSTD
+  case Zstd:
+    return decompressZstd(data, size, output, error);
+#endif
+  default:
+    error = "unsupported compression format";
+    return false;
+  }
+}
+
+CompressedWriteBuffer::CompressedWriteBuffer(std::streambuf *sink,
+                                             int compression, int level,
+                                             size_t bufsize)
+    : std::streambuf(), sink(sink), compression(compression), state(nullptr),
+      buffer(std::max<size_t>(bufsize, 1)),
+      output(std::max<size_t>(bufsize, 1)), failed(false), finished(false) {
+  switch (compression) {
+#ifdef HAS_ZLIB
+  case Gzip: {
+    z_stream *stream = new z_stream;
+    memset(stream, 0, sizeof(z_stream));
+    if (level < 0)
+      level = Z_DEFAULT_COMPRESSION;
+    // write gzip headers rather than zlib headers
+    if (deflateInit2(stream, level, Z_DEFLATED, 16 + MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) == Z_OK) {
+      state = stream;
+    } else {
+      delete stream;
+    }
+    break;
+  }
+#endif
+#ifdef HAS_ZSTD
+  case Zstd: {
+    ZSTD_CCtx *context = ZSTD_createCCtx();
+    if (context != nullptr && level >= 0)
+      ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, level);
+    state = context;
+    break;
+  }
+#endif
+  default:
+    break;
+  }
+
+  if (state == nullptr) {
+    error = "unsupported compression format";
+    failed = true;
+  }
+  setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+CompressedWriteBuffer::~CompressedWriteBuffer() {
+  switch (compression) {
+#ifdef HAS_ZLIB
+  case Gzip:
+    if (state != nullptr) {
+      deflateEnd(static_cast<z_stream *>(state));
+      delete static_cast<z_stream *>(state);
+    }
+    break;
+#endif
+#ifdef HAS_ZSTD
+  case Zstd:
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx *>(state));
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+bool CompressedWriteBuffer::drain(size_t size) {
+  if (size == 0)
+    return true;
+  if (sink->sputn(output.data(), size) != (std::streamsize)size) {
+    error = "failed to write compressed data";
+    failed = true;
+    return false;
+  }
+  return true;
+}
+
+bool CompressedWriteBuffer::compress(const char *data, size_t size, bool end) {
+  if (failed || finished)
+    return false;
+
+  switch (compression) {
+#ifdef HAS_ZLIB
+  case Gzip: {
+    z_stream *stream = static_cast<z_stream *>(state);
+    size_t remaining = size;
+    int status;
+    do {
+      // zlib counts bytes with `unsigned int`, so feed large inputs in chunks
+      if ((stream->avail_in == 0) && (remaining > 0)) {
+        size_t n = std::min<size_t>(remaining, UINT_MAX);
+        stream->next_in = (Bytef *)(data + (size - remaining));
+        stream->avail_in = n;
+        remaining -= n;
+      }
+      int flush = (end && (remaining == 0)) ? Z_FINISH : Z_NO_FLUSH;
+      stream->next_out = (Bytef *)output.data();
+      stream->avail_out = output.size();
+      status = deflate(stream, flush);
+      if (status == Z_STREAM_ERROR) {
+        error = "failed to compress data";
+        failed = true;
+        return false;
+      }
+      if (!drain(output.size() - stream->avail_out))
+        return false;
+    } while ((stream->avail_in > 0) || (remaining > 0) ||
+             (stream->avail_out == 0) || (end && (status != Z_STREAM_END)));
+    break;
+  }
+#endif
+#ifdef HAS_ZSTD
+  case Zstd: {
+    ZSTD_CCtx *context = static_cast<ZSTD_CCtx *>(state);
+    ZSTD_inBuffer input = {data, size, 0};
+    ZSTD_EndDirective directive = end ? ZSTD_e_end : ZSTD_e_continue;
+    size_t status;
+    do {
+      ZSTD_outBuffer out = {output.data(), output.size(), 0};
+      status = ZSTD_compressStream2(context, &out, &input, directive);
+      if (ZSTD_isError(status)) {
+        error = ZSTD_getErrorName(status);
+        failed = true;
+        return false;
+      }
+      if (!drain(out.pos))
+        return false;
+    } while (end ? (status != 0) : (input.pos < input.size));
+    break;
+  }
+#endif
+  default:
+    failed = true;
+    return false;
+  }
+
+  finished = end;
+  return true;
+}
+
+bool CompressedWriteBuffer::finish() {
+  bool ok = compress(pbase(), pptr() - pbase(), true);
+  setp(buffer.data(), buffer.data() + buffer.size());
+  return ok && (sink->pubsync() == 0);
+}
+
+int CompressedWriteBuffer::overflow(int c) {
+  bool ok = compress(pbase(), pptr() - pbase(), false);
+  setp(buffer.data(), buffer.data() + buffer.size());
+  if (!ok)
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize CompressedWriteBuffer::xsputn(const char *s,
+                                              std::streamsize n) {
+  // make room in the buffer if needed
+  if ((n > epptr() - pptr()) && traits_type::eq_int_type(
+                                    overflow(traits_type::eof()),
+                                    traits_type::eof()))
+    return 0;
+  // compress large blocks directly
+  if (n >= (std::streamsize)buffer.size())
+    return compress(s, n, false) ? n : 0;
+  memcpy(pptr(), s, n * sizeof(char));
+  pbump(n);
+  return n;
+}
+
+int CompressedWriteBuffer::sync() {
+  bool ok = compress(pbase(), pptr() - pbase(), false);
+  setp(buffer.data(), buffer.data() + buffer.size());
+  return ok ? 0 : -1;
+}
+
+} // namespace simd
@@ -0,0 +1,92 @@
+#ifndef _PYTRIMAL_IMPL_COMPRESSION
+#define _PYTRIMAL_IMPL_COMPRESSION
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace simd {
+
+// The compression formats of the files read and written by pytrimal.
+enum Compression { NoCompression = 0, Gzip = 1, Zstd = 2 };
+
+// Whether the extension was built with support for `compression`, which
+// depends on the libraries found when compiling it.
+bool compressionSupported(int compression);
+
+// Detect the compression format of a block of data from its magic bytes,
+// returning `NoCompression` if the data is not compressed.
+int detectCompression(const char *data, size_t size);
+
+// Detect the compression format of the file at `path` from its magic
+// bytes, or return -1 if the file can't be opened. Safe to call without
+// the GIL.
+int detectFileCompression(const char *path);
+
+// Decompress the whole content of the file at `path` into `output`. Return
+// `false` and store an error message in `error` if the file can't be read
+// or is not a valid compressed file. Safe to call without the GIL.
+bool decompressFile(const char *path, int compression, std::string &output,
+                    std::string &error);
+
+// Decompress a block of `size` bytes in memory into `output`, with the same
+// rules as `decompressFile`. Concatenated gzip members or Zstandard frames
+// are decompressed one after the other.
+bool decompressData(const char *data, size_t size, int compression,
+                    std::string &output, std::string &error);
+
+// A stream buffer compressing the characters written to it, and writing
+// the compressed data to another stream buffer.
+//
+// The compressed stream is only complete once `finish` has been called,
+// which must be done before the sink is closed. The sink is written in
+// large blocks, so when it is a `filebuf` the buffer can be used without
+// the GIL.
+class CompressedWriteBuffer : public std::streambuf {
+public:
+  static const size_t DEFAULT_BUFSIZE = 1 << 16;
+
+  // Create a new buffer writing to `sink`, which must outlive the buffer,
+  // with the given `compression` format and `level`, or the default level
+  // of the format if `level` is negative.
+  CompressedWriteBuffer(std::streambuf *sink, int compression, int level = -1,
+                        size_t bufsize = DEFAULT_BUFSIZE);
+  ~CompressedWriteBuffer();
+
+  CompressedWriteBuffer(const CompressedWriteBuffer &) = delete;
+  CompressedWriteBuffer &operator=(const CompressedWriteBuffer &) = delete;
+
+  // Compress the remaining characters and write the end of the compressed
+  // stream to the sink. Return `false` if any write failed, in which case
+  // `error` contains an error message.
+  bool finish();
+
+  // The message of the last compression error, if any.
+  std::string error;
+
+protected:
+  int overflow(int c) override;
+  std::streamsize xsputn(const char *s, std::streamsize n) override;
+  int sync() override;
+
+private:
+  // Compress `size` characters, ending the stream if `end` is set.
+  bool compress(const char *data, size_t size, bool end);
+  // Write the content of the output buffer to the sink.
+  bool drain(size_t size);
+
+  std::streambuf *sink;
+  int compression;
+  // the zlib or zstd compression state, kept opaque to avoid exposing the
+  // library headers to the Cython code
+  void *state;
+  std::vector<char> buffer;
+  std::vector<char> output;
+  bool failed;
+  bool finished;
+};
+
+} // namespace simd
+
+#endif
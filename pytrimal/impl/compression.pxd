@@ -0,0 +1,22 @@
+from libcpp cimport bool
+from libcpp.string cimport string
+
+from iostream cimport streambuf
+
+
+cdef extern from "impl/compression.h" namespace "simd" nogil:
+    enum Compression:
+        NoCompression
+        Gzip
+        Zstd
+
+    bool compressionSupported(int compression)
+    int detectCompression(const char* data, size_t size)
+    int detectFileCompression(const char* path)
+    bool decompressFile(const char* path, int compression, string& output, string& error) except +
+    bool decompressData(const char* data, size_t size, int compression, string& output, string& error) except +
+
+    cdef cppclass CompressedWriteBuffer(streambuf):
+        CompressedWriteBuffer(streambuf* sink, int compression, int level) except +
+        bool finish()
+        string error
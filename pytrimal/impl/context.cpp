@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <numeric>
+#include <utility>
+
+#include "Alignment/Alignment.h"
+#include "Statistics/similarityMatrix.h"
+#include "defines.h"
+
+#include "bits.h"
+#include "context.h"
+
+namespace simd {
+
+ResidueMasks::ResidueMasks(Alignment &alig)
+    : sequences(alig.originalNumberOfSequences),
+      residues(alig.originalNumberOfResidues),
+      words((alig.originalNumberOfResidues + MASK_BITS - 1) / MASK_BITS),
+      residueBits((size_t)sequences * words, 0) {
+
+  // Depending on alignment type, indetermination symbol will be one or other
+  const char indet = indeterminationSymbol(alphabetType(alig));
+
+  for (int i = 0; i < sequences; i++) {
+    const char *data = alig.sequences[i].data();
+    uint64_t *residueRow = &residueBits[(size_t)i * words];
+    for (int k = 0; k < residues; k++) {
+      const uint64_t bit = 1ULL << (k % MASK_BITS);
+      if (data[k] != '-' && data[k] != indet)
+        residueRow[k / MASK_BITS] |= bit;
+    }
+  }
+}
+
+BitPlanes::BitPlanes(Alignment &alig)
+    : sequences(alig.originalNumberOfSequences),
+      residues(alig.originalNumberOfResidues),
+      words((alig.originalNumberOfResidues + MASK_BITS - 1) / MASK_BITS),
+      planes(1) {
+
+  // Depending on alignment type, indetermination symbol will be one or other
+  const char indet = indeterminationSymbol(alphabetType(alig));
+
+  // number the residue symbols in order of appearance
+  int codes[UCHAR_MAX + 1];
+  int symbols = 0;
+  for (int c = 0; c <= UCHAR_MAX; c++)
+    codes[c] = -1;
+  for (int i = 0; i < sequences; i++) {
+    const unsigned char *data =
+        reinterpret_cast<const unsigned char *>(alig.sequences[i].data());
+    for (int k = 0; k < residues; k++) {
+      if ((codes[data[k]] == -1) && (data[k] != '-') && (data[k] != indet))
+        codes[data[k]] = symbols++;
+    }
+  }
+  while ((1 << planes) < symbols)
+    planes++;
+
+  // encode the sequences
+  bits.assign((size_t)sequences * words * planes, 0);
+  for (int i = 0; i < sequences; i++) {
+    const unsigned char *data =
+        reinterpret_cast<const unsigned char *>(alig.sequences[i].data());
+    uint64_t *row = &bits[(size_t)i * words * planes];
+    for (int k = 0; k < residues; k++) {
+      const int code = codes[data[k]];
+      if (code <= 0)
+        continue;
+      uint64_t *word = &row[(size_t)(k / MASK_BITS) * planes];
+      for (int p = 0; p < planes; p++)
+        word[p] |= (uint64_t)((code >> p) & 1) << (k % MASK_BITS);
+    }
+  }
+}
+
+ResidueColumns::ResidueColumns(Alignment &alig)
+    : sequences(alig.originalNumberOfSequences),
+      residues(alig.originalNumberOfResidues),
+      stride(((size_t)alig.originalNumberOfSequences + COLUMN_ALIGNMENT - 1) &
+             ~(COLUMN_ALIGNMENT - 1)),
+      data(nullptr) {
+
+  // allocate at least one block so that the buffer is never empty
+  void *memptr = nullptr;
+  const size_t size =
+      std::max<size_t>((size_t)residues * stride, COLUMN_ALIGNMENT);
+  if (posix_memalign(&memptr, COLUMN_ALIGNMENT, size) != 0)
+    throw std::bad_alloc();
+  data = static_cast<char *>(memptr);
+
+  // transpose the sequences by blocks of columns, so that the rows being
+  // read and the columns being written all stay in cache
+  const int block = COLUMN_ALIGNMENT;
+  for (int first = 0; first < residues; first += block) {
+    const int last = std::min(first + block, residues);
+    for (int i = 0; i < sequences; i++) {
+      const char *row = alig.sequences[i].data();
+      for (int k = first; k < last; k++)
+        data[(size_t)k * stride + i] = row[k];
+    }
+  }
+
+  // pad the columns with gaps
+  for (int k = 0; k < residues; k++)
+    for (size_t i = sequences; i < stride; i++)
+      data[(size_t)k * stride + i] = '-';
+}
+
+ResidueColumns::~ResidueColumns() { free(data); }
+
+const ResidueMasks &AlignmentCache::residueMasks(Alignment &alig) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (!masks)
+    masks.reset(new ResidueMasks(alig));
+  return *masks;
+}
+
+const BitPlanes &AlignmentCache::bitPlanes(Alignment &alig) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (!encoded)
+    encoded.reset(new BitPlanes(alig));
+  return *encoded;
+}
+
+const ResidueColumns &AlignmentCache::residueColumns(Alignment &alig) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (!columns)
+    columns.reset(new ResidueColumns(alig));
+  return *columns;
+}
+
+// Find the values stored for `key`, or return `nullptr`, marking them as
+// the most recently used values.
+std::shared_ptr<const void> AlignmentCache::find(int kind,
+                                                 const std::vector<int> &key) {
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if ((it->kind == kind) && (it->key == key)) {
+      entries.splice(entries.end(), entries, it);
+      return it->values;
+    }
+  }
+  return nullptr;
+}
+
+// Store `values` unless `key` was already stored, discarding the least
+// recently used values until they fit in the cache, and return the stored
+// values. Values larger than the whole cache are returned without being
+// stored.
+std::shared_ptr<const void>
+AlignmentCache::insert(int kind, std::vector<int> key,
+                       std::shared_ptr<const void> values, size_t bytes) {
+  if (auto stored = find(kind, key))
+    return stored;
+  bytes += key.size() * sizeof(int);
+  if (!accepts(bytes))
+    return values;
+  while (used + bytes > capacity) {
+    used -= entries.front().bytes;
+    entries.pop_front();
+  }
+  entries.push_back(Entry{kind, std::move(key), values, bytes});
+  used += bytes;
+  return values;
+}
+
+AlignmentCache::IdentityValues AlignmentCache::matrixIdentity(int format) {
+  std::lock_guard<std::mutex> guard(lock);
+  return std::static_pointer_cast<const IdentityMatrix>(
+      find(KindMatrixIdentity, std::vector<int>{format}));
+}
+
+AlignmentCache::IdentityValues
+AlignmentCache::storeMatrixIdentity(IdentityValues values) {
+  std::lock_guard<std::mutex> guard(lock);
+  const size_t bytes = values->bytes();
+  std::vector<int> key{values->format()};
+  return std::static_pointer_cast<const IdentityMatrix>(
+      insert(KindMatrixIdentity, std::move(key), std::move(values), bytes));
+}
+
+AlignmentCache::IntValues
+AlignmentCache::gapsInColumn(const std::vector<int> &key) {
+  std::lock_guard<std::mutex> guard(lock);
+  return std::static_pointer_cast<const std::vector<int>>(
+      find(KindGapsInColumn, key));
+}
+
+void AlignmentCache::storeGapsInColumn(std::vector<int> key,
+                                       std::vector<int> values) {
+  std::lock_guard<std::mutex> guard(lock);
+  const size_t bytes = values.size() * sizeof(int);
+  insert(KindGapsInColumn, std::move(key),
+         std::make_shared<const std::vector<int>>(std::move(values)), bytes);
+}
+
+AlignmentCache::FloatValues
+AlignmentCache::similarityVector(const std::vector<int> &key) {
+  std::lock_guard<std::mutex> guard(lock);
+  return std::static_pointer_cast<const std::vector<float>>(
+      find(KindSimilarityVector, key));
+}
+
+void AlignmentCache::storeSimilarityVector(std::vector<int> key,
+                                           std::vector<float> values) {
+  std::lock_guard<std::mutex> guard(lock);
+  const size_t bytes = values.size() * sizeof(float);
+  insert(KindSimilarityVector, std::move(key),
+         std::make_shared<const std::vector<float>>(std::move(values)), bytes);
+}
+
+AlignmentCache::IdentityValues
+AlignmentCache::seqIdentity(const std::vector<int> &key) {
+  std::lock_guard<std::mutex> guard(lock);
+  return std::static_pointer_cast<const IdentityMatrix>(
+      find(KindSeqIdentity, key));
+}
+
+void AlignmentCache::storeSeqIdentity(std::vector<int> key,
+                                      IdentityValues values) {
+  std::lock_guard<std::mutex> guard(lock);
+  const size_t bytes = values->bytes();
+  insert(KindSeqIdentity, std::move(key), std::move(values), bytes);
+}
+
+void storeSeqIdentity(AlignmentCache &cache, std::vector<int> key,
+                      const Alignment &alig) {
+  const int n = alig.originalNumberOfSequences;
+  if (!cache.accepts(sizeof(float) * (size_t)n * (n - 1) / 2))
+    return;
+
+  auto values = std::make_shared<IdentityMatrix>(n, IdentityFloat32);
+  for (int i = 0; i < n; i++) {
+    if (alig.saveSequences[i] == -1)
+      continue;
+    for (int j = i + 1; j < n; j++) {
+      if (alig.saveSequences[j] != -1)
+        values->store(i, j, alig.identities[i][j]);
+    }
+  }
+  cache.storeSeqIdentity(std::move(key), std::move(values));
+}
+
+void unpackSeqIdentity(const IdentityMatrix &values, Alignment &alig) {
+  const int n = alig.originalNumberOfSequences;
+  for (int i = 0; i < n; i++) {
+    if (alig.saveSequences[i] == -1)
+      continue;
+    for (int j = i + 1; j < n; j++) {
+      if (alig.saveSequences[j] != -1)
+        alig.identities[i][j] = alig.identities[j][i] = values.load(i, j);
+    }
+  }
+}
+
+std::vector<int> seqIdentityKey(const Alignment &alig) {
+  std::vector<int> key(alig.saveSequences,
+                       alig.saveSequences + alig.originalNumberOfSequences);
+  key.insert(key.end(), alig.saveResidues,
+             alig.saveResidues + alig.originalNumberOfResidues);
+  return key;
+}
+
+std::vector<int>
+similarityKey(const statistics::similarityMatrix &matrix,
+              const std::vector<int> &columns, int format, int samples) {
+  const int letters = 'Z' - 'A' + 1;
+  const int positions = matrix.numPositions;
+  std::vector<int> key(3 + letters + positions * positions);
+  key[0] = format;
+  key[1] = samples;
+  key[2] = positions;
+  std::copy(matrix.vhash, matrix.vhash + letters, &key[3]);
+  for (int a = 0; a < positions; a++)
+    memcpy(&key[3 + letters + a * positions], matrix.distMat[a],
+           sizeof(float) * positions);
+  key.insert(key.end(), columns.begin(), columns.end());
+  return key;
+}
+
+// The seed of the generator used to sample sequences in the similarity
+// statistic, fixed so that the sample only depends on the alignment size.
+const uint64_t SAMPLING_SEED = 0x9E3779B97F4A7C15ULL;
+
+// The sequences are drawn with a partial Fisher-Yates shuffle driven by a
+// SplitMix64 generator rather than `std::shuffle`, whose results depend on
+// the standard library, so that the sample is the same on all platforms.
+std::vector<int> sampleSequences(int sequences, int samples) {
+  std::vector<int> indices(sequences);
+  std::iota(indices.begin(), indices.end(), 0);
+  if ((samples <= 0) || (samples >= sequences))
+    return indices;
+
+  uint64_t state = SAMPLING_SEED;
+  for (int i = 0; i < samples; i++) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    // the modulo bias is negligible for alignment sizes
+    const int j = i + (int)(z % (uint64_t)(sequences - i));
+    std::swap(indices[i], indices[j]);
+  }
+  indices.resize(samples);
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+uint64_t residueBytes(const Alignment &alig) {
+  return (uint64_t)alig.originalNumberOfSequences *
+         alig.originalNumberOfResidues;
+}
+
+} // namespace simd
@@ -0,0 +1,258 @@
+#ifndef _PYTRIMAL_IMPL_CONTEXT
+#define _PYTRIMAL_IMPL_CONTEXT
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Alignment/Alignment.h"
+
+#include "alphabet.h"
+#include "arena.h"
+#include "identity.h"
+#include "profile.h"
+
+namespace statistics {
+class similarityMatrix;
+}
+
+namespace simd {
+
+// Alignment of the columns of `ResidueColumns`, enough for the largest
+// vectors supported by the backends.
+const size_t COLUMN_ALIGNMENT = 64;
+
+// Per-sequence bitsets with one bit per column of an alignment, marking
+// the residues (neither gap nor indetermination).
+class ResidueMasks {
+public:
+  int sequences;
+  int residues;
+  // number of 64-bit words used for each sequence
+  int words;
+
+  explicit ResidueMasks(Alignment &alig);
+
+  inline const uint64_t *residueMask(int i) const {
+    return &residueBits[(size_t)i * words];
+  }
+
+private:
+  std::vector<uint64_t> residueBits;
+};
+
+// Per-sequence bit planes encoding the residues of an alignment, where
+// the symbols are numbered densely so that plane `p` of a sequence stores
+// the bit `p` of the symbol code of each column. Two residues are equal
+// if and only if all their planes are equal; gaps and indeterminations
+// are encoded as zero, and must be filtered out with the residue masks.
+class BitPlanes {
+public:
+  int sequences;
+  int residues;
+  // number of 64-bit words used for each sequence in every plane
+  int words;
+  // number of bit planes, enough to number all distinct residues
+  int planes;
+
+  explicit BitPlanes(Alignment &alig);
+
+  // Get the planes of sequence `i`, with the `planes` words of each
+  // group of `MASK_BITS` columns stored contiguously.
+  inline const uint64_t *sequencePlanes(int i) const {
+    return &bits[(size_t)i * words * planes];
+  }
+
+private:
+  std::vector<uint64_t> bits;
+};
+
+// A copy of the residues of an alignment stored in column-major order, so
+// that the characters of a column are contiguous. Each column is padded to
+// a multiple of `COLUMN_ALIGNMENT` bytes, and starts on an address aligned
+// to `COLUMN_ALIGNMENT` bytes.
+class ResidueColumns {
+public:
+  int sequences;
+  int residues;
+  // number of bytes between the start of two consecutive columns
+  size_t stride;
+
+  explicit ResidueColumns(Alignment &alig);
+  ~ResidueColumns();
+
+  ResidueColumns(const ResidueColumns &) = delete;
+  ResidueColumns &operator=(const ResidueColumns &) = delete;
+
+  inline const char *column(int k) const { return &data[(size_t)k * stride]; }
+
+private:
+  char *data;
+};
+
+// Default number of bytes of statistics kept by `AlignmentCache`, the
+// least recently used statistics being discarded first once it is full.
+const size_t CACHE_CAPACITY = (size_t)256 * 1024 * 1024;
+
+// Data derived from the content of an alignment, computed lazily and
+// shared by all the statistics computed on that alignment.
+//
+// The cache also keeps the results of the costliest statistics, so that
+// trimming the same alignment again, e.g. with different thresholds, only
+// computes the statistics whose parameters changed. The results are keyed
+// by the parameters they depend on, such as the sequences and residues
+// retained, or the content of the similarity matrix, and are independent
+// of the backend since all backends compute exactly the same values.
+// They take at most `capacity` bytes in total, so a result larger than
+// that is never stored, and is released once the trimming is done.
+class AlignmentCache {
+public:
+  typedef std::shared_ptr<const std::vector<int>> IntValues;
+  typedef std::shared_ptr<const std::vector<float>> FloatValues;
+  typedef std::shared_ptr<const IdentityMatrix> IdentityValues;
+
+  explicit AlignmentCache(size_t capacity = CACHE_CAPACITY)
+      : capacity(capacity), used(0) {}
+
+  // Get the residue masks of `alig`, building them on first access.
+  const ResidueMasks &residueMasks(Alignment &alig);
+  // Get the bit planes of `alig`, building them on first access.
+  const BitPlanes &bitPlanes(Alignment &alig);
+  // Get the residues of `alig` in column-major order, copying them on
+  // first access.
+  const ResidueColumns &residueColumns(Alignment &alig);
+
+  // Check whether a statistic of `bytes` bytes can be stored at all, to
+  // avoid building a copy of the statistic that would be discarded.
+  bool accepts(size_t bytes) const { return bytes <= capacity; }
+
+  // Get the identity matrix between all sequences, used by the similarity
+  // statistics, encoded with the given format, or `nullptr` if it was not
+  // stored yet.
+  IdentityValues matrixIdentity(int format);
+  // Store an identity matrix, unless one was already stored with the same
+  // format, and return the stored matrix.
+  IdentityValues storeMatrixIdentity(IdentityValues values);
+  // Get the number of gaps per column for the given retained sequences.
+  IntValues gapsInColumn(const std::vector<int> &key);
+  void storeGapsInColumn(std::vector<int> key, std::vector<int> values);
+  // Get the similarity of each column for the given similarity matrix
+  // and gap cutoff parameters.
+  FloatValues similarityVector(const std::vector<int> &key);
+  void storeSimilarityVector(std::vector<int> key, std::vector<float> values);
+  // Get the identity between the given retained sequences, computed on
+  // the given retained residues, stored in single precision so that the
+  // values are exactly those computed.
+  IdentityValues seqIdentity(const std::vector<int> &key);
+  void storeSeqIdentity(std::vector<int> key, IdentityValues values);
+
+private:
+  // The statistics stored in the cache.
+  enum Kind {
+    KindMatrixIdentity,
+    KindGapsInColumn,
+    KindSimilarityVector,
+    KindSeqIdentity,
+  };
+
+  // The values of a statistic, and the parameters they were computed with.
+  struct Entry {
+    int kind;
+    std::vector<int> key;
+    std::shared_ptr<const void> values;
+    size_t bytes;
+  };
+
+  std::shared_ptr<const void> find(int kind, const std::vector<int> &key);
+  std::shared_ptr<const void> insert(int kind, std::vector<int> key,
+                                     std::shared_ptr<const void> values,
+                                     size_t bytes);
+
+  std::mutex lock;
+  std::unique_ptr<ResidueMasks> masks;
+  std::unique_ptr<BitPlanes> encoded;
+  std::unique_ptr<ResidueColumns> columns;
+  size_t capacity;
+  // number of bytes taken by the stored statistics
+  size_t used;
+  // the stored statistics, from the least to the most recently used
+  std::list<Entry> entries;
+};
+
+// Store the identities between the retained sequences of `alig` in `cache`
+// as a packed matrix, unless the matrix would not fit in the cache.
+void storeSeqIdentity(AlignmentCache &cache, std::vector<int> key,
+                      const Alignment &alig);
+
+// Copy the identities stored by `storeSeqIdentity` to the rows of the
+// identity matrix of `alig`, which must already be allocated.
+void unpackSeqIdentity(const IdentityMatrix &values, Alignment &alig);
+
+// Build the key of the sequence identities cached for an alignment, made
+// of the sequences and residues it retains.
+std::vector<int> seqIdentityKey(const Alignment &alig);
+
+// Build the key of the similarity of the columns cached for an alignment,
+// made of the format of the identity matrix, of the number of sequences
+// sampled, of the content of the similarity matrix, and of the columns for
+// which the similarity is computed rather than cut by gaps.
+std::vector<int> similarityKey(const statistics::similarityMatrix &matrix,
+                               const std::vector<int> &columns, int format,
+                               int samples);
+
+// Select `samples` sequences out of `sequences` uniformly without
+// replacement, or all sequences if `samples` is zero or not smaller than
+// `sequences`, returning their indices in increasing order.
+std::vector<int> sampleSequences(int sequences, int samples);
+
+// The number of residues of an alignment, recorded in a profile as the
+// number of bytes read by the stages computing its statistics.
+uint64_t residueBytes(const Alignment &alig);
+
+// The statistics used by a trimmer, for which the backend objects are
+// created when preparing the alignment, the others being computed by trimAl
+// only if they are ever needed.
+enum StatisticFlags {
+  StatisticGaps = 1,
+  StatisticSimilarity = 2,
+  StatisticCleaning = 4,
+  StatisticAll = StatisticGaps | StatisticSimilarity | StatisticCleaning,
+};
+
+// The options and shared data passed to the statistics backends.
+//
+// Copies of a context share the same cache and arena, so the buffers
+// allocated by all the statistics of a trimming are released together.
+struct Context {
+  int threads;
+  // the `IdentityFormat` of the identity matrix of the similarity statistics
+  int identityFormat;
+  // the number of sequences sampled to estimate the similarity statistics,
+  // or zero to use the pairs of all sequences
+  int similaritySample;
+  // whether to select representative sequences by greedy clustering rather
+  // than from the full identity matrix
+  bool greedyClustering;
+  // the `AlphabetType` of the alignment, selecting the specialized kernels
+  int alphabet;
+  // the `StatisticFlags` of the statistics used by the trimmer
+  int statistics;
+  std::shared_ptr<AlignmentCache> cache;
+  std::shared_ptr<Arena> arena;
+  // the profile recording the time spent in each stage, or `nullptr`
+  std::shared_ptr<Profile> profile;
+
+  Context()
+      : threads(1), identityFormat(IdentityFloat32), similaritySample(0),
+        greedyClustering(false), alphabet(AlphabetDetect),
+        statistics(StatisticAll), cache(std::make_shared<AlignmentCache>()),
+        arena(std::make_shared<Arena>()) {}
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,38 @@
+from libcpp.memory cimport shared_ptr
+
+cimport trimal.alignment
+
+from .profile cimport Profile
+
+
+cdef extern from "impl/alphabet.h" namespace "simd" nogil:
+    int alphabetType(trimal.alignment.Alignment& alig)
+
+
+cdef extern from "impl/context.h" namespace "simd" nogil:
+    cdef enum StatisticFlags:
+        StatisticGaps
+        StatisticSimilarity
+        StatisticCleaning
+        StatisticAll
+
+    cdef cppclass ResidueColumns:
+        int sequences
+        int residues
+        size_t stride
+        const char* column(int k)
+
+    cdef cppclass AlignmentCache:
+        AlignmentCache()
+        const ResidueColumns& residueColumns(trimal.alignment.Alignment& alig) except +
+
+    cdef cppclass Context:
+        int threads
+        int identityFormat
+        int similaritySample
+        bint greedyClustering
+        int alphabet
+        int statistics
+        shared_ptr[AlignmentCache] cache
+        shared_ptr[Profile] profile
+        Context()
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Alignment/Alignment.h"
+
+#include "fasta.h"
+
+namespace simd {
+
+static inline bool isBlank(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') ||
+         (c == '\v') || (c == '\f');
+}
+
+// Find the end of the line starting at `line`, excluding the newline.
+static inline const char *lineEnd(const char *line, const char *end) {
+  const char *newline =
+      static_cast<const char *>(memchr(line, '\n', end - line));
+  return (newline == nullptr) ? end : newline;
+}
+
+// Append the characters of a sequence line to `sequence`, without the
+// whitespace characters.
+static inline void appendLine(std::string &sequence, const char *line,
+                              const char *end) {
+  // trailing carriage returns are the only blanks found in most files,
+  // so check for other blanks before copying character by character
+  while ((end > line) && isBlank(end[-1]))
+    end--;
+  const char *blank = line;
+  while ((blank < end) && !isBlank(*blank))
+    blank++;
+  sequence.append(line, blank - line);
+  for (const char *c = blank; c < end; c++) {
+    if (!isBlank(*c))
+      sequence.push_back(*c);
+  }
+}
+
+Alignment *parseFasta(const char *data, size_t size) {
+  const char *end = data + size;
+
+  // skip blank lines, and check the first record has a header that is
+  // not the header of a PIR/NBRF record (e.g. `>P1;name`)
+  const char *p = data;
+  while ((p < end) && isBlank(*p))
+    p++;
+  if ((p == end) || (*p != '>'))
+    return nullptr;
+  if ((end - p > 3) && (p[3] == ';'))
+    return nullptr;
+
+  std::vector<std::string> names;
+  std::vector<std::string> sequences;
+  size_t residues = 0;
+
+  while (p < end) {
+    // read the header, up to the first blank
+    const char *header = p + 1;
+    const char *eol = lineEnd(header, end);
+    while ((header < eol) && isBlank(*header))
+      header++;
+    const char *name = header;
+    while ((name < eol) && !isBlank(*name))
+      name++;
+    names.emplace_back(header, name - header);
+
+    // find the start of the next record, i.e. the next `>` at the start
+    // of a line, and copy the lines in between
+    const char *body = (eol < end) ? eol + 1 : end;
+    const char *next = body;
+    while (next < end) {
+      const char *gt = static_cast<const char *>(memchr(next, '>', end - next));
+      if (gt == nullptr) {
+        next = end;
+      } else if ((gt == body) || (gt[-1] == '\n')) {
+        next = gt;
+        break;
+      } else {
+        next = gt + 1;
+        continue;
+      }
+    }
+
+    sequences.emplace_back();
+    std::string &sequence = sequences.back();
+    sequence.reserve(sequences.size() > 1 ? residues : next - body);
+    for (const char *line = body; line < next;) {
+      const char *stop = lineEnd(line, next);
+      appendLine(sequence, line, stop);
+      line = stop + 1;
+    }
+
+    // leave unaligned sequences to the trimAl parser
+    if (sequences.size() == 1)
+      residues = sequence.size();
+    if ((sequence.size() != residues) || (residues == 0))
+      return nullptr;
+    p = next;
+  }
+
+  // move the records to the alignment
+  Alignment *alig = new Alignment();
+  alig->numberOfSequences = names.size();
+  alig->seqsName = new std::string[names.size()];
+  alig->sequences = new std::string[names.size()];
+  for (size_t i = 0; i < names.size(); i++) {
+    alig->seqsName[i] = std::move(names[i]);
+    alig->sequences[i] = std::move(sequences[i]);
+  }
+  alig->numberOfResidues = residues;
+  return alig;
+}
+
+bool formatFasta(const Alignment &alig, std::string &out) {
+  if (!alig.isAligned)
+    return false;
+
+  // find the runs of consecutive retained columns
+  std::vector<std::pair<int, int>> runs;
+  size_t residues = 0;
+  for (int k = 0; k < alig.originalNumberOfResidues;) {
+    if ((alig.saveResidues != nullptr) && (alig.saveResidues[k] == -1)) {
+      k++;
+      continue;
+    }
+    int last = k + 1;
+    while ((last < alig.originalNumberOfResidues) &&
+           ((alig.saveResidues == nullptr) || (alig.saveResidues[last] != -1)))
+      last++;
+    runs.emplace_back(k, last - k);
+    residues += last - k;
+    k = last;
+  }
+  if (residues == 0)
+    return false;
+
+  // compute the size of the output, to allocate it once
+  const size_t lines = (residues + FASTA_LINE - 1) / FASTA_LINE;
+  size_t size = 0;
+  for (int i = 0; i < alig.originalNumberOfSequences; i++) {
+    if ((alig.saveSequences != nullptr) && (alig.saveSequences[i] == -1))
+      continue;
+    size += alig.seqsName[i].size() + 2 + residues + lines;
+  }
+  if (size == 0)
+    return false;
+
+  const size_t start = out.size();
+  out.resize(start + size);
+  char *p = &out[start];
+  for (int i = 0; i < alig.originalNumberOfSequences; i++) {
+    if ((alig.saveSequences != nullptr) && (alig.saveSequences[i] == -1))
+      continue;
+    // write the header
+    const std::string &name = alig.seqsName[i];
+    *p++ = '>';
+    memcpy(p, name.data(), name.size());
+    p += name.size();
+    *p++ = '\n';
+    // copy the runs of retained residues, breaking them at line ends
+    const char *sequence = alig.sequences[i].data();
+    size_t column = 0;
+    for (const auto &run : runs) {
+      const char *src = sequence + run.first;
+      size_t n = run.second;
+      while (n > 0) {
+        const size_t m = std::min(n, FASTA_LINE - column);
+        memcpy(p, src, m);
+        p += m;
+        src += m;
+        n -= m;
+        column += m;
+        if (column == FASTA_LINE) {
+          *p++ = '\n';
+          column = 0;
+        }
+      }
+    }
+    if (column != 0)
+      *p++ = '\n';
+  }
+
+  return true;
+}
+
+Alignment *loadFasta(const char *path) {
+#if defined(_WIN32)
+  return nullptr;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return nullptr;
+
+  struct stat st;
+  if ((fstat(fd, &st) == -1) || !S_ISREG(st.st_mode) || (st.st_size == 0)) {
+    close(fd);
+    return nullptr;
+  }
+
+  const size_t size = st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  Alignment *alig = parseFasta(static_cast<const char *>(data), size);
+  munmap(data, size);
+  return alig;
+#endif
+}
+
+} // namespace simd
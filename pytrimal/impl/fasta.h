@@ -0,0 +1,50 @@
+#ifndef _PYTRIMAL_IMPL_FASTA
+#define _PYTRIMAL_IMPL_FASTA
+
+#include <cstddef>
+#include <string>
+
+#include "Alignment/Alignment.h"
+
+namespace simd {
+
+// Number of residues written on each line of a FASTA record.
+const size_t FASTA_LINE = 60;
+
+// Load an aligned FASTA file by mapping it in memory, and scanning it for
+// line and record boundaries with `memchr`, rather than reading it line by
+// line through an input stream.
+//
+// The names and sequences are copied to a new alignment, as trimAl would
+// read them: the name of a sequence is the header up to the first space,
+// and whitespace is removed from the sequence lines. The alignment is
+// returned *without* calling `fillMatrices`, so that the caller can check
+// its residues while being able to report errors.
+//
+// Return `nullptr` if the file can't be mapped, doesn't look like a FASTA
+// file, or contains sequences of different lengths, in which case it should
+// be loaded by the trimAl format manager instead. Safe to call without the
+// GIL.
+Alignment *loadFasta(const char *path);
+
+// Parse an aligned FASTA file from a block of `size` bytes in memory,
+// with the same rules as `loadFasta`.
+Alignment *parseFasta(const char *data, size_t size);
+
+// Format the retained sequences and residues of an alignment as FASTA
+// records, with the sequences wrapped at `FASTA_LINE` residues, exactly
+// like the trimAl `fasta` format handler does, and append them to `out`.
+//
+// The retained columns are copied by runs of consecutive columns, found
+// once for all sequences, rather than one character at a time through an
+// output stream, and the output is written to a buffer sized in advance.
+//
+// Return `false` without writing anything if the alignment can't be
+// written by this function, e.g. if it is not aligned or doesn't retain
+// any residue, in which case it should be written by the trimAl format
+// handler instead. Safe to call without the GIL.
+bool formatFasta(const Alignment &alig, std::string &out);
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,10 @@
+from libcpp cimport bool
+from libcpp.string cimport string
+
+from trimal.alignment cimport Alignment
+
+
+cdef extern from "impl/fasta.h" namespace "simd" nogil:
+    Alignment* loadFasta(const char* path) except +
+    Alignment* parseFasta(const char* data, size_t size) except +
+    bool formatFasta(const Alignment& alig, string& out) except +
@@ -72,6 +72,10 @@ public:
     return vector;
   }
 
+  inline uint64_t mask() const {
+    return vector & 1;
+  }
+
   inline void clear() {
     vector = 0;
   }
@@ -80,23 +84,34 @@ public:
 namespace statistics {
 void GenericSimilarity::calculateMatrixIdentity() {
   StartTiming("void GenericSimilarity::calculateMatrixIdentity() ");
-  simd::calculateMatrixIdentity<GenericVector>(*this);
+  identity = simd::calculateMatrixIdentity<GenericVector>(*this, context);
 }
 
 bool GenericSimilarity::calculateVectors(bool cutByGap) {
   StartTiming("bool GenericSimilarity::calculateVectors(bool cutByGap) ");
-  return simd::calculateSimilarityVectors<GenericVector>(*this, cutByGap);
+  return simd::calculateSimilarityVectors<GenericVector>(*this, cutByGap,
+                                                         identity, context);
+}
+
+bool GenericSimilarity::applyWindow(int halfW) {
+  StartTiming("bool GenericSimilarity::applyWindow(int halfW) ");
+  return simd::applySimilarityWindow(*this, halfW);
 }
 
 void GenericGaps::CalculateVectors() {
   StartTiming("bool GenericGaps::CalculateVectors() ");
-  simd::calculateGapVectors<GenericVector>(*this);
+  simd::calculateGapVectors<GenericVector>(*this, context);
+}
+
+bool GenericGaps::applyWindow(int halfW) {
+  StartTiming("bool GenericGaps::applyWindow(int halfW) ");
+  return simd::applyGapWindow(*this, halfW, context);
 }
 } // namespace statistics
 
 void GenericCleaner::calculateSeqIdentity() {
   StartTiming("void GenericCleaner::calculateSeqIdentity() ");
-  simd::calculateSeqIdentity<GenericVector>(*this);
+  simd::calculateSeqIdentity<GenericVector>(*this, context);
 }
 
 bool GenericCleaner::calculateSpuriousVector(float overlap,
@@ -104,5 +119,13 @@ bool GenericCleaner::calculateSpuriousVector(float overlap,
   StartTiming("bool GenericCleaner::calculateSpuriousVector(float overlap, float "
               "*spuriousVector) ");
   return simd::calculateSpuriousVector<GenericVector>(*this, overlap,
-                                                   spuriousVector);
-}
\ No newline at end of file
+                                                   spuriousVector, context);
+}
+
+Alignment *GenericCleaner::getGreedyClustering(int clusters,
+                                               float identityThreshold) {
+  StartTiming("Alignment *GenericCleaner::getGreedyClustering(int clusters, "
+              "float identityThreshold) ");
+  return simd::getGreedyClustering<GenericVector>(*this, clusters,
+                                                  identityThreshold, context);
+}
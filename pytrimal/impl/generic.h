@@ -7,25 +7,50 @@
 #include "Statistics/Gaps.h"
 #include "Statistics/Similarity.h"
 
+#include "clustering.h"
+#include "context.h"
+
 namespace statistics {
 class GenericSimilarity : public Similarity {
 public:
-  GenericSimilarity(Alignment *parentAlignment) : Similarity(parentAlignment) {}
+  GenericSimilarity(Alignment *parentAlignment,
+                    const simd::Context &context = simd::Context())
+      : Similarity(parentAlignment), context(context) {}
   void calculateMatrixIdentity() override;
   bool calculateVectors(bool cutByGap) override;
+  bool applyWindow(int halfW) override;
+
+protected:
+  simd::Context context;
+  // the identity matrix between the sequences, kept while the statistic
+  // is alive even if the alignment cache could not store it
+  simd::AlignmentCache::IdentityValues identity;
 };
 class GenericGaps : public Gaps {
 public:
-  GenericGaps(Alignment *parentAlignment) : Gaps(parentAlignment) {}
+  GenericGaps(Alignment *parentAlignment,
+              const simd::Context &context = simd::Context())
+      : Gaps(parentAlignment), context(context) {}
   void CalculateVectors() override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
 };
 } // namespace statistics
 
-class GenericCleaner : public Cleaner {
+class GenericCleaner : public Cleaner, public simd::GreedyClustering {
 public:
-  GenericCleaner(Alignment *parent) : Cleaner(parent) {}
+  GenericCleaner(Alignment *parent,
+                 const simd::Context &context = simd::Context())
+      : Cleaner(parent), context(context) {}
   void calculateSeqIdentity() override;
   bool calculateSpuriousVector(float overlap, float *spuriousVector) override;
+  Alignment *getGreedyClustering(int clusters,
+                                 float identityThreshold) override;
+
+protected:
+  simd::Context context;
 };
 
 #endif
@@ -2,14 +2,19 @@ from trimal.alignment cimport Alignment
 from trimal.cleaner cimport Cleaner
 from trimal.statistics cimport Similarity, Gaps
 
+from .context cimport Context
+
 
 cdef extern from "impl/generic.h" namespace "statistics" nogil:
     cdef cppclass GenericSimilarity(Similarity):
         GenericSimilarity(Alignment * parentAlignment)
+        GenericSimilarity(Alignment * parentAlignment, const Context& context)
     cdef cppclass GenericGaps(Gaps):
         GenericGaps(Alignment* parentAlignment)
+        GenericGaps(Alignment* parentAlignment, const Context& context)
 
 
 cdef extern from "impl/sse.h" nogil:
     cdef cppclass GenericCleaner(Cleaner):
         GenericCleaner(Alignment* parentAlignment)
+        GenericCleaner(Alignment* parentAlignment, const Context& context)
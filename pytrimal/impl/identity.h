@@ -0,0 +1,195 @@
+#ifndef _PYTRIMAL_IMPL_IDENTITY
+#define _PYTRIMAL_IMPL_IDENTITY
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace simd {
+
+// The encodings of the values of an `IdentityMatrix`.
+enum IdentityFormat {
+  // single-precision floats, the same values as trimAl
+  IdentityFloat32 = 0,
+  // half-precision floats, with a relative error of at most 2^-11
+  IdentityFloat16 = 1,
+  // 16-bit fixed-point numbers in [0, 1], with an error of at most 2^-17
+  IdentityFixed16 = 2,
+};
+
+// Convert a single-precision float to half-precision, rounding to the
+// nearest even value.
+static inline uint16_t floatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t exponent = (bits >> 23) & 0xFF;
+  uint32_t mantissa = bits & 0x7FFFFF;
+
+  // infinities and NaN, keeping NaN quiet
+  if (exponent == 0xFF)
+    return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+  // overflow to infinity
+  int e = (int)exponent - 127 + 15;
+  if (e >= 0x1F)
+    return sign | 0x7C00;
+  // subnormal half, or underflow to zero
+  if (e <= 0) {
+    if (e < -10)
+      return sign;
+    mantissa |= 0x800000;
+    const int shift = 14 - e;
+    uint32_t half = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1U << shift) - 1);
+    const uint32_t middle = 1U << (shift - 1);
+    if ((rest > middle) || ((rest == middle) && (half & 1)))
+      half++;
+    return sign | half;
+  }
+  // normal half, letting a carry of the rounding increase the exponent
+  uint32_t half = ((uint32_t)e << 10) | (mantissa >> 13);
+  const uint32_t rest = mantissa & 0x1FFF;
+  if ((rest > 0x1000) || ((rest == 0x1000) && (half & 1)))
+    half++;
+  return sign | half;
+}
+
+// Convert a half-precision float to single-precision, which is exact.
+static inline float halfToFloat(uint16_t half) {
+  const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1F;
+  uint32_t mantissa = half & 0x3FF;
+  uint32_t bits;
+  if (exponent == 0x1F) {
+    bits = sign | 0x7F800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  } else if (mantissa != 0) {
+    // normalize the subnormal half
+    int e = 127 - 15 + 1;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      e--;
+    }
+    bits = sign | ((uint32_t)e << 23) | ((mantissa & 0x3FF) << 13);
+  } else {
+    bits = sign;
+  }
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Convert a value in [0, 1] to 16-bit fixed-point, clamping values out
+// of range, and mapping NaN to zero.
+static inline uint16_t floatToFixed(float value) {
+  if (!(value > 0.F))
+    return 0;
+  if (value >= 1.F)
+    return UINT16_MAX;
+  return (uint16_t)std::lround(value * (float)UINT16_MAX);
+}
+
+static inline float fixedToFloat(uint16_t fixed) {
+  return (float)fixed * (1.F / (float)UINT16_MAX);
+}
+
+// A symmetric matrix of identities between sequences, such as the one
+// computed by the similarity statistics.
+//
+// Only the upper triangle is stored, row by row, since the matrix is
+// symmetric and its diagonal is never read. This takes half the memory of
+// the square matrix used by trimAl, or a fourth with 16-bit values, and
+// the values of row `i` after the diagonal are contiguous, so they can be
+// read in order when comparing sequence `i` to the following sequences.
+class IdentityMatrix {
+public:
+  IdentityMatrix(int n, int format = IdentityFloat32)
+      : n(n), format_(format) {
+    const size_t size = (n > 1) ? offset(n - 1) : 0;
+    if (format == IdentityFloat32)
+      values32.resize(size);
+    else
+      values16.resize(size);
+  }
+
+  // The number of sequences of the matrix.
+  int size() const { return n; }
+  // The encoding of the values of the matrix.
+  int format() const { return format_; }
+  // The number of bytes used by the values of the matrix.
+  size_t bytes() const {
+    return values32.size() * sizeof(float) + values16.size() * sizeof(uint16_t);
+  }
+
+  // Set the identity between sequences `i` and `j`, with `i < j`.
+  void store(int i, int j, float value) {
+    const size_t index = offset(i) + (j - i - 1);
+    switch (format_) {
+    case IdentityFloat16:
+      values16[index] = floatToHalf(value);
+      break;
+    case IdentityFixed16:
+      values16[index] = floatToFixed(value);
+      break;
+    default:
+      values32[index] = value;
+    }
+  }
+
+  // Get the identity between sequences `i` and `j`, with `i != j`.
+  float load(int i, int j) const {
+    if (i > j)
+      std::swap(i, j);
+    const size_t index = offset(i) + (j - i - 1);
+    switch (format_) {
+    case IdentityFloat16:
+      return halfToFloat(values16[index]);
+    case IdentityFixed16:
+      return fixedToFloat(values16[index]);
+    default:
+      return values32[index];
+    }
+  }
+
+  // Get the identities between sequence `i` and the following sequences,
+  // with the identity to sequence `i + 1 + k` at index `k`. Values stored
+  // with 16 bits are decoded into `buffer`, which must have room for
+  // `size() - i - 1` values, and single-precision values are returned
+  // without copy.
+  const float *row(int i, float *buffer) const {
+    const size_t start = offset(i);
+    const int count = n - i - 1;
+    switch (format_) {
+    case IdentityFloat16:
+      for (int k = 0; k < count; k++)
+        buffer[k] = halfToFloat(values16[start + k]);
+      return buffer;
+    case IdentityFixed16:
+      for (int k = 0; k < count; k++)
+        buffer[k] = fixedToFloat(values16[start + k]);
+      return buffer;
+    default:
+      return values32.data() + start;
+    }
+  }
+
+private:
+  // The index of the first value of row `i`, which holds the identities
+  // of sequence `i` to sequences `i + 1` to `n - 1`.
+  size_t offset(int i) const {
+    return (size_t)i * (2 * (size_t)n - i - 1) / 2;
+  }
+
+  int n;
+  int format_;
+  std::vector<float> values32;
+  std::vector<uint16_t> values16;
+};
+
+} // namespace simd
+
+#endif
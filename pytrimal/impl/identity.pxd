@@ -0,0 +1,5 @@
+cdef extern from "impl/identity.h" namespace "simd" nogil:
+    enum IdentityFormat:
+        IdentityFloat32
+        IdentityFloat16
+        IdentityFixed16
@@ -0,0 +1,29 @@
+#include "Alignment/Alignment.h"
+
+#include "lease.h"
+
+namespace simd {
+
+SequenceLease::SequenceLease(Alignment &original)
+    : holder(new Alignment(original)), counter(new int(1)) {}
+
+SequenceLease::~SequenceLease() {
+  // release the reference of the lease to its counter, which is the last
+  // one if all the copies were destroyed as expected
+  if (--(*counter) == 0)
+    delete counter;
+  // release the reference to the original sequences
+  delete holder;
+}
+
+Alignment *SequenceLease::copy() const {
+  // the copy constructor increments the counter of the original sequences,
+  // so move the reference of the copy to the counter of the lease
+  Alignment *alignment = new Alignment(*holder);
+  (*holder->SeqRef)--;
+  alignment->SeqRef = counter;
+  (*counter)++;
+  return alignment;
+}
+
+} // namespace simd
@@ -0,0 +1,41 @@
+#ifndef _PYTRIMAL_IMPL_LEASE
+#define _PYTRIMAL_IMPL_LEASE
+
+#include "Alignment/Alignment.h"
+
+namespace simd {
+
+// A shared, read-only view of the sequences of an alignment.
+//
+// Copies of a trimAl alignment share the sequence data of the original,
+// and only allocate their own residue and sequence masks; the number of
+// copies is counted with the `SeqRef` counter shared by all of them, which
+// is not atomic. The copies created by a lease instead count references
+// with a counter of their own, so that a trimming task running without
+// the GIL never updates the counter of an alignment used from Python, or
+// by another task.
+//
+// The lease holds one reference to the original sequences, and one to its
+// own counter, so that the sequences are never released by the copies. It
+// must therefore outlive all the copies it created, and be created and
+// destroyed with the GIL held.
+class SequenceLease {
+public:
+  explicit SequenceLease(Alignment &original);
+  ~SequenceLease();
+
+  SequenceLease(const SequenceLease &) = delete;
+  SequenceLease &operator=(const SequenceLease &) = delete;
+
+  // Create a copy of the original alignment sharing its sequences, which
+  // must be called with the GIL held.
+  Alignment *copy() const;
+
+private:
+  Alignment *holder;
+  int *counter;
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,7 @@
+from trimal.alignment cimport Alignment
+
+
+cdef extern from "impl/lease.h" namespace "simd" nogil:
+    cdef cppclass SequenceLease:
+        SequenceLease(Alignment& original)
+        Alignment* copy()
@@ -1,5 +1,6 @@
 #include <climits>
 #include <cstdint>
+#include <cstring>
 #include <mmintrin.h>
 
 #include "Alignment/Alignment.h"
@@ -71,11 +72,18 @@ public:
   }
 
   inline uint16_t sum() const {
-    __m64    hi      = _mm_unpackhi_pi16(_mm_setzero_si64(), vector);
-    __m64    lo      = _mm_unpacklo_pi16(_mm_setzero_si64(), vector);
+    __m64    hi      = _mm_unpackhi_pi8(vector, _mm_setzero_si64());
+    __m64    lo      = _mm_unpacklo_pi8(vector, _mm_setzero_si64());
     __m64    partial = _mm_add_pi16(hi, lo);
     uint64_t value   = _mm_cvtm64_si64(partial);
-    return (value & 0xFFFF) + (value >> 16);
+    return (value & 0xFFFF) + ((value >> 16) & 0xFFFF) +
+           ((value >> 32) & 0xFFFF) + (value >> 48);
+  }
+
+  inline uint64_t mask() const {
+    uint64_t bytes;
+    memcpy(&bytes, &vector, sizeof(uint64_t));
+    return simd::collect_bits(bytes);
   }
 
   inline void clear() { vector = _mm_setzero_si64(); }
@@ -84,28 +92,47 @@ public:
 namespace statistics {
 void MMXSimilarity::calculateMatrixIdentity() {
   StartTiming("void MMXSimilarity::calculateMatrixIdentity() ");
-  simd::calculateMatrixIdentity<MMXVector>(*this);
+  identity = simd::calculateMatrixIdentity<MMXVector>(*this, context);
 }
 
 bool MMXSimilarity::calculateVectors(bool cutByGap) {
   StartTiming("bool MMXSimilarity::calculateVectors(bool cutByGap) ");
-  return simd::calculateSimilarityVectors<MMXVector>(*this, cutByGap);
+  return simd::calculateSimilarityVectors<MMXVector>(*this, cutByGap,
+                                                     identity, context);
+}
+
+bool MMXSimilarity::applyWindow(int halfW) {
+  StartTiming("bool MMXSimilarity::applyWindow(int halfW) ");
+  return simd::applySimilarityWindow(*this, halfW);
 }
 
 void MMXGaps::CalculateVectors() {
   StartTiming("bool MMXGaps::CalculateVectors() ");
-  simd::calculateGapVectors<MMXVector>(*this);
+  simd::calculateGapVectors<MMXVector>(*this, context);
+}
+
+bool MMXGaps::applyWindow(int halfW) {
+  StartTiming("bool MMXGaps::applyWindow(int halfW) ");
+  return simd::applyGapWindow(*this, halfW, context);
 }
 } // namespace statistics
 
 void MMXCleaner::calculateSeqIdentity() {
   StartTiming("void MMXCleaner::calculateSeqIdentity() ");
-  simd::calculateSeqIdentity<MMXVector>(*this);
+  simd::calculateSeqIdentity<MMXVector>(*this, context);
 }
 
 bool MMXCleaner::calculateSpuriousVector(float overlap, float *spuriousVector) {
   StartTiming("bool MMXCleaner::calculateSpuriousVector(float overlap, float "
               "*spuriousVector) ");
   return simd::calculateSpuriousVector<MMXVector>(*this, overlap,
-                                                  spuriousVector);
+                                                  spuriousVector, context);
+}
+
+Alignment *MMXCleaner::getGreedyClustering(int clusters,
+                                           float identityThreshold) {
+  StartTiming("Alignment *MMXCleaner::getGreedyClustering(int clusters, "
+              "float identityThreshold) ");
+  return simd::getGreedyClustering<MMXVector>(*this, clusters,
+                                              identityThreshold, context);
 }
@@ -5,25 +5,50 @@
 #include "Statistics/Gaps.h"
 #include "Statistics/Similarity.h"
 
+#include "clustering.h"
+#include "context.h"
+
 namespace statistics {
 class MMXSimilarity : public Similarity {
 public:
-  MMXSimilarity(Alignment *parentAlignment) : Similarity(parentAlignment) {}
+  MMXSimilarity(Alignment *parentAlignment,
+                const simd::Context &context = simd::Context())
+      : Similarity(parentAlignment), context(context) {}
   void calculateMatrixIdentity() override;
   bool calculateVectors(bool cutByGap) override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
+  // the identity matrix between the sequences, kept while the statistic
+  // is alive even if the alignment cache could not store it
+  simd::AlignmentCache::IdentityValues identity;
 };
 class MMXGaps : public Gaps {
 public:
-  MMXGaps(Alignment *parentAlignment) : Gaps(parentAlignment) {}
+  MMXGaps(Alignment *parentAlignment,
+          const simd::Context &context = simd::Context())
+      : Gaps(parentAlignment), context(context) {}
   void CalculateVectors() override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
 };
 } // namespace statistics
 
-class MMXCleaner : public Cleaner {
+class MMXCleaner : public Cleaner, public simd::GreedyClustering {
 public:
-  MMXCleaner(Alignment *parent) : Cleaner(parent) {}
+  MMXCleaner(Alignment *parent,
+             const simd::Context &context = simd::Context())
+      : Cleaner(parent), context(context) {}
   void calculateSeqIdentity() override;
   bool calculateSpuriousVector(float overlap, float *spuriousVector) override;
+  Alignment *getGreedyClustering(int clusters,
+                                 float identityThreshold) override;
+
+private:
+  simd::Context context;
 };
 
 #endif
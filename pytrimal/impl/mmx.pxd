@@ -2,14 +2,19 @@ from trimal.alignment cimport Alignment
 from trimal.cleaner cimport Cleaner
 from trimal.statistics cimport Similarity, Gaps
 
+from .context cimport Context
+
 
 cdef extern from "impl/mmx.h" namespace "statistics" nogil:
     cdef cppclass MMXSimilarity(Similarity):
         MMXSimilarity(Alignment* parentAlignment)
+        MMXSimilarity(Alignment* parentAlignment, const Context& context)
     cdef cppclass MMXGaps(Gaps):
         MMXGaps(Alignment* parentAlignment)
+        MMXGaps(Alignment* parentAlignment, const Context& context)
 
 
 cdef extern from "impl/mmx.h" nogil:
     cdef cppclass MMXCleaner(Cleaner):
         MMXCleaner(Alignment* parentAlignment)
+        MMXCleaner(Alignment* parentAlignment, const Context& context)
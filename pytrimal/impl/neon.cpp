@@ -74,29 +74,46 @@ public:
 #endif
   }
 
+  inline uint64_t mask() const {
+    uint64x2_t halves = vreinterpretq_u64_u8(vector);
+    return simd::collect_bits(vgetq_lane_u64(halves, 0)) |
+           (simd::collect_bits(vgetq_lane_u64(halves, 1)) << 8);
+  }
+
   inline void clear() { vector = vdupq_n_u8(0); }
 };
 
 namespace statistics {
 void NEONSimilarity::calculateMatrixIdentity() {
   StartTiming("void NEONSimilarity::calculateMatrixIdentity() ");
-  simd::calculateMatrixIdentity<NEONVector>(*this);
+  identity = simd::calculateMatrixIdentity<NEONVector>(*this, context);
 }
 
 bool NEONSimilarity::calculateVectors(bool cutByGap) {
   StartTiming("bool NEONSimilarity::calculateVectors(bool cutByGap) ");
-  return simd::calculateSimilarityVectors<NEONVector>(*this, cutByGap);
+  return simd::calculateSimilarityVectors<NEONVector>(*this, cutByGap,
+                                                      identity, context);
+}
+
+bool NEONSimilarity::applyWindow(int halfW) {
+  StartTiming("bool NEONSimilarity::applyWindow(int halfW) ");
+  return simd::applySimilarityWindow(*this, halfW);
 }
 
 void NEONGaps::CalculateVectors() {
   StartTiming("bool NEONGaps::CalculateVectors() ");
-  simd::calculateGapVectors<NEONVector>(*this);
+  simd::calculateGapVectors<NEONVector>(*this, context);
+}
+
+bool NEONGaps::applyWindow(int halfW) {
+  StartTiming("bool NEONGaps::applyWindow(int halfW) ");
+  return simd::applyGapWindow(*this, halfW, context);
 }
 } // namespace statistics
 
 void NEONCleaner::calculateSeqIdentity() {
   StartTiming("void NEONCleaner::calculateSeqIdentity() ");
-  simd::calculateSeqIdentity<NEONVector>(*this);
+  simd::calculateSeqIdentity<NEONVector>(*this, context);
 }
 
 bool NEONCleaner::calculateSpuriousVector(float overlap,
@@ -104,5 +121,13 @@ bool NEONCleaner::calculateSpuriousVector(float overlap,
   StartTiming("bool NEONCleaner::calculateSpuriousVector(float overlap, float "
               "*spuriousVector) ");
   return simd::calculateSpuriousVector<NEONVector>(*this, overlap,
-                                                   spuriousVector);
-}
\ No newline at end of file
+                                                   spuriousVector, context);
+}
+
+Alignment *NEONCleaner::getGreedyClustering(int clusters,
+                                            float identityThreshold) {
+  StartTiming("Alignment *NEONCleaner::getGreedyClustering(int clusters, "
+              "float identityThreshold) ");
+  return simd::getGreedyClustering<NEONVector>(*this, clusters,
+                                               identityThreshold, context);
+}
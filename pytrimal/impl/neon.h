@@ -5,25 +5,50 @@
 #include "Statistics/Gaps.h"
 #include "Statistics/Similarity.h"
 
+#include "clustering.h"
+#include "context.h"
+
 namespace statistics {
 class NEONSimilarity : public Similarity {
 public:
-  NEONSimilarity(Alignment *parentAlignment) : Similarity(parentAlignment) {}
+  NEONSimilarity(Alignment *parentAlignment,
+                 const simd::Context &context = simd::Context())
+      : Similarity(parentAlignment), context(context) {}
   void calculateMatrixIdentity() override;
   bool calculateVectors(bool cutByGap) override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
+  // the identity matrix between the sequences, kept while the statistic
+  // is alive even if the alignment cache could not store it
+  simd::AlignmentCache::IdentityValues identity;
 };
 class NEONGaps : public Gaps {
 public:
-  NEONGaps(Alignment *parentAlignment) : Gaps(parentAlignment) {}
+  NEONGaps(Alignment *parentAlignment,
+           const simd::Context &context = simd::Context())
+      : Gaps(parentAlignment), context(context) {}
   void CalculateVectors() override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
 };
 } // namespace statistics
 
-class NEONCleaner : public Cleaner {
+class NEONCleaner : public Cleaner, public simd::GreedyClustering {
 public:
-  NEONCleaner(Alignment *parent) : Cleaner(parent) {}
+  NEONCleaner(Alignment *parent,
+              const simd::Context &context = simd::Context())
+      : Cleaner(parent), context(context) {}
   void calculateSeqIdentity() override;
   bool calculateSpuriousVector(float overlap, float *spuriousVector) override;
+  Alignment *getGreedyClustering(int clusters,
+                                 float identityThreshold) override;
+
+private:
+  simd::Context context;
 };
 
 #endif
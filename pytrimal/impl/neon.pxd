@@ -2,13 +2,18 @@ from trimal.alignment cimport Alignment
 from trimal.cleaner cimport Cleaner
 from trimal.statistics cimport Similarity, Gaps
 
+from .context cimport Context
+
 
 cdef extern from "impl/neon.h" namespace "statistics" nogil:
     cdef cppclass NEONSimilarity(Similarity):
          NEONSimilarity(Alignment * parentAlignment)
+         NEONSimilarity(Alignment * parentAlignment, const Context& context)
     cdef cppclass NEONGaps(Gaps):
          NEONGaps(Alignment* parentAlignment)
+         NEONGaps(Alignment* parentAlignment, const Context& context)
 
 cdef extern from "impl/sse.h" nogil:
     cdef cppclass NEONCleaner(Cleaner):
         NEONCleaner(Alignment* parentAlignment)
+        NEONCleaner(Alignment* parentAlignment, const Context& context)
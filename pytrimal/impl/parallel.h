@@ -0,0 +1,55 @@
+#ifndef _PYTRIMAL_IMPL_PARALLEL
+#define _PYTRIMAL_IMPL_PARALLEL
+
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace simd {
+
+// Run `f(row, worker)` for every `row` in `[0, rows)` using up to `threads`
+// workers, `worker` being the index of the thread running the row.
+//
+// Rows are handed out one at a time from a shared counter rather than in
+// contiguous chunks: the pairwise loops only process the upper triangle, so
+// row `i` costs `rows - i - 1` comparisons, and static chunking would leave
+// the workers with the last rows idle most of the time. Since the rows are
+// dispensed in increasing order, the most expensive rows are scheduled first
+// and the cheap rows at the end fill the gaps between workers.
+//
+// The callable must not throw, and must only write to memory that is not
+// shared with other rows.
+template <class F> void parallel_rows(int rows, int threads, F f) {
+  if (threads > rows)
+    threads = rows;
+  if (threads <= 1) {
+    for (int row = 0; row < rows; row++)
+      f(row, 0);
+    return;
+  }
+
+  std::atomic<int> next(0);
+  auto work = [&](int worker) {
+    int row;
+    while ((row = next.fetch_add(1, std::memory_order_relaxed)) < rows)
+      f(row, worker);
+  };
+
+  // the current thread takes part in the computation as worker 0, and
+  // simply processes the remaining rows if a thread could not be spawned
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  try {
+    for (int worker = 1; worker < threads; worker++)
+      pool.emplace_back(work, worker);
+  } catch (const std::system_error &) {
+  }
+  work(0);
+  for (auto &thread : pool)
+    thread.join();
+}
+
+} // namespace simd
+
+#endif
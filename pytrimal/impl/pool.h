@@ -0,0 +1,169 @@
+#ifndef _PYTRIMAL_IMPL_POOL
+#define _PYTRIMAL_IMPL_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace simd {
+
+// A pool of threads running independent jobs in the background.
+//
+// Jobs are dealt in turn to the queue of each worker as they are submitted,
+// so that the first jobs are also the first ones to be started. A worker
+// takes the jobs from the front of its own queue, and once it is empty,
+// steals jobs from the back of the queues of the other workers: a worker
+// stuck on a very large job only delays the jobs of its own queue until
+// they are stolen by the others. Idle workers sleep until a new job is
+// submitted or the pool is cancelled.
+//
+// The job callable must not throw.
+class WorkStealingPool {
+public:
+  WorkStealingPool(int threads, std::function<void(size_t)> job)
+      : job(job), pending(0), cancelled(false) {
+    if (threads < 1)
+      threads = 1;
+
+    queues.reserve(threads);
+    for (int worker = 0; worker < threads; worker++)
+      queues.emplace_back(new Queue());
+
+    // if a thread could not be spawned, its queue is emptied by the other
+    // workers, or by `wait` if no thread could be spawned at all
+    workers.reserve(threads);
+    try {
+      for (int worker = 0; worker < threads; worker++)
+        workers.emplace_back(&WorkStealingPool::work, this, worker);
+    } catch (const std::system_error &) {
+    }
+  }
+
+  ~WorkStealingPool() {
+    cancel();
+    for (auto &thread : workers)
+      thread.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  // Queue the job `i`, which must not have been submitted before.
+  void submit(size_t i) {
+    // count the job before it can be taken, so that `pending` never drops
+    // below zero and `done[i]` exists once the job runs
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (i >= done.size())
+        done.resize(i + 1, false);
+      pending++;
+    }
+    {
+      Queue &queue = *queues[i % queues.size()];
+      std::lock_guard<std::mutex> guard(queue.lock);
+      queue.jobs.push_back(i);
+    }
+    available.notify_one();
+  }
+
+  // Block until the job `i` is done. Must only be called after `submit(i)`
+  // and not after `cancel`.
+  void wait(size_t i) {
+    size_t next;
+    if (workers.empty()) {
+      while (!isDone(i) && take(0, next))
+        run(next);
+    }
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [&] { return done[i]; });
+  }
+
+  // Stop the workers once they are done with their current job.
+  void cancel() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      cancelled.store(true, std::memory_order_relaxed);
+    }
+    available.notify_all();
+  }
+
+private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<size_t> jobs;
+  };
+
+  // Take a job for `worker`, from its own queue or from another worker.
+  bool take(int worker, size_t &next) {
+    const int threads = queues.size();
+    for (int offset = 0; offset < threads; offset++) {
+      Queue &queue = *queues[(worker + offset) % threads];
+      std::lock_guard<std::mutex> guard(queue.lock);
+      if (queue.jobs.empty())
+        continue;
+      if (offset == 0) {
+        next = queue.jobs.front();
+        queue.jobs.pop_front();
+      } else {
+        next = queue.jobs.back();
+        queue.jobs.pop_back();
+      }
+      std::lock_guard<std::mutex> counter(lock);
+      pending--;
+      return true;
+    }
+    return false;
+  }
+
+  bool isDone(size_t i) {
+    std::lock_guard<std::mutex> guard(lock);
+    return done[i];
+  }
+
+  void run(size_t i) {
+    job(i);
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      done[i] = true;
+    }
+    finished.notify_all();
+  }
+
+  void work(int worker) {
+    size_t next;
+    while (!cancelled.load(std::memory_order_relaxed)) {
+      if (take(worker, next)) {
+        run(next);
+        continue;
+      }
+      // sleep until a job is queued, rechecking under the lock so that a
+      // job submitted since `take` failed is not missed
+      std::unique_lock<std::mutex> guard(lock);
+      available.wait(guard, [&] {
+        return cancelled.load(std::memory_order_relaxed) || (pending > 0);
+      });
+    }
+  }
+
+  std::function<void(size_t)> job;
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex lock;
+  std::condition_variable finished;
+  std::condition_variable available;
+  std::vector<bool> done;
+  // number of jobs queued but not taken yet
+  size_t pending;
+  std::atomic<bool> cancelled;
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,51 @@
+#include <chrono>
+#include <cstdint>
+
+#include "profile.h"
+
+namespace simd {
+
+// The innermost timer alive on the current thread, if any.
+static thread_local ProfileTimer *current = nullptr;
+
+Profile::Profile() {
+  for (int i = 0; i < PROFILE_STAGES; i++) {
+    times[i].store(0);
+    counts[i].store(0);
+    sizes[i].store(0);
+  }
+}
+
+void Profile::record(ProfileStage stage, uint64_t nanoseconds,
+                     uint64_t bytes) {
+  times[stage].fetch_add(nanoseconds);
+  counts[stage].fetch_add(1);
+  sizes[stage].fetch_add(bytes);
+}
+
+ProfileTimer::ProfileTimer(Profile *profile, ProfileStage stage,
+                           uint64_t bytes)
+    : profile(profile), stage(stage), bytes(bytes), nested(0),
+      parent(nullptr) {
+  if (profile == nullptr)
+    return;
+  parent = current;
+  current = this;
+  start = std::chrono::steady_clock::now();
+}
+
+ProfileTimer::~ProfileTimer() {
+  if (profile == nullptr)
+    return;
+  const uint64_t elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+  profile->record(stage, elapsed - nested, bytes);
+  // charge the whole time of this timer to the timer it is nested in
+  if (parent != nullptr)
+    parent->nested += elapsed;
+  current = parent;
+}
+
+} // namespace simd
@@ -0,0 +1,83 @@
+#ifndef _PYTRIMAL_IMPL_PROFILE
+#define _PYTRIMAL_IMPL_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace simd {
+
+// The stages of a trimming timed by a `Profile`.
+enum ProfileStage {
+  // copying the retained residues of a trimmed alignment given as input
+  ProfileCopy = 0,
+  // replacing the statistics with those of the backend, and loading the
+  // similarity matrix
+  ProfileSetup,
+  // counting the gaps of each column
+  ProfileGaps,
+  // computing the identity between pairs of sequences
+  ProfileIdentity,
+  // computing the similarity of each column
+  ProfileSimilarity,
+  // computing the overlap of each sequence
+  ProfileOverlap,
+  // selecting the sequences and columns to keep, after the statistics
+  ProfileCleaning,
+};
+
+// The number of stages of `ProfileStage`.
+const int PROFILE_STAGES = 7;
+
+// The wall time, number of calls and number of bytes of residues read by
+// each stage of the trimmings recorded in a profile.
+//
+// The time of a stage excludes the time of the stages run while it is
+// running, so that the times of all stages add up to the time spent
+// trimming. The counters are atomic, so a profile can be shared by tasks
+// running concurrently.
+class Profile {
+public:
+  Profile();
+
+  Profile(const Profile &) = delete;
+  Profile &operator=(const Profile &) = delete;
+
+  void record(ProfileStage stage, uint64_t nanoseconds, uint64_t bytes);
+
+  inline uint64_t nanoseconds(int stage) const { return times[stage].load(); }
+  inline uint64_t calls(int stage) const { return counts[stage].load(); }
+  inline uint64_t bytes(int stage) const { return sizes[stage].load(); }
+
+private:
+  std::atomic<uint64_t> times[PROFILE_STAGES];
+  std::atomic<uint64_t> counts[PROFILE_STAGES];
+  std::atomic<uint64_t> sizes[PROFILE_STAGES];
+};
+
+// Record the wall time of a scope as a stage of a profile, if any.
+//
+// Timers created while another timer is alive on the same thread are
+// nested in it, and their time is subtracted from the time of the outer
+// stage. Without a profile, a timer does not read the clock.
+class ProfileTimer {
+public:
+  ProfileTimer(Profile *profile, ProfileStage stage, uint64_t bytes = 0);
+  ~ProfileTimer();
+
+  ProfileTimer(const ProfileTimer &) = delete;
+  ProfileTimer &operator=(const ProfileTimer &) = delete;
+
+private:
+  Profile *profile;
+  ProfileStage stage;
+  uint64_t bytes;
+  std::chrono::steady_clock::time_point start;
+  // the time spent in the timers nested in this one
+  uint64_t nested;
+  ProfileTimer *parent;
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,20 @@
+from libc.stdint cimport uint64_t
+
+
+cdef extern from "impl/profile.h" namespace "simd" nogil:
+    enum ProfileStage:
+        ProfileCopy
+        ProfileSetup
+        ProfileGaps
+        ProfileIdentity
+        ProfileSimilarity
+        ProfileOverlap
+        ProfileCleaning
+
+    const int PROFILE_STAGES
+
+    cdef cppclass Profile:
+        Profile()
+        uint64_t nanoseconds(int stage)
+        uint64_t calls(int stage)
+        uint64_t bytes(int stage)
@@ -0,0 +1,114 @@
+#include <cctype>
+#include <istream>
+#include <string>
+
+#include "records.h"
+
+namespace simd {
+
+// Whether `line` starts with `prefix`, ignoring case.
+static bool startsWith(const std::string &line, const char *prefix) {
+  size_t i = 0;
+  for (; prefix[i] != '\0'; i++) {
+    if ((i >= line.size()) ||
+        (std::toupper((unsigned char)line[i]) != prefix[i]))
+      return false;
+  }
+  return true;
+}
+
+// Whether `line` only contains whitespace.
+static bool isBlank(const std::string &line) {
+  for (char c : line) {
+    if (!std::isspace((unsigned char)c))
+      return false;
+  }
+  return true;
+}
+
+// Whether `line` is made of exactly two integers, as the header of a
+// PHYLIP alignment.
+static bool isPhylipHeader(const std::string &line) {
+  int numbers = 0;
+  size_t i = 0;
+  while (i < line.size()) {
+    if (std::isspace((unsigned char)line[i])) {
+      i++;
+    } else if (std::isdigit((unsigned char)line[i])) {
+      while ((i < line.size()) && std::isdigit((unsigned char)line[i]))
+        i++;
+      numbers++;
+    } else {
+      return false;
+    }
+  }
+  return numbers == 2;
+}
+
+RecordReader::RecordReader(std::istream &input, const std::string &format)
+    : input(input), kind(kindOf(format)), pending(false) {}
+
+RecordReader::Kind RecordReader::kindOf(const std::string &format) {
+  if (format.compare(0, 5, "fasta") == 0)
+    return Fasta;
+  if (format.compare(0, 7, "clustal") == 0)
+    return Clustal;
+  if (format.compare(0, 5, "nexus") == 0)
+    return Nexus;
+  if (format.compare(0, 4, "mega") == 0)
+    return Mega;
+  if (format.compare(0, 6, "phylip") == 0)
+    return Phylip;
+  return Unsupported;
+}
+
+bool RecordReader::supports(const std::string &format) {
+  return kindOf(format) != Unsupported;
+}
+
+bool RecordReader::isStart(const std::string &line, bool blank) const {
+  switch (kind) {
+  case Fasta:
+    return blank && !line.empty() && (line[0] == '>');
+  case Clustal:
+    return startsWith(line, "CLUSTAL");
+  case Nexus:
+    return startsWith(line, "#NEXUS");
+  case Mega:
+    return startsWith(line, "#MEGA");
+  case Phylip:
+    return isPhylipHeader(line);
+  default:
+    return false;
+  }
+}
+
+bool RecordReader::next(std::string &record) {
+  record.clear();
+
+  // start with the header read at the end of the previous record, or skip
+  // the blank lines before the first record
+  bool content = false;
+  if (pending) {
+    record.append(line).push_back('\n');
+    content = true;
+    pending = false;
+  }
+
+  // read lines until the start of the next record
+  bool blank = false;
+  while (std::getline(input, line)) {
+    if (content && isStart(line, blank)) {
+      pending = true;
+      break;
+    }
+    blank = isBlank(line);
+    if (!content && blank)
+      continue;
+    record.append(line).push_back('\n');
+    content = true;
+  }
+  return content;
+}
+
+} // namespace simd
@@ -0,0 +1,47 @@
+#ifndef _PYTRIMAL_IMPL_RECORDS
+#define _PYTRIMAL_IMPL_RECORDS
+
+#include <istream>
+#include <string>
+
+namespace simd {
+
+// A reader splitting a stream of concatenated alignments into the text of
+// each alignment, reading the stream forward only, so that it can be used
+// with pipes or compressed streams.
+//
+// The alignments are separated by the header of the next alignment, which
+// depends on the format: a `CLUSTAL` line for Clustal, a `#NEXUS` line for
+// NEXUS, a `#MEGA` line for MEGA, and the line with the numbers of
+// sequences and residues for PHYLIP. FASTA alignments have no header, so
+// they must be separated by at least one blank line.
+class RecordReader {
+public:
+  // Create a reader for the alignment format identified by `format`, one
+  // of the trimAl format tokens.
+  RecordReader(std::istream &input, const std::string &format);
+
+  // Whether the reader can split alignments in the given format.
+  static bool supports(const std::string &format);
+
+  // Read the text of the next alignment into `record`, reusing its
+  // storage, and return `false` once the stream is exhausted.
+  bool next(std::string &record);
+
+private:
+  enum Kind { Unsupported, Fasta, Clustal, Nexus, Mega, Phylip };
+
+  static Kind kindOf(const std::string &format);
+  // Whether `line` is the first line of a new alignment.
+  bool isStart(const std::string &line, bool blank) const;
+
+  std::istream &input;
+  Kind kind;
+  // the line read after the end of the previous record, if any
+  std::string line;
+  bool pending;
+};
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,12 @@
+from libcpp cimport bool
+from libcpp.string cimport string
+
+from iostream cimport istream
+
+
+cdef extern from "impl/records.h" namespace "simd" nogil:
+    cdef cppclass RecordReader:
+        RecordReader(istream& input, const string& format)
+        @staticmethod
+        bool supports(const string& format)
+        bool next(string& record) except +
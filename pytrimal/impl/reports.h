@@ -0,0 +1,57 @@
+#ifndef _PYTRIMAL_IMPL_REPORTS
+#define _PYTRIMAL_IMPL_REPORTS
+
+#include <string>
+#include <vector>
+
+#include "reportsystem.h"
+
+namespace simd {
+
+// A buffer for the errors and warnings reported by trimAl on a thread.
+//
+// The report manager normally forwards every report to the Python
+// interpreter, so that errors are raised as exceptions in the thread that
+// trimmed the alignment. While a capture is active on a thread, the reports
+// of that thread are instead stored in the capture, which allows running
+// trimAl on threads that are not known to the interpreter, and to forward
+// the reports later on from a thread holding the GIL.
+class ReportCapture {
+public:
+  ReportCapture();
+  ~ReportCapture();
+
+  ReportCapture(const ReportCapture &) = delete;
+  ReportCapture &operator=(const ReportCapture &) = delete;
+
+  // Start capturing the reports of the current thread.
+  void start();
+  // Stop capturing the reports of the current thread, restoring the
+  // capture that was active before `start` was called, if any.
+  void stop();
+
+  // Whether an error was reported while capturing.
+  inline bool failed() const { return error; }
+
+  // Forward the captured warnings and error to the Python interpreter, and
+  // return -1 if an exception was raised. Must be called with the GIL held.
+  int restore();
+
+  // Get the capture active on the current thread, or `nullptr`.
+  static ReportCapture *current();
+
+  void reportError(ErrorCode code, const std::string &message);
+  void reportWarning(const std::string &message);
+
+private:
+  bool active;
+  ReportCapture *previous;
+  bool error;
+  ErrorCode errorCode;
+  std::string errorMessage;
+  std::vector<std::string> warnings;
+};
+
+} // namespace simd
+
+#endif
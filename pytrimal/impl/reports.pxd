@@ -0,0 +1,10 @@
+from libcpp cimport bool
+
+
+cdef extern from "impl/reports.h" namespace "simd" nogil:
+    cdef cppclass ReportCapture:
+        ReportCapture()
+        void start()
+        void stop()
+        bool failed()
+        int restore() except -1
@@ -75,34 +75,57 @@ public:
     return _mm_extract_epi16(vsum, 0) + _mm_extract_epi16(vsum, 4);
   }
 
+  inline uint64_t mask() const {
+    return (uint16_t)_mm_movemask_epi8(vector);
+  }
+
   inline void clear() { vector = _mm_setzero_si128(); }
 };
 
 namespace statistics {
 void SSESimilarity::calculateMatrixIdentity() {
   StartTiming("void SSESimilarity::calculateMatrixIdentity() ");
-  simd::calculateMatrixIdentity<SSEVector>(*this);
+  identity = simd::calculateMatrixIdentity<SSEVector>(*this, context);
 }
 
 bool SSESimilarity::calculateVectors(bool cutByGap) {
   StartTiming("bool SSESimilarity::calculateVectors(bool cutByGap) ");
-  return simd::calculateSimilarityVectors<SSEVector>(*this, cutByGap);
+  return simd::calculateSimilarityVectors<SSEVector>(*this, cutByGap,
+                                                     identity, context);
+}
+
+bool SSESimilarity::applyWindow(int halfW) {
+  StartTiming("bool SSESimilarity::applyWindow(int halfW) ");
+  return simd::applySimilarityWindow(*this, halfW);
 }
 
 void SSEGaps::CalculateVectors() {
   StartTiming("bool SSEGaps::CalculateVectors() ");
-  simd::calculateGapVectors<SSEVector>(*this);
+  simd::calculateGapVectors<SSEVector>(*this, context);
+}
+
+bool SSEGaps::applyWindow(int halfW) {
+  StartTiming("bool SSEGaps::applyWindow(int halfW) ");
+  return simd::applyGapWindow(*this, halfW, context);
 }
 } // namespace statistics
 
 void SSECleaner::calculateSeqIdentity() {
   StartTiming("void SSECleaner::calculateSeqIdentity() ");
-  simd::calculateSeqIdentity<SSEVector>(*this);
+  simd::calculateSeqIdentity<SSEVector>(*this, context);
 }
 
 bool SSECleaner::calculateSpuriousVector(float overlap, float *spuriousVector) {
   StartTiming("bool SSECleaner::calculateSpuriousVector(float overlap, float "
               "*spuriousVector) ");
   return simd::calculateSpuriousVector<SSEVector>(*this, overlap,
-                                                  spuriousVector);
+                                                  spuriousVector, context);
+}
+
+Alignment *SSECleaner::getGreedyClustering(int clusters,
+                                           float identityThreshold) {
+  StartTiming("Alignment *SSECleaner::getGreedyClustering(int clusters, "
+              "float identityThreshold) ");
+  return simd::getGreedyClustering<SSEVector>(*this, clusters,
+                                              identityThreshold, context);
 }
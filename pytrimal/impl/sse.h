@@ -5,25 +5,50 @@
 #include "Statistics/Gaps.h"
 #include "Statistics/Similarity.h"
 
+#include "clustering.h"
+#include "context.h"
+
 namespace statistics {
 class SSESimilarity : public Similarity {
 public:
-  SSESimilarity(Alignment *parentAlignment) : Similarity(parentAlignment) {}
+  SSESimilarity(Alignment *parentAlignment,
+                const simd::Context &context = simd::Context())
+      : Similarity(parentAlignment), context(context) {}
   void calculateMatrixIdentity() override;
   bool calculateVectors(bool cutByGap) override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
+  // the identity matrix between the sequences, kept while the statistic
+  // is alive even if the alignment cache could not store it
+  simd::AlignmentCache::IdentityValues identity;
 };
 class SSEGaps : public Gaps {
 public:
-  SSEGaps(Alignment *parentAlignment) : Gaps(parentAlignment) {}
+  SSEGaps(Alignment *parentAlignment,
+          const simd::Context &context = simd::Context())
+      : Gaps(parentAlignment), context(context) {}
   void CalculateVectors() override;
+  bool applyWindow(int halfW) override;
+
+private:
+  simd::Context context;
 };
 } // namespace statistics
 
-class SSECleaner : public Cleaner {
+class SSECleaner : public Cleaner, public simd::GreedyClustering {
 public:
-  SSECleaner(Alignment *parent) : Cleaner(parent) {}
+  SSECleaner(Alignment *parent,
+             const simd::Context &context = simd::Context())
+      : Cleaner(parent), context(context) {}
   void calculateSeqIdentity() override;
   bool calculateSpuriousVector(float overlap, float *spuriousVector) override;
+  Alignment *getGreedyClustering(int clusters,
+                                 float identityThreshold) override;
+
+private:
+  simd::Context context;
 };
 
 #endif
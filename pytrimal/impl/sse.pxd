@@ -2,14 +2,19 @@ from trimal.alignment cimport Alignment
 from trimal.cleaner cimport Cleaner
 from trimal.statistics cimport Similarity, Gaps
 
+from .context cimport Context
+
 
 cdef extern from "impl/sse.h" namespace "statistics" nogil:
     cdef cppclass SSESimilarity(Similarity):
         SSESimilarity(Alignment* parentAlignment)
+        SSESimilarity(Alignment* parentAlignment, const Context& context)
     cdef cppclass SSEGaps(Gaps):
         SSEGaps(Alignment* parentAlignment)
+        SSEGaps(Alignment* parentAlignment, const Context& context)
 
 
 cdef extern from "impl/sse.h" nogil:
     cdef cppclass SSECleaner(Cleaner):
         SSECleaner(Alignment* parentAlignment)
+        SSECleaner(Alignment* parentAlignment, const Context& context)
@@ -1,4 +1,13 @@
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Alignment/Alignment.h"
 #include "InternalBenchmarker.h"
@@ -9,414 +18,794 @@
 #include "reportsystem.h"
 #include "utils.h"
 
+#include "bits.h"
+#include "context.h"
+#include "parallel.h"
+#include "tiling.h"
+
 namespace simd {
 
-template <class T, class Vector> T *aligned_array(size_t n) {
-  T* ptr = nullptr;
-  if (Vector::SIZE > 1) {
-    const size_t mask = Vector::SIZE - 1;
-    const size_t size = (n * sizeof(T) + mask) & (~mask);
-    void* memptr = nullptr;
-    if (posix_memalign(&memptr, Vector::SIZE, size) == 0)
-      ptr = static_cast<T *>(memptr);
-  } else {
-    const size_t size = (n * sizeof(T));
-    ptr = static_cast<T *>(malloc(size));
+// The kernels are compiled once per backend with the instruction set flags
+// of that backend, so they are given internal linkage: otherwise the linker
+// could pick the copy of a shared inline function compiled for a backend
+// the CPU does not support when it is called from another backend.
+namespace {
+
+// Compare `MASK_BITS` consecutive characters of two sequences, and return
+// a word with the bits set for the columns where both characters are equal.
+template <class Vector>
+inline uint64_t equalMask(const uint8_t *datai, const uint8_t *dataj) {
+  static_assert(MASK_BITS % Vector::LANES == 0,
+                "vector lanes must evenly divide a mask word");
+  uint64_t eq = 0;
+  for (size_t b = 0; b < (size_t)MASK_BITS; b += Vector::LANES) {
+    Vector seqi = Vector::loadu(&datai[b]);
+    Vector seqj = Vector::loadu(&dataj[b]);
+    eq |= (seqi == seqj).mask() << b;
   }
-  if (ptr == nullptr)
-    throw std::bad_alloc();
-  return ptr;
+  return eq;
+}
+
+// Compare the last `n` characters of two sequences without SIMD, for the
+// tail columns that do not fill a whole mask word.
+inline uint64_t equalMaskTail(const uint8_t *datai, const uint8_t *dataj,
+                              int n) {
+  uint64_t eq = 0;
+  for (int b = 0; b < n; b++)
+    eq |= (uint64_t)(datai[b] == dataj[b]) << b;
+  return eq;
 }
 
+// Count the identical positions (`sum`) and the positions where at least one
+// of the two sequences has a residue (`length`) in the columns `[begin, end)`,
+// `begin` being a multiple of `MASK_BITS`.
 template <class Vector>
-inline void calculateMatrixIdentity(statistics::Similarity &s) {
+inline void countMatrixIdentity(const uint8_t *datai, const uint8_t *dataj,
+                                const uint64_t *residuesi,
+                                const uint64_t *residuesj, const int begin,
+                                const int end, uint32_t &sum,
+                                uint32_t &length) {
+  int k;
+
+  // process whole words with a single SIMD comparison, the gap
+  // and indeterminate characters being given by the residue masks
+  for (k = begin; k + MASK_BITS <= end; k += MASK_BITS) {
+    const uint64_t eq = equalMask<Vector>(&datai[k], &dataj[k]);
+    const uint64_t ri = residuesi[k / MASK_BITS];
+    const uint64_t rj = residuesj[k / MASK_BITS];
+    sum += popcount(eq & ri & rj);
+    length += popcount(ri | rj);
+  }
 
-  // abort if identity matrix computation was already done
-  if (s.matrixIdentity != nullptr)
-    return;
+  // process the tail elements when there remain less than
+  // can be fitted in a mask word
+  if (k < end) {
+    const uint64_t eq = equalMaskTail(&datai[k], &dataj[k], end - k);
+    const uint64_t ri = residuesi[k / MASK_BITS];
+    const uint64_t rj = residuesj[k / MASK_BITS];
+    sum += popcount(eq & ri & rj);
+    length += popcount(ri | rj);
+  }
+}
 
-  // Allocate memory for the matrix identity
-  s.matrixIdentity = new float *[s.alig->originalNumberOfSequences];
-  for (int i = 0; i < s.alig->originalNumberOfSequences; i++) {
-    s.matrixIdentity[i] = new float[s.alig->originalNumberOfSequences];
+// Compute the identity between each pair of the sequences of `alig` given
+// in `rows`, with the identity between `rows[i]` and `rows[j]` stored at
+// position `(i, j)` of the matrix.
+template <class Vector>
+inline std::shared_ptr<IdentityMatrix>
+computeMatrixIdentity(Alignment &alig, const Context &context,
+                      const std::vector<int> &rows) {
+  const int sequences = rows.size();
+  const int residues = alig.originalNumberOfResidues;
+  int threads = context.threads;
+  Arena &arena = *context.arena;
+
+  // Allocate memory for the upper triangle of the matrix identity
+  auto identity =
+      std::make_shared<IdentityMatrix>(sequences, context.identityFormat);
+
+  // Get the residue masks shared by all statistics of the alignment
+  const ResidueMasks &masks = context.cache->residueMasks(alig);
+
+  // Split the alignment in tiles of sequences and columns sized so that
+  // the sequences of a tile stay in cache while the other sequences are
+  // compared to them, rather than reloading both sequences for each pair.
+  const Tile tile = tile_size(sequences, residues, 1, threads);
+  const int blocks = (sequences + tile.rows - 1) / tile.rows;
+
+  // prepare the counters of each worker, with one row of counters
+  // for every sequence of a tile
+  if (threads > blocks)
+    threads = blocks;
+  if (threads < 1)
+    threads = 1;
+  const size_t counters = (size_t)tile.rows * sequences;
+  std::vector<uint32_t *> sums(threads);
+  std::vector<uint32_t *> lengths(threads);
+  for (int t = 0; t < threads; t++) {
+    sums[t] = arena.allocate<uint32_t>(counters, Vector::SIZE);
+    lengths[t] = arena.allocate<uint32_t>(counters, Vector::SIZE);
   }
 
-  // declare indices
-  int i, j, k, l;
-
-  // Depending on alignment type, indetermination symbol will be one or other
-  char indet = s.alig->getAlignmentType() & SequenceTypes::AA ? 'X' : 'N';
-
-  // prepare constant SIMD vectors
-  const Vector ALLINDET = Vector::duplicate(indet);
-  const Vector ALLGAP = Vector::duplicate('-');
-  const Vector ONES = Vector::duplicate(1);
-
-  // For each sequences' pair, compare identity
-  for (i = 0; i < s.alig->originalNumberOfSequences; i++) {
-
-    const uint8_t *datai =
-        reinterpret_cast<const uint8_t *>(s.alig->sequences[i].data());
-
-    for (j = i + 1; j < s.alig->originalNumberOfSequences; j++) {
-
-      const uint8_t *dataj =
-          reinterpret_cast<const uint8_t *>(s.alig->sequences[j].data());
-
-      Vector len_acc = Vector();
-      Vector sum_acc = Vector();
-
-      uint32_t sum = 0;
-      uint32_t length = 0;
-
-      // run with unrolled loops of UCHAR_MAX iterations first
-      for (k = 0; ((int)(k + Vector::LANES * UCHAR_MAX)) <
-                  s.alig->originalNumberOfResidues;) {
-        // unroll the internal loop
-        for (l = 0; l < UCHAR_MAX; l++, k += Vector::LANES) {
-          // load data for the sequences
-          Vector seqi = Vector::loadu(&datai[k]);
-          Vector seqj = Vector::loadu(&dataj[k]);
-          // find which sequence characters are gap or indet
-          Vector gapsi = (seqi == ALLGAP) | (seqi == ALLINDET);
-          Vector gapsj = (seqj == ALLGAP) | (seqj == ALLINDET);
-          // find which sequence characters are equal
-          Vector eq = (seqi == seqj);
-          // update counters
-          sum_acc += eq & ONES.andnot(gapsi | gapsj);
-          len_acc += ONES.andnot(gapsi & gapsj);
+  // For each block of sequences, compare identity against the following
+  // sequences; blocks are independent so they can be dispatched to
+  // different workers
+  parallel_rows(blocks, threads, [&](int block, int worker) {
+    // declare indices
+    int i, j;
+
+    const int first = block * tile.rows;
+    const int last = std::min(first + tile.rows, sequences);
+
+    uint32_t *sum = sums[worker];
+    uint32_t *length = lengths[worker];
+    std::fill(sum, sum + counters, 0);
+    std::fill(length, length + counters, 0);
+
+    // compare the tile to every sequence one block of columns at a time,
+    // so that each sequence is loaded once for the whole tile
+    for (int begin = 0; begin < residues; begin += tile.columns) {
+      const int end = std::min(begin + tile.columns, residues);
+      for (j = first + 1; j < sequences; j++) {
+        const uint8_t *dataj =
+            reinterpret_cast<const uint8_t *>(alig.sequences[rows[j]].data());
+        for (i = first; (i < last) && (i < j); i++) {
+          const uint8_t *datai = reinterpret_cast<const uint8_t *>(
+              alig.sequences[rows[i]].data());
+          countMatrixIdentity<Vector>(
+              datai, dataj, masks.residueMask(rows[i]),
+              masks.residueMask(rows[j]), begin, end,
+              sum[(i - first) * sequences + j],
+              length[(i - first) * sequences + j]);
         }
-        // merge accumulators
-        sum += sum_acc.sum();
-        length += len_acc.sum();
-        sum_acc.clear();
-        len_acc.clear();
       }
+    }
 
-      // run remaining iterations in SIMD while possible
-      for (; ((int)(k + Vector::LANES)) < s.alig->originalNumberOfResidues;
-           k += Vector::LANES) {
-        // load data for the sequences
-        Vector seqi = Vector::loadu(&datai[k]);
-        Vector seqj = Vector::loadu(&dataj[k]);
-        // find which sequence characters are gap or indet
-        Vector gapsi = (seqi == ALLGAP) | (seqi == ALLINDET);
-        Vector gapsj = (seqj == ALLGAP) | (seqj == ALLINDET);
-        // find which sequence characters are equal
-        Vector eq = (seqi == seqj);
-        // update counters
-        sum_acc += eq & ONES.andnot(gapsi | gapsj);
-        len_acc += ONES.andnot(gapsi & gapsj);
+    // Calculate the value of matrix idn for columns j and i
+    for (i = first; i < last; i++) {
+      for (j = i + 1; j < sequences; j++) {
+        const int index = (i - first) * sequences + j;
+        identity->store(i, j, (1.0F - ((float)sum[index] / length[index])));
       }
+    }
+  });
 
-      // // merge accumulators
-      sum += sum_acc.sum();
-      length += len_acc.sum();
-
-      // process the tail elements when there remain less than
-      // can be fitted in a SIMD vector
-      for (; k < s.alig->originalNumberOfResidues; k++) {
-        int gapi = (datai[k] == '-') || (datai[k] == indet);
-        int gapj = (dataj[k] == '-') || (dataj[k] == indet);
-        sum += (!gapi) && (!gapj) && (datai[k] == dataj[k]);
-        length += (!gapi) || (!gapj);
-      }
+  return identity;
+}
 
-      // Calculate the value of matrix idn for columns j and i
-      s.matrixIdentity[i][j] = s.matrixIdentity[j][i] =
-          (1.0F - ((float)sum / length));
-    }
-  }
+template <class Vector>
+inline AlignmentCache::IdentityValues
+calculateMatrixIdentity(statistics::Similarity &s, const Context &context) {
+  ProfileTimer timer(context.profile.get(), ProfileIdentity,
+                     residueBytes(*s.alig));
+
+  // abort if identity matrix computation was already done by a previous
+  // trimming of the same alignment
+  if (auto cached = context.cache->matrixIdentity(context.identityFormat))
+    return cached;
+
+  std::vector<int> rows(s.alig->originalNumberOfSequences);
+  std::iota(rows.begin(), rows.end(), 0);
+  return context.cache->storeMatrixIdentity(
+      computeMatrixIdentity<Vector>(*s.alig, context, rows));
 }
 
+// Number of columns counted together by each worker of
+// `calculateSpuriousVector`.
+const int SPURIOUS_COLUMNS = 4096;
+
+// Compute the overlap of every sequence, i.e. the fraction of columns in
+// which at least `overlap` of the other sequences agree with it on the
+// presence of a residue: both sequences have a residue, or both have a gap,
+// or both have an indetermination.
+//
+// Rather than comparing every pair of sequences, the sequences with a gap
+// and with an indetermination are counted in each column, so that the
+// number of sequences agreeing with a sequence in a column is the count of
+// its own class minus one. This takes `O(N·L)` time instead of `O(N²·L)`,
+// and both passes are split between threads. The classes are found by
+// comparing the characters directly, so `Vector` is not used, and the
+// loops are left for the compiler to vectorize.
 template <class Vector>
 inline bool calculateSpuriousVector(Cleaner &c, const float overlap,
-                                    float *spuriousVector) {
+                                    float *spuriousVector,
+                                    const Context &context) {
+  ProfileTimer timer(context.profile.get(), ProfileOverlap,
+                     residueBytes(*c.alig));
+
   // abort if there is not output vector to write to
   if (spuriousVector == nullptr)
     return false;
 
+  const int sequences = c.alig->originalNumberOfSequences;
+  const int residues = c.alig->originalNumberOfResidues;
+  const char indet =
+      indeterminationSymbol(alphabetType(*c.alig, context.alphabet));
+
   // compute number of sequences from overlap threshold
-  uint32_t ovrlap =
-      uint32_t(ceil(overlap * float(c.alig->originalNumberOfSequences - 1)));
+  uint32_t ovrlap = uint32_t(ceil(overlap * float(sequences - 1)));
+
+  // count the gaps and indeterminations of each column, with the workers
+  // counting separate blocks of columns of all sequences
+  std::vector<uint32_t> gaps(residues, 0);
+  std::vector<uint32_t> indets(residues, 0);
+  const int chunks = (residues + SPURIOUS_COLUMNS - 1) / SPURIOUS_COLUMNS;
+  parallel_rows(chunks, context.threads, [&](int chunk, int /*worker*/) {
+    const int begin = chunk * SPURIOUS_COLUMNS;
+    const int end = std::min(begin + SPURIOUS_COLUMNS, residues);
+    uint32_t *gapsc = gaps.data();
+    uint32_t *indetsc = indets.data();
+    for (int j = 0; j < sequences; j++) {
+      const char *row = c.alig->sequences[j].data();
+      for (int k = begin; k < end; k++) {
+        gapsc[k] += (row[k] == '-');
+        indetsc[k] += (row[k] == indet);
+      }
+    }
+  });
+
+  // find, for each class of character, the columns where a sequence of
+  // that class is agreed with by enough other sequences
+  std::vector<uint8_t> residueOk(residues);
+  std::vector<uint8_t> gapOk(residues);
+  std::vector<uint8_t> indetOk(residues);
+  for (int k = 0; k < residues; k++) {
+    const uint32_t others = sequences - gaps[k] - indets[k];
+    residueOk[k] = (others > 0) && (others - 1 >= ovrlap);
+    gapOk[k] = (gaps[k] > 0) && (gaps[k] - 1 >= ovrlap);
+    indetOk[k] = (indets[k] > 0) && (indets[k] - 1 >= ovrlap);
+  }
 
-  // Depending on alignment type, indetermination symbol will be one or other
-  char indet = (c.alig->getAlignmentType() & SequenceTypes::AA) ? 'X' : 'N';
+  // compute overlap of each sequence as the fraction of columns above
+  // overlap threshold
+  parallel_rows(sequences, context.threads, [&](int i, int /*worker*/) {
+    const char *row = c.alig->sequences[i].data();
+    uint32_t seqValue = 0;
+    for (int k = 0; k < residues; k++) {
+      const uint8_t gap = (row[k] == '-');
+      const uint8_t ind = (row[k] == indet);
+      seqValue += (gap & gapOk[k]) | (ind & indetOk[k]) |
+                  (((gap | ind) ^ 1) & residueOk[k]);
+    }
+    spuriousVector[i] = ((float)seqValue / residues);
+  });
 
-  // prepare constant SIMD vectors
-  const Vector ALLINDET = Vector::duplicate(indet);
-  const Vector ALLGAP = Vector::duplicate('-');
-  const Vector ONES = Vector::duplicate(1);
+  // If there is not problem in the method, return true
+  return true;
+}
 
-  // allocate aligned memory for faster SIMD loads
-  uint32_t *hits =
-      aligned_array<uint32_t, Vector>(c.alig->originalNumberOfResidues);
-  uint8_t *hits_u8 =
-      aligned_array<uint8_t, Vector>(c.alig->originalNumberOfResidues);
+// Count the identical positions (`hit`) and the positions where at least one
+// of the two sequences has a residue (`dst`) in the columns `[begin, end)`,
+// only considering the columns set in the `keep` mask.
+template <class Vector>
+inline void countSeqIdentity(const uint8_t *datai, const uint8_t *dataj,
+                             const uint64_t *residuesi,
+                             const uint64_t *residuesj, const uint64_t *keep,
+                             const int begin, const int end, uint32_t &hit,
+                             uint32_t &dst) {
+  int k;
+
+  // process whole words with a single SIMD comparison, the gap
+  // and indeterminate characters being given by the residue masks
+  for (k = begin; k + MASK_BITS <= end; k += MASK_BITS) {
+    const uint64_t eq = equalMask<Vector>(&datai[k], &dataj[k]);
+    const uint64_t mask =
+        (residuesi[k / MASK_BITS] | residuesj[k / MASK_BITS]) &
+        keep[k / MASK_BITS];
+    dst += popcount(mask);
+    hit += popcount(eq & mask);
+  }
 
-  // for each sequence in the alignment, computes its overlap
-  for (int i = 0; i < c.alig->originalNumberOfSequences; i++) {
+  // process the tail elements when there remain less than
+  // can be fitted in a mask word
+  if (k < end) {
+    const uint64_t eq = equalMaskTail(&datai[k], &dataj[k], end - k);
+    const uint64_t mask =
+        (residuesi[k / MASK_BITS] | residuesj[k / MASK_BITS]) &
+        keep[k / MASK_BITS];
+    dst += popcount(mask);
+    hit += popcount(eq & mask);
+  }
+}
 
-    // reset hits count
-    memset(&hits[0], 0, c.alig->originalNumberOfResidues * sizeof(uint32_t));
-    memset(&hits_u8[0], 0, c.alig->originalNumberOfResidues * sizeof(uint8_t));
+// Compute the identity between the sequences retained in the alignment of
+// `c`, marking the pairs without residues in common with a negative score.
+template <class Vector>
+inline void computeSeqIdentity(Cleaner &c, const Context &context) {
 
-    const uint8_t *datai =
-        reinterpret_cast<const uint8_t *>(c.alig->sequences[i].data());
+  const int sequences = c.alig->originalNumberOfSequences;
+  const int residues = c.alig->originalNumberOfResidues;
+  int threads = context.threads;
 
-    // compare sequence to other sequences for every position
-    unsigned int processedSequences = 0;
-    for (int j = 0; j < c.alig->originalNumberOfSequences; j++) {
+  // declare indices
+  int i, j, k;
 
-      // don't compare sequence to itself
-      if (j == i)
-        continue;
+  // Get the residue masks shared by all statistics of the alignment
+  const ResidueMasks &masks = context.cache->residueMasks(*c.alig);
 
-      const uint8_t *dataj =
-          reinterpret_cast<const uint8_t *>(c.alig->sequences[j].data());
-
-      int k = 0;
-
-      // run iterations in SIMD while possible
-      for (; ((int)(k + Vector::LANES)) <= c.alig->originalNumberOfResidues;
-           k += Vector::LANES) {
-        // load data for the sequences
-        const Vector seqi = Vector::loadu(&datai[k]);
-        const Vector seqj = Vector::loadu(&dataj[k]);
-        // find which sequence characters are gap or indet
-        const Vector gapsi = (seqi == ALLGAP) | (seqi == ALLINDET);
-        const Vector gapsj = (seqj == ALLGAP) | (seqj == ALLINDET);
-        const Vector gaps = !(gapsi | gapsj);
-        // find which sequence characters match
-        const Vector eq = (seqi == seqj);
-        // find position where either not both characters are gap, or they are
-        // equal
-        const Vector n = (eq | gaps) & ONES;
-        // update counters
-        Vector hit = Vector::load(&hits_u8[k]);
-        hit += n;
-        hit.store(&hits_u8[k]);
-      }
+  // create a mask of residues to keep
+  std::vector<uint64_t> keep(masks.words, 0);
+  for (k = 0; k < residues; k++) {
+    if (c.alig->saveResidues[k] != -1)
+      keep[k / MASK_BITS] |= 1ULL << (k % MASK_BITS);
+  }
 
-      // process the tail elements when there remain less than
-      // can be fitted in a SIMD vector
-      for (; k < c.alig->originalNumberOfResidues; k++) {
-        int nongapi = (datai[k] != indet) && (datai[k] != '-');
-        int nongapj = (dataj[k] != indet) && (dataj[k] != '-');
-        hits_u8[k] += ((nongapi && nongapj) || (datai[k] == dataj[k]));
-      }
+  // Split the alignment in tiles of sequences and columns sized so that
+  // the sequences of a tile stay in cache while the other sequences are
+  // compared to them, rather than reloading both sequences for each pair.
+  const Tile tile = tile_size(sequences, residues, 1, threads);
+  const int blocks = (sequences + tile.rows - 1) / tile.rows;
+
+  // prepare the counters of each worker, with one row of counters
+  // for every sequence of a tile
+  if (threads > blocks)
+    threads = blocks;
+  if (threads < 1)
+    threads = 1;
+  Arena &arena = *context.arena;
+  const size_t counters = (size_t)tile.rows * sequences;
+  std::vector<uint32_t *> hits(threads);
+  std::vector<uint32_t *> dsts(threads);
+  for (int t = 0; t < threads; t++) {
+    hits[t] = arena.allocate<uint32_t>(counters, Vector::SIZE);
+    dsts[t] = arena.allocate<uint32_t>(counters, Vector::SIZE);
+  }
 
-      // we can process up to UCHAR_MAX sequences, otherwise hits_u8[k]
-      // may overflow, so every UCHAR_MAX iterations we transfer the
-      // partial hit counts from `hits_u8` to `hits`
-      processedSequences++;
-      if ((processedSequences % UCHAR_MAX) == 0) {
-        for (k = 0; k < c.alig->originalNumberOfResidues; k++)
-          hits[k] += hits_u8[k];
-        memset(hits_u8, 0, c.alig->originalNumberOfResidues * sizeof(uint8_t));
+  // For each seq, compute its identity score against the others in the MSA;
+  // blocks of sequences are independent so they can be dispatched to
+  // different workers
+  parallel_rows(blocks, threads, [&](int block, int worker) {
+    // declare indices
+    int i, j;
+
+    const int first = block * tile.rows;
+    const int last = std::min(first + tile.rows, sequences);
+
+    uint32_t *hit = hits[worker];
+    uint32_t *dst = dsts[worker];
+    std::fill(hit, hit + counters, 0);
+    std::fill(dst, dst + counters, 0);
+
+    // compare the tile to every sequence one block of columns at a time,
+    // so that each sequence is loaded once for the whole tile
+    for (int begin = 0; begin < residues; begin += tile.columns) {
+      const int end = std::min(begin + tile.columns, residues);
+      for (j = first + 1; j < sequences; j++) {
+        if (c.alig->saveSequences[j] == -1)
+          continue;
+        const uint8_t *dataj =
+            reinterpret_cast<const uint8_t *>(c.alig->sequences[j].data());
+        for (i = first; (i < last) && (i < j); i++) {
+          if (c.alig->saveSequences[i] == -1)
+            continue;
+          const uint8_t *datai =
+              reinterpret_cast<const uint8_t *>(c.alig->sequences[i].data());
+          countSeqIdentity<Vector>(datai, dataj, masks.residueMask(i),
+                                   masks.residueMask(j), keep.data(), begin,
+                                   end, hit[(i - first) * sequences + j],
+                                   dst[(i - first) * sequences + j]);
+        }
       }
     }
 
-    // update counters after last loop
-    for (int k = 0; k < c.alig->originalNumberOfResidues; k++)
-      hits[k] += hits_u8[k];
-
-    // compute number of good positions in for sequence i
-    uint32_t seqValue = 0;
-    for (int k = 0; k < c.alig->originalNumberOfResidues; k++)
-      if (hits[k] >= ovrlap)
-        seqValue++;
-
-    // compute overlap of current sequence as the fraction of columns
-    // above overlap threshold
-    spuriousVector[i] = ((float)seqValue / c.alig->originalNumberOfResidues);
-  }
+    for (i = first; i < last; i++) {
+      if (c.alig->saveSequences[i] == -1)
+        continue;
+      for (j = i + 1; j < sequences; j++) {
+        if (c.alig->saveSequences[j] == -1)
+          continue;
 
-  // free allocated memory
-  free(hits);
-  free(hits_u8);
+        const int index = (i - first) * sequences + j;
+        if (dst[index] == 0) {
+          // mark the pair with a negative score, it will be reported
+          // once all workers are done
+          c.alig->identities[i][j] = -1.0F;
+        } else {
+          // Identity score between two sequences is the ratio of identical
+          // residues by the total length (common and no-common residues)
+          // among them
+          c.alig->identities[i][j] = (float)hit[index] / dst[index];
+        }
 
-  // If there is not problem in the method, return true
-  return true;
+        c.alig->identities[j][i] = c.alig->identities[i][j];
+      }
+    }
+  });
 }
 
-template <class Vector> inline void calculateSeqIdentity(Cleaner &c) {
+template <class Vector>
+inline void calculateSeqIdentity(Cleaner &c, const Context &context) {
+  ProfileTimer timer(context.profile.get(), ProfileIdentity,
+                     residueBytes(*c.alig));
+
+  const int sequences = c.alig->originalNumberOfSequences;
 
   // create identities matrix to store identities scores
-  c.alig->identities = new float *[c.alig->originalNumberOfSequences];
-  for (int i = 0; i < c.alig->originalNumberOfSequences; i++) {
+  c.alig->identities = new float *[sequences];
+  for (int i = 0; i < sequences; i++) {
     if (c.alig->saveSequences[i] == -1)
       continue;
-    c.alig->identities[i] = new float[c.alig->originalNumberOfSequences];
+    c.alig->identities[i] = new float[sequences];
     c.alig->identities[i][i] = 0;
   }
 
-  // declare indices
-  int i, j, k, l;
-
-  // Depending on alignment type, indetermination symbol will be one or other
-  char indet = (c.alig->getAlignmentType() & SequenceTypes::AA) ? 'X' : 'N';
-
-  // prepare constant SIMD vectors
-  const Vector ALLINDET = Vector::duplicate(indet);
-  const Vector ALLGAP = Vector::duplicate('-');
-  const Vector ONES = Vector::duplicate(1);
-
-  // create an index of residues to skip
-  uint8_t *skipResidues = aligned_array<uint8_t, Vector>(
-      c.alig->originalNumberOfResidues); // ALIGNED_ALLOC(alig->originalNumberOfResidues,
-                                         // uint8_t);
-  for (k = 0; k < c.alig->originalNumberOfResidues; k++) {
-    skipResidues[k] = c.alig->saveResidues[k] == -1 ? 0xFF : 0;
+  // Reuse the identities computed by a previous trimming for the same
+  // sequences and residues, or compute and store them
+  std::vector<int> key = seqIdentityKey(*c.alig);
+  if (auto cached = context.cache->seqIdentity(key)) {
+    unpackSeqIdentity(*cached, *c.alig);
+  } else {
+    computeSeqIdentity<Vector>(c, context);
+    storeSeqIdentity(*context.cache, std::move(key), *c.alig);
   }
 
-  // For each seq, compute its identity score against the others in the MSA
-  for (i = 0; i < c.alig->originalNumberOfSequences; i++) {
+  // declare indices
+  int i, j;
+
+  // report pairs without any residue in common from the main thread,
+  // in the same order as the sequential loop would have done
+  for (i = 0; i < sequences; i++) {
     if (c.alig->saveSequences[i] == -1)
       continue;
+    for (j = i + 1; j < sequences; j++) {
+      if (c.alig->saveSequences[j] == -1)
+        continue;
+      if (c.alig->identities[i][j] < 0.0F) {
+        debug.report(
+            ErrorCode::NoResidueSequences,
+            new std::string[2]{c.alig->seqsName[i], c.alig->seqsName[j]});
+        c.alig->identities[i][j] = c.alig->identities[j][i] = 0;
+      }
+    }
+  }
+}
+
+// The number of sequences compared in parallel to the representatives by
+// each worker of the greedy clustering.
+const int CLUSTERING_BATCH = 16;
+// The number of identity thresholds tried to get a number of clusters.
+const int CLUSTERING_ITERATIONS = 32;
+
+// Select representative sequences with the greedy clustering of trimAl,
+// only computing the identities between sequences and representatives.
+//
+// Like `Cleaner::calculateRepresentativeSeq`, the sequences are visited
+// from the longest to the shortest, and each sequence becomes the
+// representative of a new cluster unless its identity to one of the
+// representatives selected so far is above the threshold. trimAl reads
+// these identities from the matrix of `calculateSeqIdentity`, which takes
+// O(N^2) comparisons for N sequences, while the search takes O(N*K) for
+// K representatives, and selects exactly the same sequences.
+//
+// To use several threads, the sequences are processed in batches: the
+// sequences of a batch are first compared in parallel to the
+// representatives selected before the batch, and the sequences without a
+// close representative are then compared in order to the representatives
+// selected within the batch. Since a sequence only depends on whether it
+// is close to a previous representative, this selects the same
+// representatives as the sequential loop.
+template <class Vector> class RepresentativeSearch {
+public:
+  RepresentativeSearch(Cleaner &c, const Context &context)
+      : c(c), context(context), masks(context.cache->residueMasks(*c.alig)),
+        keep(masks.words, 0), memoize(false) {
+    const int sequences = c.alig->originalNumberOfSequences;
+    const int residues = c.alig->originalNumberOfResidues;
+    int i, k;
+
+    // create a mask of residues to keep
+    for (k = 0; k < residues; k++) {
+      if (c.alig->saveResidues[k] != -1)
+        keep[k / MASK_BITS] |= 1ULL << (k % MASK_BITS);
+    }
 
-    const uint8_t *datai =
-        reinterpret_cast<const uint8_t *>(c.alig->sequences[i].data());
+    // reuse the identities computed by a previous trimming if any
+    cached = context.cache->seqIdentity(seqIdentityKey(*c.alig));
 
-    // Compute identity scores for the current sequence against the rest
-    for (j = i + 1; j < c.alig->originalNumberOfSequences; j++) {
-      if (c.alig->saveSequences[j] == -1)
+    // sort the retained sequences by length with the sort used by trimAl,
+    // so that sequences of the same length are visited in the same order
+    std::vector<int> storage;
+    std::vector<int *> seqs;
+    for (i = 0; i < sequences; i++) {
+      if (c.alig->saveSequences[i] == -1)
         continue;
+      storage.push_back(utils::removeCharacter('-', c.alig->sequences[i]).size());
+      storage.push_back(i);
+    }
+    for (size_t x = 0; x < storage.size(); x += 2)
+      seqs.push_back(&storage[x]);
+    if (!seqs.empty())
+      utils::quicksort(seqs.data(), 0, (int)seqs.size() - 1);
+    for (auto it = seqs.rbegin(); it != seqs.rend(); ++it)
+      order.push_back((*it)[1]);
+  }
 
-      const uint8_t *dataj =
-          reinterpret_cast<const uint8_t *>(c.alig->sequences[j].data());
-
-      Vector dst_acc = Vector();
-      Vector hit_acc = Vector();
-
-      int hit = 0;
-      int dst = 0;
-
-      // run with unrolled loops of UCHAR_MAX iterations first
-      for (k = 0; ((int)(k + Vector::LANES * UCHAR_MAX)) <
-                  c.alig->originalNumberOfResidues;) {
-        for (l = 0; l < UCHAR_MAX; l++, k += Vector::LANES) {
-          // load data for the sequences
-          Vector seqi = Vector::loadu(&datai[k]);
-          Vector seqj = Vector::loadu(&dataj[k]);
-          Vector skip = Vector::load(&skipResidues[k]);
-          Vector eq = (seqi == seqj);
-          // find which sequence characters are gap or indet
-          Vector gapsi = ((seqi == ALLGAP) | (seqi == ALLINDET));
-          Vector gapsj = ((seqj == ALLGAP) | (seqj == ALLINDET));
-          // find position where not both characters are gap
-          Vector mask = ONES.andnot(gapsi & gapsj).andnot(skip);
-          // update counters
-          dst_acc += mask;
-          hit_acc += (eq & mask);
-        }
-        // merge accumulators
-        dst += dst_acc.sum();
-        hit += hit_acc.sum();
-        dst_acc.clear();
-        hit_acc.clear();
+  // Get the representatives of the clusters at the given identity
+  // threshold, in order of selection, stopping once there are more than
+  // `limit` representatives.
+  std::vector<int> representatives(float threshold, size_t limit) {
+    std::vector<int> reps;
+    if (order.empty())
+      return reps;
+    reps.push_back(order[0]);
+
+    const int threads = std::max(context.threads, 1);
+    const size_t batch = (size_t)threads * CLUSTERING_BATCH;
+    std::vector<char> close(batch);
+    std::vector<std::vector<Pair>> computed(threads);
+
+    for (size_t first = 1; first < order.size(); first += batch) {
+      const size_t last = std::min(first + batch, order.size());
+      const size_t known = reps.size();
+
+      // compare the sequences of the batch to the representatives selected
+      // before the batch, without modifying the stored identities
+      parallel_rows((int)(last - first), threads, [&](int row, int worker) {
+        close[row] = isClose(order[first + row], reps.data(), known,
+                             threshold, computed[worker]);
+      });
+      for (auto &pairs : computed)
+        remember(pairs);
+
+      // compare the other sequences to the representatives selected within
+      // the batch, in order
+      for (size_t x = first; x < last; x++) {
+        if (close[x - first] ||
+            isClose(order[x], reps.data() + known, reps.size() - known,
+                    threshold, computed[0]))
+          continue;
+        reps.push_back(order[x]);
+        if (reps.size() > limit)
+          break;
       }
+      remember(computed[0]);
+      if (reps.size() > limit)
+        break;
+    }
 
-      // run remaining iterations in SIMD while possible
-      for (; ((int)(k + Vector::LANES)) < c.alig->originalNumberOfResidues;
-           k += Vector::LANES) {
-        // load data for the sequences; load is unaligned because
-        // string data is not guaranteed to be aligned.
-        Vector seqi = Vector::loadu(&datai[k]);
-        Vector seqj = Vector::loadu(&dataj[k]);
-        Vector skip = Vector::load(&skipResidues[k]);
-        Vector eq = (seqi == seqj);
-        // find which sequence characters are gap or indet
-        Vector gapsi = ((seqi == ALLGAP) | (seqi == ALLINDET));
-        Vector gapsj = ((seqj == ALLGAP) | (seqj == ALLINDET));
-        // find position where not both characters are gap
-        Vector mask = ONES.andnot(gapsi & gapsj).andnot(skip);
-        // update counters
-        dst_acc += mask;
-        hit_acc += (eq & mask);
-      }
+    return reps;
+  }
 
-      // update counters after last loop
-      hit += hit_acc.sum();
-      dst += dst_acc.sum();
-
-      // process the tail elements when there remain less than
-      // can be fitted in a SIMD vector
-      for (; k < c.alig->originalNumberOfResidues; k++) {
-        int gapi = (datai[k] == indet) || (datai[k] == '-');
-        int gapj = (dataj[k] == indet) || (dataj[k] == '-');
-        dst += (!(gapi && gapj)) && (!skipResidues[k]);
-        hit +=
-            (!(gapi && gapj)) && (!skipResidues[k]) && (datai[k] == dataj[k]);
+  // Get the representatives of `clusters` clusters, searching the identity
+  // threshold giving that many clusters by bisection like
+  // `Cleaner::getCutPointClusters`, which cannot use the statistics of the
+  // whole identity matrix to start the search.
+  std::vector<int> representatives(int clusters) {
+    const size_t n = order.size();
+    // use the thresholds of trimAl for the trivial numbers of clusters
+    if ((size_t)clusters >= n)
+      return representatives(1.0F, n);
+    if (clusters <= 1)
+      return representatives(0.0F, n);
+
+    // keep the identities computed with a threshold for the next ones,
+    // since the longest sequences are representatives for most thresholds
+    memoize = true;
+
+    float lo = 0.0F;
+    float hi = 1.0F;
+    std::vector<int> best;
+    for (int iter = 0; iter < CLUSTERING_ITERATIONS; iter++) {
+      const float threshold = (lo + hi) / 2;
+      std::vector<int> reps = representatives(threshold, clusters);
+      if (reps.size() > (size_t)clusters) {
+        hi = threshold;
+        continue;
       }
+      lo = threshold;
+      if (reps.size() > best.size())
+        best = std::move(reps);
+      if (best.size() == (size_t)clusters)
+        break;
+    }
 
-      if (dst == 0) {
-        debug.report(
-            ErrorCode::NoResidueSequences,
-            new std::string[2]{c.alig->seqsName[i], c.alig->seqsName[j]});
-        c.alig->identities[i][j] = 0;
+    // fall back to the lowest threshold if all thresholds gave too many
+    // clusters
+    if (best.empty())
+      best = representatives(0.0F, n);
+    return best;
+  }
+
+  // Report the pairs of sequences compared without any residue in common,
+  // in the same order as `calculateSeqIdentity`.
+  void report() {
+    std::sort(disjoint.begin(), disjoint.end());
+    disjoint.erase(std::unique(disjoint.begin(), disjoint.end()),
+                   disjoint.end());
+    const uint64_t n = c.alig->originalNumberOfSequences;
+    for (uint64_t pair : disjoint) {
+      debug.report(ErrorCode::NoResidueSequences,
+                   new std::string[2]{c.alig->seqsName[pair / n],
+                                      c.alig->seqsName[pair % n]});
+    }
+  }
+
+private:
+  // An identity computed for a pair of sequences, not stored yet.
+  struct Pair {
+    uint64_t key;
+    float identity;
+  };
+
+  // Check whether sequence `i` is close to one of the `count` given
+  // representatives, recording the new identities in `computed`.
+  bool isClose(int i, const int *reps, size_t count, float threshold,
+               std::vector<Pair> &computed) const {
+    for (size_t r = 0; r < count; r++) {
+      if (identity(i, reps[r], computed) > threshold)
+        return true;
+    }
+    return false;
+  }
+
+  // Get the identity between two sequences, computing it if needed,
+  // and treating pairs without any residue in common as zero.
+  float identity(int i, int j, std::vector<Pair> &computed) const {
+    const uint64_t n = c.alig->originalNumberOfSequences;
+    if (i > j)
+      std::swap(i, j);
+    const uint64_t key = i * n + j;
+
+    float value;
+    if (cached != nullptr) {
+      value = cached->load(i, j);
+      if (value < 0.0F)
+        computed.push_back(Pair{key, value});
+    } else {
+      auto it = identities.find(key);
+      if (it != identities.end()) {
+        value = it->second;
       } else {
-        // Identity score between two sequences is the ratio of identical
-        // residues by the total length (common and no-common residues) among
-        // them
-        c.alig->identities[i][j] = (float)hit / dst;
+        uint32_t hit = 0;
+        uint32_t dst = 0;
+        countSeqIdentity<Vector>(
+            reinterpret_cast<const uint8_t *>(c.alig->sequences[i].data()),
+            reinterpret_cast<const uint8_t *>(c.alig->sequences[j].data()),
+            masks.residueMask(i), masks.residueMask(j), keep.data(), 0,
+            c.alig->originalNumberOfResidues, hit, dst);
+        value = (dst == 0) ? -1.0F : (float)hit / dst;
+        if (memoize || (value < 0.0F))
+          computed.push_back(Pair{key, value});
       }
+    }
 
-      c.alig->identities[j][i] = c.alig->identities[i][j];
+    return std::max(value, 0.0F);
+  }
+
+  // Store the identities computed by a worker.
+  void remember(std::vector<Pair> &computed) {
+    for (const Pair &pair : computed) {
+      identities.emplace(pair.key, pair.identity);
+      if (pair.identity < 0.0F)
+        disjoint.push_back(pair.key);
     }
+    computed.clear();
   }
 
-  // free allocated memory
-  free(skipResidues);
+  Cleaner &c;
+  const Context &context;
+  const ResidueMasks &masks;
+  // the mask of the residues retained in the alignment
+  std::vector<uint64_t> keep;
+  // the full identity matrix computed by a previous trimming, if any
+  AlignmentCache::IdentityValues cached;
+  // whether to keep all the identities computed, or only the pairs
+  // without any residue in common
+  bool memoize;
+  // the identities computed so far, indexed by pair of sequences
+  std::unordered_map<uint64_t, float> identities;
+  // the pairs of sequences without any residue in common
+  std::vector<uint64_t> disjoint;
+  // the retained sequences, from the longest to the shortest
+  std::vector<int> order;
+};
+
+// Get an alignment with the representatives of the clusters of sequences
+// of `c`, either `clusters` clusters, or the clusters at the identity
+// threshold `threshold` if `clusters` is -1. This is the greedy equivalent
+// of `Cleaner::getClustering`.
+template <class Vector>
+inline Alignment *getGreedyClustering(Cleaner &c, int clusters,
+                                      float threshold,
+                                      const Context &context) {
+  ProfileTimer timer(context.profile.get(), ProfileIdentity,
+                     residueBytes(*c.alig));
+
+  RepresentativeSearch<Vector> search(c, context);
+  const std::vector<int> reps =
+      (clusters != -1)
+          ? search.representatives(clusters)
+          : search.representatives(threshold,
+                                   c.alig->originalNumberOfSequences);
+  search.report();
+
+  // keep the representatives in a copy of the alignment
+  Alignment *newAlig = new Alignment(*c.alig);
+  for (int i = 0; i < c.alig->originalNumberOfSequences; i++)
+    newAlig->saveSequences[i] = -1;
+  for (int i : reps)
+    newAlig->saveSequences[i] = i;
+  newAlig->updateSequencesAndResiduesNums();
+  return newAlig;
 }
 
-template <class Vector> inline void calculateGapVectors(statistics::Gaps &g) {
-  int i, j;
-  const Vector ALLGAP = Vector::duplicate('-');
-  const Vector ONES = Vector::duplicate(1);
+// Number of columns counted together by `countGapsInColumn`, so that the
+// partial counts stay in the L1 cache while the sequences are read.
+const int GAP_COLUMNS = 4096;
+
+// Count the gaps in each column of the retained sequences of an alignment,
+// comparing `Vector::LANES` columns at a time to the gap symbol and adding
+// the matches to 8-bit partial counts. The columns that do not fill a
+// whole vector at the end of a block are counted one at a time.
+template <class Vector>
+inline void countGapsInColumn(Alignment &alig, int *gapsInColumn,
+                              const Context &context) {
+  const int sequences = alig.originalNumberOfSequences;
+  const int residues = alig.originalNumberOfResidues;
 
   // use temporary buffer for storing 8-bit partial sums
-  uint8_t *gapsInColumn_u8 =
-      aligned_array<uint8_t, Vector>(g.alig->originalNumberOfResidues);
-  memset(g.gapsInColumn, 0, sizeof(int) * g.alig->originalNumberOfResidues);
-  memset(gapsInColumn_u8, 0,
-         sizeof(uint8_t) * g.alig->originalNumberOfResidues);
-
-  // count gaps per column
-  for (j = 0; j < g.alig->originalNumberOfSequences; j++) {
-    // skip sequences not retained in alignment
-    if (g.alig->saveSequences[j] == -1)
-      continue;
-    // process the whole sequence, 16 lanes at a time
-    const uint8_t *data =
-        reinterpret_cast<const uint8_t *>(g.alig->sequences[j].data());
-    for (i = 0; ((int)(i + Vector::LANES)) < g.alig->originalNumberOfResidues;
-         i += Vector::LANES) {
-      Vector letters = Vector::loadu(&data[i]);
-      Vector counts = Vector::load(&gapsInColumn_u8[i]);
-      counts += (ONES & (letters == ALLGAP));
-      counts.store(&gapsInColumn_u8[i]);
-    }
-    // count the remaining gap elements without SIMD
-    for (; i < g.alig->originalNumberOfResidues; i++)
-      if (data[i] == '-')
-        gapsInColumn_u8[i]++;
-    // every UCHAR_MAX iterations the accumulator may overflow, so the
-    // temporary counts are moved into the final counter array, and the
-    // accumulator is reset
-    if (j % UCHAR_MAX == 0) {
-      for (i = 0; i < g.alig->originalNumberOfResidues; i++)
-        g.gapsInColumn[i] += gapsInColumn_u8[i];
-      memset(gapsInColumn_u8, 0,
-             sizeof(uint8_t) * g.alig->originalNumberOfResidues);
+  uint8_t *partial = context.arena->allocate<uint8_t>(GAP_COLUMNS, Vector::SIZE);
+  const Vector ones = Vector::duplicate(1);
+  const Vector gap = Vector::duplicate('-');
+  memset(gapsInColumn, 0, sizeof(int) * residues);
+
+  // collect the partial counts of the block into the final counts
+  auto collect = [&](int first, int width) {
+    for (int k = 0; k < width; k++)
+      gapsInColumn[first + k] += partial[k];
+    memset(partial, 0, GAP_COLUMNS);
+  };
+
+  for (int first = 0; first < residues; first += GAP_COLUMNS) {
+    const int width = std::min(GAP_COLUMNS, residues - first);
+    // without SIMD, all columns are counted directly
+    const int full =
+        (Vector::LANES > 1) ? width - width % (int)Vector::LANES : 0;
+    memset(partial, 0, GAP_COLUMNS);
+
+    unsigned int processedSequences = 0;
+    for (int j = 0; j < sequences; j++) {
+      // skip sequences not retained in alignment
+      if (alig.saveSequences[j] == -1)
+        continue;
+      const uint8_t *row =
+          reinterpret_cast<const uint8_t *>(alig.sequences[j].data()) + first;
+      for (int i = 0; i < full; i += Vector::LANES) {
+        Vector count = Vector::load(&partial[i]);
+        count += (Vector::loadu(&row[i]) == gap) & ones;
+        count.store(&partial[i]);
+      }
+      for (int i = full; i < width; i++)
+        gapsInColumn[first + i] += (row[i] == '-');
+      // every UCHAR_MAX iterations the partial counts may overflow, so
+      // they are moved into the final counts
+      processedSequences++;
+      if (processedSequences % UCHAR_MAX == 0)
+        collect(first, full);
     }
+    collect(first, full);
   }
-  // collect the remaining partial counts into the final counter array
-  for (i = 0; i < g.alig->originalNumberOfResidues; i++)
-    g.gapsInColumn[i] += gapsInColumn_u8[i];
+}
 
-  // free temporary buffer
-  free(gapsInColumn_u8);
+template <class Vector>
+inline void calculateGapVectors(statistics::Gaps &g, const Context &context) {
+  ProfileTimer timer(context.profile.get(), ProfileGaps,
+                     residueBytes(*g.alig));
+
+  // Reuse the gaps counted by a previous trimming for the same sequences,
+  // or count and store them
+  const int sequences = g.alig->originalNumberOfSequences;
+  std::vector<int> key(g.alig->saveSequences,
+                       g.alig->saveSequences + sequences);
+  if (auto cached = context.cache->gapsInColumn(key)) {
+    std::copy(cached->begin(), cached->end(), g.gapsInColumn);
+  } else {
+    countGapsInColumn<Vector>(*g.alig, g.gapsInColumn, context);
+    context.cache->storeGapsInColumn(
+        std::move(key),
+        std::vector<int>(g.gapsInColumn,
+                         g.gapsInColumn + g.alig->originalNumberOfResidues));
+  }
 
   // build histogram and find largest number of gaps
   for (int i = 0; i < g.alig->originalNumberOfResidues; i++) {
@@ -427,17 +816,50 @@ template <class Vector> inline void calculateGapVectors(statistics::Gaps &g) {
   }
 }
 
+// Number of columns processed together by `calculateSimilarityVectors`.
+const int SIMILARITY_LANES = 16;
+
+// Codes of the characters that are not letters, or not defined in the
+// similarity matrix, in the tables built by `similarityLookup`.
+const int INCORRECT_SYMBOL = -1;
+const int UNDEFINED_SYMBOL = -2;
+
+// Build the table giving the code in the similarity matrix of every
+// character of the `Alphabet`, so that the residues are encoded without
+// any comparison: lowercase letters are folded to uppercase, gaps and
+// indeterminations are given the code following the last residue, and
+// the other characters an error code.
+template <class Alphabet>
+inline void similarityLookup(const statistics::similarityMatrix &matrix,
+                             int lookup[UCHAR_MAX + 1]) {
+  for (int c = 0; c <= UCHAR_MAX; c++) {
+    const char letter = utils::toUpper((char)c);
+    if ((letter == Alphabet::INDET) || (letter == '-'))
+      lookup[c] = matrix.numPositions;
+    else if ((letter < 'A') || (letter > 'Z'))
+      lookup[c] = INCORRECT_SYMBOL;
+    else if (matrix.vhash[letter - 'A'] == -1)
+      lookup[c] = UNDEFINED_SYMBOL;
+    else
+      lookup[c] = matrix.vhash[letter - 'A'];
+  }
+}
+
+// Compute the similarity of each column of `s`, with `identity` the
+// identity matrix of the statistic, which is computed with the virtual
+// `calculateMatrixIdentity` of the backend if it is not set yet.
 template <class Vector>
-inline bool calculateSimilarityVectors(statistics::Similarity &s,
-                                       bool cutByGap) {
+inline bool
+calculateSimilarityVectors(statistics::Similarity &s, bool cutByGap,
+                           const AlignmentCache::IdentityValues &identity,
+                           const Context &context) {
+  ProfileTimer timer(context.profile.get(), ProfileSimilarity,
+                     residueBytes(*s.alig));
+
   // A similarity matrix must be defined. If not, return false
   if (s.simMatrix == nullptr)
     return false;
 
-  // Calculate the matrix identity in case it's not done before
-  if (s.matrixIdentity == nullptr)
-    s.calculateMatrixIdentity();
-
   // Create the variable gaps, in case we want to cut by gaps
   int *gaps = nullptr;
 
@@ -449,114 +871,282 @@ inline bool calculateSimilarityVectors(statistics::Similarity &s,
     gaps = s.alig->Statistics->gaps->getGapsWindow();
   }
 
-  // Initialize the variables used
-  int i, j, k;
-  float num, den;
-
-  // Depending on alignment type, indetermination symbol will be one or other
-  char indet = s.alig->getAlignmentType() & SequenceTypes::AA ? 'X' : 'N';
-
-  // Q temporal value
-  float Q;
-  // Temporal chars that will contain the residues to compare by pair.
-  int numA, numB;
+  const int sequences = s.alig->originalNumberOfSequences;
+  const int residues = s.alig->originalNumberOfResidues;
 
   // Calculate the maximum number of gaps a column can have to calculate it's
   //      similarity
   float gapThreshold = 0.8F * s.alig->numberOfResidues;
 
-  // Cache pointers to matrix rows to avoid dereferencing in inner loops
-  const float *identityRow;
-  const float *distRow;
+  // Set MDK for columns with gaps values bigger or equal to threshold,
+  // and record the other columns for which we need to compute the MDK
+  std::vector<int> columns;
+  columns.reserve(residues);
+  for (int i = 0; i < residues; i++) {
+    if ((gaps != nullptr) && gaps[i] >= gapThreshold)
+      s.MDK[i] = 0.F;
+    else
+      columns.push_back(i);
+  }
 
-  // Create buffers to store column data
-  std::vector<char> colnum =
-      std::vector<char>(s.alig->originalNumberOfSequences);
-  std::vector<char> colgap =
-      std::vector<char>(s.alig->originalNumberOfSequences);
+  // Reuse the similarity of the columns if it was computed by a previous
+  // trimming with the same similarity matrix, and the same columns cut
+  const int format = context.identityFormat;
+  const int samples = context.similaritySample;
+  std::vector<int> key = similarityKey(*s.simMatrix, columns, format, samples);
+  if (auto cached = context.cache->similarityVector(key)) {
+    std::copy(cached->begin(), cached->end(), s.MDK);
+    return true;
+  }
 
-  // For each column calculate the Q value and the MD value using an equation
-  for (i = 0; i < s.alig->originalNumberOfResidues; i++) {
-    // Set MDK for columns with gaps values bigger or equal to threshold
-    if ((gaps != nullptr) && gaps[i] >= gapThreshold) {
-      s.MDK[i] = 0.F;
-      continue;
+  // Select the sequences whose pairs are used to compute the similarity,
+  // and calculate their identity matrix, or the matrix of all sequences
+  // in case it's not done before
+  const std::vector<int> sample = sampleSequences(sequences, samples);
+  const int count = sample.size();
+  std::shared_ptr<const IdentityMatrix> identities;
+  if (count < sequences) {
+    identities = computeMatrixIdentity<Vector>(*s.alig, context, sample);
+  } else {
+    if (!identity)
+      s.calculateMatrixIdentity();
+    identities = identity;
+  }
+
+  // Copy the distance matrix into a table with an additional row and column
+  // for gaps and indeterminations, so that they can be looked up without
+  // branching; `pairs` records whether the entry is made of two residues.
+  const int gapCode = s.simMatrix->numPositions;
+  const int stride = gapCode + 1;
+  std::vector<float> dist(stride * stride, 0.F);
+  std::vector<uint8_t> pairs(stride * stride, 0);
+  for (int a = 0; a < gapCode; a++) {
+    for (int b = 0; b < gapCode; b++) {
+      dist[a * stride + b] = s.simMatrix->distMat[a][b];
+      pairs[a * stride + b] = 1;
     }
+  }
 
-    // Fill the column buffer with the current column and check
-    // characters are well-defined with respect to the similarity matrix
-    for (j = 0; j < s.alig->originalNumberOfSequences; j++) {
-      char letter = utils::toUpper(s.alig->sequences[j][i]);
-      if ((letter == indet) || (letter == '-')) {
-        colgap[j] = 1;
-      } else {
-        colgap[j] = 0;
-        if ((letter < 'A') || (letter > 'Z')) {
-          debug.report(ErrorCode::IncorrectSymbol,
-                       new std::string[1]{std::string(1, letter)});
-          return false;
-        } else if (s.simMatrix->vhash[letter - 'A'] == -1) {
-          debug.report(ErrorCode::UndefinedSymbol,
-                       new std::string[1]{std::string(1, letter)});
-          return false;
-        } else {
-          colnum[j] = s.simMatrix->vhash[letter - 'A'];
-        }
+  // Get the residues in column-major order shared by all statistics
+  const ResidueColumns &data = context.cache->residueColumns(*s.alig);
+
+  // Get the code of every character with the table of the alphabet
+  int lookup[UCHAR_MAX + 1];
+  switch (alphabetType(*s.alig, context.alphabet)) {
+  case AlphabetAminoAcids:
+    similarityLookup<AminoAcids>(*s.simMatrix, lookup);
+    break;
+  default:
+    similarityLookup<Nucleotides>(*s.simMatrix, lookup);
+    break;
+  }
+
+  // Encode the columns of the selected sequences in column-major order,
+  // and check the characters of all sequences are well-defined with
+  // respect to the similarity matrix, in the same order as they would be
+  // checked column by column
+  Arena &arena = *context.arena;
+  uint8_t *codes = arena.allocate<uint8_t>(columns.size() * count);
+  for (size_t c = 0; c < columns.size(); c++) {
+    const char *residuesc = data.column(columns[c]);
+    uint8_t *column = &codes[c * count];
+    for (int j = 0, x = 0; j < sequences; j++) {
+      const int code = lookup[(unsigned char)residuesc[j]];
+      if (code < 0) {
+        const char letter = utils::toUpper(residuesc[j]);
+        debug.report(code == INCORRECT_SYMBOL ? ErrorCode::IncorrectSymbol
+                                              : ErrorCode::UndefinedSymbol,
+                     new std::string[1]{std::string(1, letter)});
+        return false;
       }
+      if ((x < count) && (sample[x] == j))
+        column[x++] = code;
     }
+  }
+
+  // Process the columns by blocks of `SIMILARITY_LANES`, so that each row
+  // of the identity matrix is read once per block rather than once per
+  // column; each lane still accumulates its pairs in the same order as
+  // the column-by-column loop, so the results are exactly the same.
+  const int blocks = (columns.size() + SIMILARITY_LANES - 1) / SIMILARITY_LANES;
+  int threads = context.threads;
+  if (threads > blocks)
+    threads = blocks;
+  if (threads < 1)
+    threads = 1;
+  std::vector<uint8_t *> buffers(threads);
+  std::vector<float *> rows(threads);
+  for (int t = 0; t < threads; t++) {
+    buffers[t] = arena.allocate<uint8_t>(count * SIMILARITY_LANES,
+                                         SIMILARITY_LANES);
+    rows[t] = arena.allocate<float>(count, Vector::SIZE);
+  }
+
+  parallel_rows(blocks, threads, [&](int block, int worker) {
+    // Initialize the variables used
+    int j, k, lane;
+    float num[SIMILARITY_LANES] = {0.F};
+    float den[SIMILARITY_LANES] = {0.F};
+
+    // Transpose the codes of the block so that the codes of all lanes
+    // are contiguous for each sequence, padding with gaps
+    const size_t first = (size_t)block * SIMILARITY_LANES;
+    const int width =
+        std::min<size_t>(SIMILARITY_LANES, columns.size() - first);
+    uint8_t *lanes = buffers[worker];
+    std::fill(lanes, lanes + count * SIMILARITY_LANES, gapCode);
+    for (lane = 0; lane < width; lane++)
+      for (j = 0; j < count; j++)
+        lanes[j * SIMILARITY_LANES + lane] =
+            codes[(first + lane) * count + j];
 
     // For each AAs/Nucleotides' pair in the column we compute its distance
-    for (j = 0, num = 0, den = 0; j < s.alig->originalNumberOfSequences; j++) {
+    for (j = 0; j < count; j++) {
+      const uint8_t *lanesj = &lanes[j * SIMILARITY_LANES];
+
       // We don't compute the distance if the first element is
-      // a indeterminate (XN) or a gap (-) element.
-      if (colgap[j])
+      // a indeterminate (XN) or a gap (-) element in every lane.
+      bool residue = false;
+      for (lane = 0; lane < SIMILARITY_LANES; lane++)
+        residue |= (lanesj[lane] != gapCode);
+      if (!residue)
         continue;
 
-      // Get the index of the first residue
-      // and cache pointers to matrix rows
-      numA = colnum[j];
-      distRow = s.simMatrix->distMat[numA];
-      identityRow = s.matrixIdentity[j];
-
-      for (k = j + 1; k < s.alig->originalNumberOfSequences; k++) {
-        // We don't compute the distance if the second element is
-        //      a indeterminate (XN) or a gap (-) element
-        if (colgap[k])
-          continue;
+      // Cache pointers to matrix rows for the residue of each lane, with
+      // the identities to the following sequences decoded if needed
+      const float *identityRow = identities->row(j, rows[worker]);
+      const float *distRows[SIMILARITY_LANES];
+      const uint8_t *pairRows[SIMILARITY_LANES];
+      for (lane = 0; lane < SIMILARITY_LANES; lane++) {
+        distRows[lane] = &dist[lanesj[lane] * stride];
+        pairRows[lane] = &pairs[lanesj[lane] * stride];
+      }
 
-        // Get the index of the second residue and compute
-        // fraction with identity value for the two pairs and
-        // its distance based on similarity matrix's value.
-        numB = colnum[k];
-        num += identityRow[k] * distRow[numB];
-        den += identityRow[k];
+      for (k = j + 1; k < count; k++) {
+        // Compute fraction with identity value for the two pairs and
+        // its distance based on similarity matrix's value, skipping the
+        // lanes where either element is a gap or an indetermination.
+        const float identity = identityRow[k - j - 1];
+        const uint8_t *lanesk = &lanes[k * SIMILARITY_LANES];
+        for (lane = 0; lane < SIMILARITY_LANES; lane++) {
+          const bool pair = pairRows[lane][lanesk[lane]];
+          num[lane] += pair ? identity * distRows[lane][lanesk[lane]] : 0.F;
+          den[lane] += pair ? identity : 0.F;
+        }
       }
     }
 
-    // If we are processing a column with only one AA/nucleotide, MDK = 0
-    if (den == 0) {
-      s.MDK[i] = 0;
-    } else {
-      Q = num / den;
-      // If the MDK value is more than 1, we normalized this value to 1.
-      //      Only numbers higher than 0 yield exponents higher than 1
-      //      Using this we can test if the result is going to be higher than 1.
-      //      And thus, prevent calculating the exp.
-      // Take in mind that the Q is negative, so we must test if Q is LESSER
-      //      than one, not bigger.
-      if (Q < 0)
-        s.MDK[i] = 1.F;
-      else
-        s.MDK[i] = exp(-Q);
+    for (lane = 0; lane < width; lane++) {
+      const int i = columns[first + lane];
+      // If we are processing a column with only one AA/nucleotide, MDK = 0
+      if (den[lane] == 0) {
+        s.MDK[i] = 0;
+      } else {
+        float Q = num[lane] / den[lane];
+        // If the MDK value is more than 1, we normalized this value to 1.
+        //      Only numbers higher than 0 yield exponents higher than 1
+        //      Using this we can test if the result is going to be higher
+        //      than 1. And thus, prevent calculating the exp.
+        // Take in mind that the Q is negative, so we must test if Q is
+        //      LESSER than one, not bigger.
+        if (Q < 0)
+          s.MDK[i] = 1.F;
+        else
+          s.MDK[i] = exp(-Q);
+      }
     }
+  });
+
+  context.cache->storeSimilarityVector(
+      std::move(key), std::vector<float>(s.MDK, s.MDK + residues));
+
+  return true;
+}
+
+// Apply a window of `halfWindow` columns on each side to the gaps of the
+// columns, like `Gaps::applyWindow`, reflecting the window at the ends of
+// the alignment. The window sums are obtained from the prefix sums of the
+// gaps in a single pass, so that the cost doesn't depend on the window size,
+// and since the gaps are integers, the sums are exactly the same; the
+// averages are rounded like `utils::roundInt`, and the histogram of the
+// windowed gaps is rebuilt, as `Gaps::calcCutPoint` reads it.
+inline bool applyGapWindow(statistics::Gaps &g, int halfWindow,
+                           const Context &context) {
+  const int residues = g.alig->originalNumberOfResidues;
+
+  // Let trimAl report the windows too large for the alignment
+  if (halfWindow > residues / 4)
+    return g.Gaps::applyWindow(halfWindow);
+
+  // Save the window size
+  g.halfWindow = halfWindow;
+  const int window = 2 * halfWindow + 1;
+
+  // Compute the prefix sums of the gaps, `prefix[i]` being the number of
+  // gaps in the columns before column `i`
+  int64_t *prefix = context.arena->allocate<int64_t>(residues + 1);
+  prefix[0] = 0;
+  for (int i = 0; i < residues; i++)
+    prefix[i + 1] = prefix[i] + g.gapsInColumn[i];
+
+  // Reset the number of columns with each number of gaps
+  for (int i = 0; i <= g.alig->numberOfSequences; i++)
+    g.numColumnsWithGaps[i] = 0;
+
+  // Sum the columns of each window inside the alignment, plus the columns
+  // reflected around the first or the last column, which can't both be
+  // needed since the half window is at most a quarter of the alignment
+  for (int i = 0; i < residues; i++) {
+    const int first = std::max(i - halfWindow, 0);
+    const int last = std::min(i + halfWindow, residues - 1);
+    int64_t sum = prefix[last + 1] - prefix[first];
+    if (i - halfWindow < 0)
+      sum += prefix[halfWindow - i + 1] - prefix[1];
+    if (i + halfWindow >= residues)
+      sum += prefix[residues - 1] - prefix[2 * residues - i - halfWindow - 2];
+    g.gapsWindow[i] = (int)((double)sum / window + 0.5);
+    g.numColumnsWithGaps[g.gapsWindow[i]]++;
   }
 
-  // Free the identity matrix now that it's not useful anymore
-  for (int i = 0; i < s.alig->originalNumberOfSequences; i++)
-    delete[] s.matrixIdentity[i];
-  delete[] s.matrixIdentity;
-  s.matrixIdentity = nullptr;
+  return true;
+}
+
+// Apply a window of `halfWindow` columns on each side to the similarity of
+// the columns, like `Similarity::applyWindow`. A running or prefix sum
+// would round the windowed values differently than trimAl does, so each
+// window is still summed in the same order, but one offset at a time for
+// all the columns, so that the inner loop is contiguous and branchless,
+// and only the columns near the ends of the alignment are reflected.
+inline bool applySimilarityWindow(statistics::Similarity &s, int halfWindow) {
+  const int residues = s.alig->originalNumberOfResidues;
+
+  // Let trimAl report the windows too large for the alignment
+  if (halfWindow > residues / 4)
+    return s.Similarity::applyWindow(halfWindow);
+
+  // Save the window size
+  s.halfWindow = halfWindow;
+  const int window = 2 * halfWindow + 1;
+
+  float *windowed = s.MDK_Window;
+  const float *mdk = s.MDK;
+  std::fill(windowed, windowed + residues, 0.F);
+  for (int offset = -halfWindow; offset <= halfWindow; offset++) {
+    // Columns whose window column is inside the alignment
+    const int first = std::max(-offset, 0);
+    const int last = std::min(residues, residues - offset);
+    for (int i = 0; i < first; i++)
+      windowed[i] += mdk[-(i + offset)];
+    for (int i = first; i < last; i++)
+      windowed[i] += mdk[i + offset];
+    for (int i = last; i < residues; i++)
+      windowed[i] += mdk[2 * residues - (i + offset) - 2];
+  }
+  for (int i = 0; i < residues; i++)
+    windowed[i] = windowed[i] / (float)window;
 
   return true;
 }
+} // namespace
+
 } // namespace simd
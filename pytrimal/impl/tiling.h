@@ -0,0 +1,84 @@
+#ifndef _PYTRIMAL_IMPL_TILING
+#define _PYTRIMAL_IMPL_TILING
+
+#include <cstddef>
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#elif defined(__unix__)
+#include <unistd.h>
+#endif
+
+#include "bits.h"
+
+namespace simd {
+
+// Cache size assumed when it cannot be detected at runtime.
+const size_t DEFAULT_CACHE_SIZE = 256 * 1024;
+
+// Maximum number of sequences grouped in a tile.
+const int MAX_TILE_ROWS = 32;
+
+// Detect the size of the L2 data cache of the host, in bytes.
+static inline size_t detect_cache_size() {
+#if defined(__APPLE__)
+  size_t size = 0;
+  size_t length = sizeof(size);
+  if (sysctlbyname("hw.l2cachesize", &size, &length, nullptr, 0) == 0 &&
+      size > 0)
+    return size;
+#elif defined(_SC_LEVEL2_CACHE_SIZE)
+  long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (size > 0)
+    return static_cast<size_t>(size);
+#endif
+  return DEFAULT_CACHE_SIZE;
+}
+
+// Get the size of the L2 data cache, detected once per backend.
+static inline size_t cache_size() {
+  static const size_t size = detect_cache_size();
+  return size;
+}
+
+// The dimensions of a tile, i.e. a block of sequences processed over a
+// block of columns while their data stays in cache.
+struct Tile {
+  int rows;
+  int columns;
+};
+
+// Compute the tile dimensions for an alignment of `sequences` rows and
+// `residues` columns, where each cell of a tile row needs `cellBytes`
+// bytes of working memory. At least `threads * 4` row blocks are created
+// when possible so that workers have enough tiles to balance the load,
+// and columns are rounded to whole residue mask words (which are made of
+// whole SIMD vectors) so only the last tile of a row ever needs a tail loop.
+static inline Tile tile_size(int sequences, int residues, size_t cellBytes,
+                             int threads = 1) {
+  Tile tile;
+
+  tile.rows = threads > 1 ? sequences / (4 * threads) : sequences;
+  if (tile.rows > MAX_TILE_ROWS)
+    tile.rows = MAX_TILE_ROWS;
+  if (tile.rows < 1)
+    tile.rows = 1;
+
+  // use half of the cache for the tile, leaving room for the row it is
+  // compared against and for the accumulators
+  size_t columns = (cache_size() / 2) / (tile.rows * cellBytes + 1);
+  columns -= columns % MASK_BITS;
+  if (columns < static_cast<size_t>(MASK_BITS))
+    columns = MASK_BITS;
+  if (columns >= static_cast<size_t>(residues))
+    tile.columns = residues;
+  else
+    tile.columns = static_cast<int>(columns);
+
+  return tile;
+}
+
+} // namespace simd
+
+#endif
@@ -32,7 +32,8 @@
     This file contains a modified version of the trimAl report manager that
     emits exceptions and warnings with the Python C API. It requires functions
     that can raise exceptions to be declared as such in the Cython `.pxd`
-    files.
+    files. Reports emitted while a `simd::ReportCapture` is active on the
+    current thread are stored in the capture instead.
 
 ***************************************************************************** */
 
@@ -41,6 +42,8 @@
 #include "InternalBenchmarker.h"
 #include "reportsystem.h"
 
+#include "reports.h"
+
 static PyObject *error_from_errorcode(ErrorCode code) {
   switch (code) {
   case UnknownCharacter:
@@ -54,6 +57,63 @@ static PyObject *error_from_errorcode(ErrorCode code) {
 
 reporting::reportManager debug = reporting::reportManager();
 
+// The capture of the current thread, if any; each thread has its own so that
+// alignments can be trimmed concurrently without sharing any report state.
+static thread_local simd::ReportCapture *capture = nullptr;
+
+simd::ReportCapture::ReportCapture()
+    : active(false), previous(nullptr), error(false),
+      errorCode(ErrorCode::SomethingWentWrong_reportToDeveloper) {}
+
+simd::ReportCapture::~ReportCapture() {
+  if (active)
+    stop();
+}
+
+void simd::ReportCapture::start() {
+  if (active)
+    return;
+  previous = capture;
+  capture = this;
+  active = true;
+}
+
+void simd::ReportCapture::stop() {
+  if (!active)
+    return;
+  capture = previous;
+  previous = nullptr;
+  active = false;
+}
+
+simd::ReportCapture *simd::ReportCapture::current() { return capture; }
+
+void simd::ReportCapture::reportError(ErrorCode code,
+                                      const std::string &message) {
+  // only the last error is kept, like the Python error indicator would do
+  error = true;
+  errorCode = code;
+  errorMessage = message;
+}
+
+void simd::ReportCapture::reportWarning(const std::string &message) {
+  warnings.push_back(message);
+}
+
+int simd::ReportCapture::restore() {
+  for (const std::string &warning : warnings) {
+    if (PyErr_WarnEx(PyExc_RuntimeWarning, warning.c_str(), 1) == -1)
+      return -1;
+  }
+  warnings.clear();
+  if (error) {
+    error = false;
+    PyErr_SetString(error_from_errorcode(errorCode), errorMessage.c_str());
+    return -1;
+  }
+  return 0;
+}
+
 void reporting::reportManager::PrintCodesAndMessages() {
   // Create a timer that will report times upon its destruction
   //	which means the end of the current scope.
@@ -103,6 +163,11 @@ void reporting::reportManager::report(ErrorCode message, std::string *vars) {
     delete[] vars;
   }
 
+  if (capture != nullptr) {
+    capture->reportError(message, s);
+    return;
+  }
+
   PyGILState_STATE state = PyGILState_Ensure();
   PyErr_SetString(error_from_errorcode(message), s.c_str());
   PyGILState_Release(state);
@@ -124,6 +189,11 @@ void reporting::reportManager::report(ErrorCode message, const char *vars) {
       s.replace(index, FindWord.length(), Vars);
   }
 
+  if (capture != nullptr) {
+    capture->reportError(message, s);
+    return;
+  }
+
   PyGILState_STATE state = PyGILState_Ensure();
   PyErr_SetString(error_from_errorcode(message), s.c_str());
   PyGILState_Release(state);
@@ -146,6 +216,11 @@ void reporting::reportManager::report(WarningCode message, std::string *vars) {
     delete[] vars;
   }
 
+  if (capture != nullptr) {
+    capture->reportWarning(s);
+    return;
+  }
+
   PyGILState_STATE state = PyGILState_Ensure();
   PyErr_WarnEx(PyExc_RuntimeWarning, s.c_str(), 1);
   PyGILState_Release(state);
@@ -167,6 +242,11 @@ void reporting::reportManager::report(WarningCode message, const char *vars) {
       s.replace(index, FindWord.length(), Vars);
   }
 
+  if (capture != nullptr) {
+    capture->reportWarning(s);
+    return;
+  }
+
   PyGILState_STATE state = PyGILState_Ensure();
   PyErr_WarnEx(PyExc_RuntimeWarning, s.c_str(), 1);
   PyGILState_Release(state);
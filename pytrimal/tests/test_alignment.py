@@ -1,3 +1,4 @@
+import gzip
 import io
 import os
 import sys
@@ -18,6 +19,7 @@ except ImportError:
     pyhmmer = None
 
 from .. import Alignment, TrimmedAlignment
+from .._trimal import _GZIP_BUILD_SUPPORT, _ZSTD_BUILD_SUPPORT
 
 
 DATA = {
@@ -169,6 +171,59 @@ class TestAlignment(unittest.TestCase):
             s.getvalue().decode().splitlines(), [">seq1", "MVVK", ">seq2", "MVYK"]
         )
 
+    def test_dump_fileobj_large(self):
+        # use an alignment larger than the buffers of the file-object wrappers
+        names = [f"seq{i}".encode() for i in range(100)]
+        sequences = ["MVVK" * 1000, "MVYK" * 1000] * 50
+        ali = Alignment(names, sequences)
+        s = io.BytesIO()
+        ali.dump(s)
+        s.seek(0)
+        ali2 = Alignment.load(s, "fasta")
+        self.assertEqual(ali2.names, names)
+        self.assertEqual(list(ali2.sequences), sequences)
+
+    def test_dump_fileobj_error(self):
+        class Handle(io.RawIOBase):
+            def writable(self):
+                return True
+            def write(self, b):
+                raise OSError("disk full")
+        ali = Alignment([b"seq1", b"seq2"], ["MVVK", "MVYK"])
+        self.assertRaises(OSError, ali.dump, Handle())
+
+    @unittest.skipUnless(_GZIP_BUILD_SUPPORT, "built without zlib")
+    def test_dump_filename_gzip(self):
+        ali = Alignment([b"seq1", b"seq2"], ["MVVK", "MVYK"])
+        with tempfile.NamedTemporaryFile(suffix=".fa.gz") as tmp:
+            ali.dump(tmp.name, compression="gzip")
+            with gzip.open(tmp.name, "rt") as f:
+                self.assertEqual(f.read(), ali.dumps())
+
+    @unittest.skipUnless(_GZIP_BUILD_SUPPORT, "built without zlib")
+    def test_dump_fileobj_gzip(self):
+        names = [f"seq{i}".encode() for i in range(100)]
+        sequences = ["MVVK" * 1000, "MVYK" * 1000] * 50
+        ali = Alignment(names, sequences)
+        s = io.BytesIO()
+        ali.dump(s, compression="gzip")
+        self.assertEqual(gzip.decompress(s.getvalue()).decode(), ali.dumps())
+
+    @unittest.skipUnless(_ZSTD_BUILD_SUPPORT, "built without zstd")
+    def test_dump_zstd(self):
+        ali = Alignment([b"seq1", b"seq2"], ["MVVK", "MVYK"])
+        s = io.BytesIO()
+        ali.dump(s, "clustal", compression="zstd")
+        self.assertEqual(s.getvalue()[:4], b"\x28\xb5\x2f\xfd")
+        s.seek(0)
+        ali2 = Alignment.load(s, "clustal")
+        self.assertEqual(ali2.names, ali.names)
+        self.assertEqual(list(ali2.sequences), list(ali.sequences))
+
+    def test_dump_compression_error(self):
+        ali = Alignment([b"seq1", b"seq2"], ["MVVK", "MVYK"])
+        self.assertRaises(ValueError, ali.dump, io.BytesIO(), compression="lzma")
+
     def test_dump_filename(self):
         ali = Alignment([b"seq1", b"seq2"], ["MVVK", "MVYK"])
         s = ali.dumps()
@@ -179,6 +234,16 @@ class TestAlignment(unittest.TestCase):
         s = ali.dumps()
         self.assertEqual(s.splitlines(), [">seq1", "MVVK", ">seq2", "MVYK"])
 
+    def test_dumps_wrap(self):
+        # FASTA records are wrapped at 60 residues, without blank lines
+        for length in (59, 60, 61, 120, 150):
+            ali = Alignment([b"seq1", b"seq2"], ["M" * length, "K" * length])
+            lines = ali.dumps().splitlines()
+            self.assertEqual(lines.count(">seq2"), 1)
+            self.assertEqual(lines.index(">seq2"), 1 + (length + 59) // 60)
+            self.assertEqual("".join(lines[1:lines.index(">seq2")]), "M" * length)
+            self.assertTrue(all(0 < len(line) <= 60 for line in lines))
+
     def _test_load_filename(self, format):
         with tempfile.NamedTemporaryFile(suffix=format, mode="wb") as tmp:
             tmp.write(DATA[format].lstrip().encode())
@@ -196,6 +261,54 @@ class TestAlignment(unittest.TestCase):
     def test_load_filename_fasta(self):
         self._test_load_filename("fasta")
 
+    def test_load_filename_fasta_wrapped(self):
+        # FASTA files are memory-mapped and parsed without trimAl, so make
+        # sure headers, line breaks and blank lines are handled consistently
+        lines = ["", ""]
+        for name, sequence in zip(self.alignment.names, self.alignment.sequences):
+            lines.append(">{} some description".format(name.decode()))
+            lines.extend(sequence[i:i+10] for i in range(0, len(sequence), 10))
+        with tempfile.NamedTemporaryFile(suffix="fasta", mode="wb") as tmp:
+            tmp.write("\r\n".join(lines).encode())
+            tmp.flush()
+            ali = self.type.load(tmp.name)
+        self.assertEqual(ali.names, self.alignment.names)
+        self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    def _test_load_filename_gzip(self, format):
+        # the compression is detected from the magic bytes of the file
+        with tempfile.NamedTemporaryFile(suffix=format, mode="wb") as tmp:
+            tmp.write(gzip.compress(DATA[format].lstrip().encode()))
+            tmp.flush()
+            ali = self.type.load(tmp.name)
+        self.assertEqual(ali.names, self.alignment.names)
+        self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    @unittest.skipUnless(_GZIP_BUILD_SUPPORT, "built without zlib")
+    def test_load_filename_gzip_fasta(self):
+        self._test_load_filename_gzip("fasta")
+
+    @unittest.skipUnless(_GZIP_BUILD_SUPPORT, "built without zlib")
+    def test_load_filename_gzip_clustal(self):
+        self._test_load_filename_gzip("clustal")
+
+    @unittest.skipUnless(_GZIP_BUILD_SUPPORT, "built without zlib")
+    def test_load_fileobj_gzip(self):
+        # concatenated gzip members are decompressed as a single stream
+        data = DATA["nexus"].lstrip().encode()
+        half = len(data) // 2
+        compressed = gzip.compress(data[:half]) + gzip.compress(data[half:])
+        for compression in (None, "gzip"):
+            ali = self.type.load(io.BytesIO(compressed), "nexus", compression=compression)
+            self.assertEqual(ali.names, self.alignment.names)
+            self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    @unittest.skipUnless(_GZIP_BUILD_SUPPORT, "built without zlib")
+    def test_load_gzip_errors(self):
+        data = gzip.compress(DATA["fasta"].lstrip().encode())
+        self.assertRaises(RuntimeError, self.type.load, io.BytesIO(data[:-10]), "fasta")
+        self.assertRaises(ValueError, self.type.load, io.BytesIO(data), "fasta", compression="lzma")
+
     def test_load_filename_clustal(self):
         self._test_load_filename("clustal")
 
@@ -223,6 +336,43 @@ class TestAlignment(unittest.TestCase):
     def test_load_fileobj_nexus(self):
         self._test_load_fileobj("nexus")
 
+    def _test_iter_load_fileobj(self, format, separator=""):
+        data = (DATA[format].lstrip() + separator) * 3
+        # use a non-seekable stream, like a pipe would be
+        r, w = os.pipe()
+        with os.fdopen(r, "rb") as reader:
+            with os.fdopen(w, "wb") as writer:
+                writer.write(data.encode())
+            alignments = list(Alignment.iter_load(reader, format))
+        self.assertEqual(len(alignments), 3)
+        for ali in alignments:
+            self.assertEqual(ali.names, self.alignment.names)
+            self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    def test_iter_load_fileobj_fasta(self):
+        self._test_iter_load_fileobj("fasta", "\n")
+
+    def test_iter_load_fileobj_clustal(self):
+        self._test_iter_load_fileobj("clustal")
+
+    def test_iter_load_fileobj_phylip(self):
+        self._test_iter_load_fileobj("phylip")
+
+    def test_iter_load_filename(self):
+        with tempfile.NamedTemporaryFile(suffix="fasta", mode="wb") as tmp:
+            tmp.write((DATA["fasta"].lstrip() + "\n").encode() * 2)
+            tmp.flush()
+            alignments = list(Alignment.iter_load(tmp.name, "fasta"))
+        self.assertEqual(len(alignments), 2)
+        for ali in alignments:
+            self.assertEqual(ali.names, self.alignment.names)
+            self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    def test_iter_load_errors(self):
+        self.assertRaises(FileNotFoundError, next, Alignment.iter_load("nothing"))
+        self.assertRaises(ValueError, next, Alignment.iter_load(io.BytesIO(), "pir"))
+        self.assertRaises(ValueError, next, Alignment.iter_load(io.BytesIO(), "nonsense"))
+
     def test_load_errors(self):
         self.assertRaises(FileNotFoundError, self.type.load, "nothing")
         self.assertRaises(IsADirectoryError, self.type.load, os.getcwd())
@@ -239,6 +389,11 @@ class TestAlignment(unittest.TestCase):
         with self.assertRaises(IndexError):
             self.alignment.residues[-100]
 
+    def test_residues_sequences(self):
+        sequences = list(self.alignment.sequences)
+        for i, column in enumerate(self.alignment.residues):
+            self.assertEqual(column, "".join(seq[i] for seq in sequences))
+
     def test_residues_slice(self):
         res = self.alignment.residues
         self.assertEqual(list(res[:30:3]), list(res)[:30:3])
@@ -323,6 +478,49 @@ class TestAlignment(unittest.TestCase):
         self.assertEqual(list(msa.alignment), list(self.alignment.sequences))
         self.assertEqual(list(msa.names), list(self.alignment.names))
 
+    def test_from_buffer(self):
+        data = "".join(self.alignment.sequences).encode()
+        shape = (len(self.alignment.sequences), len(self.alignment.residues))
+        ali = self.type.from_buffer(self.alignment.names, memoryview(data).cast("B", shape))
+        self.assertIsInstance(ali, self.type)
+        self.assertEqual(ali.names, self.alignment.names)
+        self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    @unittest.skipUnless(sys.implementation.name == "cpython", "buffer protocol unsupported")
+    def test_from_buffer_strided(self):
+        ali = self.type.from_buffer(self.alignment.names, memoryview(self.alignment))
+        self.assertEqual(ali.names, self.alignment.names)
+        self.assertEqual(list(ali.sequences), list(self.alignment.sequences))
+
+    def test_from_buffer_errors(self):
+        data = memoryview(b"MVVKMVY1").cast("B", (2, 4))
+        self.assertRaises(ValueError, self.type.from_buffer, [b"seq1"], data)
+        self.assertRaises(ValueError, self.type.from_buffer, [b"seq1", b"seq2"], data)
+
+    @unittest.skipUnless(sys.implementation.name == "cpython", "buffer protocol unsupported")
+    def test_memoryview(self):
+        view = memoryview(self.alignment)
+        self.assertTrue(view.readonly)
+        self.assertEqual(view.format, "B")
+        self.assertEqual(view.shape, (len(self.alignment.sequences), len(self.alignment.residues)))
+        self.assertEqual(
+            [bytes(row).decode() for row in view.tolist()],
+            list(self.alignment.sequences),
+        )
+
+
+    def test_clear_cache(self):
+        copy = self.alignment.copy()
+        self.alignment.clear_cache()
+        self.assertEqual(list(self.alignment.residues), list(copy.residues))
+
+    @unittest.skipUnless(sys.implementation.name == "cpython", "buffer protocol unsupported")
+    def test_clear_cache_exported(self):
+        view = memoryview(self.alignment)
+        self.assertRaises(BufferError, self.alignment.clear_cache)
+        view.release()
+        self.alignment.clear_cache()
+
 
 class TestTrimmedAlignment(TestAlignment):
     def setUp(self):
@@ -353,6 +551,11 @@ class TestTrimmedAlignment(TestAlignment):
         with self.assertRaises(IndexError):
             self.trimmed.residues[-100]
 
+    def test_residues_sequences(self):
+        sequences = list(self.trimmed.sequences)
+        for i, column in enumerate(self.trimmed.residues):
+            self.assertEqual(column, "".join(seq[i] for seq in sequences))
+
     def test_sequences(self):
         self.assertEqual(len(self.trimmed.sequences), 5)
         self.assertEqual(
@@ -377,7 +580,34 @@ class TestTrimmedAlignment(TestAlignment):
             "".join([x for x, c in zip(original.sequences[0], mask) if c]),
         )
 
+    def test_dumps_trimmed(self):
+        lines = self.trimmed.dumps().splitlines()
+        expected = []
+        for name, sequence in zip(self.trimmed.names, self.trimmed.sequences):
+            expected.append(">{}".format(name.decode()))
+            expected.append(sequence)
+        self.assertEqual(lines, expected)
+        s = io.BytesIO()
+        self.trimmed.dump(s)
+        self.assertEqual(s.getvalue().decode(), self.trimmed.dumps())
+
     def test_sequences_mask(self):
         mask = self.trimmed.sequences_mask
         original = self.trimmed.original_alignment()
         self.assertEqual(len(mask), len(original.sequences))
+        self.assertEqual(mask.tolist(), [True, True, False, True, True, True])
+        self.assertIs(mask[2], False)
+        self.assertTrue(mask.readonly)
+
+    @unittest.skipUnless(sys.implementation.name == "cpython", "buffer protocol unsupported")
+    def test_memoryview_trimmed(self):
+        # the buffer exposes the original residues, to select with the masks
+        view = memoryview(self.trimmed).tolist()
+        rows = [row for row, keep in zip(view, self.trimmed.sequences_mask) if keep]
+        self.assertEqual(
+            [
+                "".join(chr(c) for c, keep in zip(row, self.trimmed.residues_mask) if keep)
+                for row in rows
+            ],
+            list(self.trimmed.sequences),
+        )
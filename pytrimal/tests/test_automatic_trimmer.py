@@ -4,16 +4,16 @@ import sys
 import json
 import unittest
 
-from .. import _trimal, Alignment, AutomaticTrimmer, SimilarityMatrix
+from .. import _trimal, Alignment, AutomaticTrimmer, SimilarityMatrix, TrimmedAlignment
 from ._base import TrimmerTestCase, files
 
 
 class TestAutomaticTrimmer(TrimmerTestCase, unittest.TestCase):
 
-    def _test_method(self, name):
+    def _test_method(self, name, threads=1):
         ali = self._load_alignment("ENOG411BWBU.fasta")
         expected = self._load_alignment("ENOG411BWBU.{}.fasta".format(name))
-        trimmer = AutomaticTrimmer(method=name, backend=self.backend)
+        trimmer = AutomaticTrimmer(method=name, backend=self.backend, threads=threads)
         trimmed = trimmer.trim(ali)
         self.assertTrimmedAlignmentEqual(trimmed, expected)
 
@@ -21,6 +21,20 @@ class TestAutomaticTrimmer(TrimmerTestCase, unittest.TestCase):
         self.assertRaises(ValueError, AutomaticTrimmer, method="nonsense")
         self.assertRaises(TypeError, AutomaticTrimmer, method=1)
 
+    def test_invalid_threads(self):
+        self.assertRaises(ValueError, AutomaticTrimmer, threads=-1)
+        self.assertRaises(TypeError, AutomaticTrimmer, threads="4")
+
+    def test_invalid_identity_format(self):
+        self.assertRaises(ValueError, AutomaticTrimmer, identity_format="float64")
+        self.assertRaises(TypeError, AutomaticTrimmer, identity_format=16)
+
+    def test_invalid_similarity_sample(self):
+        self.assertRaises(ValueError, AutomaticTrimmer, similarity_sample=0)
+        self.assertRaises(ValueError, AutomaticTrimmer, similarity_sample=1)
+        self.assertRaises(ValueError, AutomaticTrimmer, similarity_sample=-1)
+        self.assertRaises(TypeError, AutomaticTrimmer, similarity_sample="4")
+
     def test_repr(self):
         trimmer = AutomaticTrimmer("strict")
         self.assertEqual(repr(trimmer), "AutomaticTrimmer('strict')")
@@ -30,6 +44,16 @@ class TestAutomaticTrimmer(TrimmerTestCase, unittest.TestCase):
         self.assertEqual(
             repr(trimmer), "AutomaticTrimmer('noduplicateseqs', backend=None)"
         )
+        trimmer = AutomaticTrimmer("strict", threads=4)
+        self.assertEqual(repr(trimmer), "AutomaticTrimmer('strict', threads=4)")
+        trimmer = AutomaticTrimmer("strict", identity_format="float16")
+        self.assertEqual(
+            repr(trimmer), "AutomaticTrimmer('strict', identity_format='float16')"
+        )
+        trimmer = AutomaticTrimmer("strict", similarity_sample=100)
+        self.assertEqual(
+            repr(trimmer), "AutomaticTrimmer('strict', similarity_sample=100)"
+        )
 
     @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
     @unittest.skipUnless(files, "importlib.resources.files not available")
@@ -41,6 +65,134 @@ class TestAutomaticTrimmer(TrimmerTestCase, unittest.TestCase):
     def test_strictplus_method(self):
         self._test_method("strictplus")
 
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_strict_method_threads(self):
+        self._test_method("strict", threads=4)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_identity_format(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        for identity_format in ("float16", "uint16"):
+            trimmer = AutomaticTrimmer(
+                "strict", backend=self.backend, identity_format=identity_format
+            )
+            self.assertEqual(trimmer.identity_format, identity_format)
+            trimmed = trimmer.trim(ali)
+            self.assertEqual(len(trimmed.names), len(ali.names))
+            pickled = pickle.loads(pickle.dumps(trimmer))
+            self.assertEqual(pickled.identity_format, identity_format)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_similarity_sample(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        expected = self._load_alignment("ENOG411BWBU.strict.fasta")
+        # sampling more sequences than available uses all the pairs
+        trimmer = AutomaticTrimmer(
+            "strict", backend=self.backend, similarity_sample=len(ali.names)
+        )
+        self.assertEqual(trimmer.similarity_sample, len(ali.names))
+        self.assertTrimmedAlignmentEqual(trimmer.trim(ali), expected)
+        pickled = pickle.loads(pickle.dumps(trimmer))
+        self.assertEqual(pickled.similarity_sample, len(ali.names))
+        # sampling is deterministic
+        trimmer = AutomaticTrimmer("strict", backend=self.backend, similarity_sample=4)
+        self.assertTrimmedAlignmentEqual(trimmer.trim(ali), trimmer.trim(ali.copy()))
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_shared_alignment(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        for name in ("strict", "gappyout", "strict", "noallgaps"):
+            expected = self._load_alignment("ENOG411BWBU.{}.fasta".format(name))
+            trimmer = AutomaticTrimmer(method=name, backend=self.backend)
+            self.assertTrimmedAlignmentEqual(trimmer.trim(ali), expected)
+            self.assertTrimmedAlignmentEqual(trimmer.trim(ali.copy()), expected)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_trim_many(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        expected = self._load_alignment("ENOG411BWBU.strict.fasta")
+        trimmer = AutomaticTrimmer(method="strict", backend=self.backend)
+        inputs = [ali, ali.copy(), trimmer.trim(ali), ali]
+        outputs = list(trimmer.trim_many(inputs, threads=2))
+        self.assertEqual(len(outputs), len(inputs))
+        for output, alignment in zip(outputs, inputs):
+            self.assertTrimmedAlignmentEqual(output, trimmer.trim(alignment))
+        self.assertTrimmedAlignmentEqual(outputs[0], expected)
+        self.assertEqual(list(trimmer.trim_many([], threads=4)), [])
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_trim_methods(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        methods = ["gappyout", "strict", "strictplus", "automated1", "strict"]
+        trimmer = AutomaticTrimmer(backend=self.backend)
+        outputs = trimmer.trim_methods(ali, methods)
+        self.assertEqual(len(outputs), len(methods))
+        for output, method in zip(outputs, methods):
+            expected = self._load_alignment("ENOG411BWBU.{}.fasta".format(method))
+            self.assertTrimmedAlignmentEqual(output, expected)
+        # trimmed alignments are compacted once for all methods
+        trimmed = trimmer.trim(ali)
+        outputs = trimmer.trim_methods(trimmed, ["gappyout", "strict"])
+        for output, method in zip(outputs, ["gappyout", "strict"]):
+            expected = AutomaticTrimmer(method, backend=self.backend).trim(trimmed)
+            self.assertTrimmedAlignmentEqual(output, expected)
+        self.assertEqual(trimmer.trim_methods(ali, []), [])
+        self.assertRaises(ValueError, trimmer.trim_methods, ali, ["strict", "nonsense"])
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_trim_outlives_input(self):
+        expected = self._load_alignment("ENOG411BWBU.strict.fasta")
+        trimmer = AutomaticTrimmer(method="strict", backend=self.backend)
+        trimmed = trimmer.trim(self._load_alignment("ENOG411BWBU.fasta"))
+        copy = trimmed.copy()
+        original = trimmed.original_alignment()
+        del trimmed
+        self.assertTrimmedAlignmentEqual(copy, expected)
+        self.assertTrimmedAlignmentEqual(trimmer.trim(original), expected)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_trim_trimmed(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        trimmer = AutomaticTrimmer(method="strict", backend=self.backend)
+        trimmed = trimmer.trim(ali)
+        rebuilt = Alignment(trimmed.names, trimmed.sequences)
+        self.assertTrimmedAlignmentEqual(trimmer.trim(trimmed), trimmer.trim(rebuilt))
+
+    def test_trim_many_invalid_characters(self):
+        valid = Alignment([b"seq1", b"seq2"], ["MKKAY", "MKKAY"])
+        invalid = Alignment([b"seq1", b"seq2"], ["MKKBO", "MKKAY"])
+        trimmer = AutomaticTrimmer(method="strict", backend=self.backend)
+        results = trimmer.trim_many([valid, invalid, valid], threads=2)
+        self.assertIsInstance(next(results), TrimmedAlignment)
+        self.assertRaises(ValueError, next, results)
+
+    def test_trim_many_lazy(self):
+        ali = Alignment([b"seq1", b"seq2"], ["MKK-Y", "MKKAY"])
+        trimmer = AutomaticTrimmer(method="strict", backend=self.backend)
+        consumed = []
+        def alignments():
+            while True:
+                consumed.append(ali)
+                yield ali
+        results = trimmer.trim_many(alignments(), threads=2)
+        for _ in range(10):
+            self.assertTrimmedAlignmentEqual(next(results), trimmer.trim(ali))
+        # the input is only read ahead by a window of alignments per thread
+        self.assertLessEqual(len(consumed), 10 + 4 * 2)
+        results.close()
+
+    def test_trim_many_invalid_threads(self):
+        trimmer = AutomaticTrimmer(method="strict", backend=self.backend)
+        self.assertRaises(ValueError, list, trimmer.trim_many([], threads=-1))
+
     @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
     @unittest.skipUnless(files, "importlib.resources.files not available")
     def test_automatic1_method(self):
@@ -97,6 +249,14 @@ class TestAutomaticTrimmerGeneric(TestAutomaticTrimmer):
     backend = "generic"
 
 
+class TestAutomaticTrimmerBitsliced(TestAutomaticTrimmer):
+    backend = "bitsliced"
+
+
+class TestAutomaticTrimmerAuto(TestAutomaticTrimmer):
+    backend = "auto"
+
+
 @unittest.skipUnless(_trimal._MMX_RUNTIME_SUPPORT, "MMX not available")
 class TestAutomaticTrimmerMMX(TestAutomaticTrimmer):
     backend = "mmx"
@@ -112,6 +272,11 @@ class TestAutomaticTrimmerAVX(TestAutomaticTrimmer):
     backend = "avx"
 
 
+@unittest.skipUnless(_trimal._AVX512_RUNTIME_SUPPORT, "AVX-512 not available")
+class TestAutomaticTrimmerAVX512(TestAutomaticTrimmer):
+    backend = "avx512"
+
+
 @unittest.skipUnless(_trimal._NEON_RUNTIME_SUPPORT, "NEON not available")
 class TestAutomaticTrimmerNEON(TestAutomaticTrimmer):
     backend = "neon"
\ No newline at end of file
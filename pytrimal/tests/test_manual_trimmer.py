@@ -34,6 +34,19 @@ class TestManualTrimmer(TrimmerTestCase, unittest.TestCase):
         self._test_parameters(gt=0.9, cons=60)
         self._test_parameters(gt=0.4, cons=40)
 
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_parameter_sweep(self):
+        # trimming the same alignment again reuses the statistics computed
+        # by the previous trimmers, which must not change the results
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        for gt, cons in [(0.9, 60), (0.4, 40), (0.9, 60)]:
+            filename = "ENOG411BWBU.cons{:02}.gt{:02}.fasta".format(cons, int(gt * 100))
+            expected = self._load_alignment(filename)
+            trimmer = ManualTrimmer(gap_threshold=gt, conservation_percentage=cons, backend=self.backend)
+            trimmed = trimmer.trim(ali)
+            self.assertTrimmedAlignmentEqual(trimmed, expected)
+
     @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
     @unittest.skipUnless(files, "importlib.resources.files not available")
     def test_window(self):
@@ -47,6 +60,46 @@ class TestManualTrimmer(TrimmerTestCase, unittest.TestCase):
         for seq1, seq2 in zip(trimmed.sequences, expected.sequences):
             self.assertEqual(seq1, seq2)
 
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_window_sweep(self):
+        # applying another window reuses the gaps and similarity of the
+        # columns, which must not change the windowed results
+        ali = self._load_alignment("example.001.AA.clw", "clustal")
+        expected = self._load_alignment("example.001.gt90.w3.clw", "clustal")
+        for window in (3, 1, 2, 3):
+            trimmer = ManualTrimmer(gap_threshold=0.9, window=window, backend=self.backend)
+            trimmed = trimmer.trim(ali)
+            reference = ManualTrimmer(gap_threshold=0.9, window=window, backend=None)
+            self.assertTrimmedAlignmentEqual(trimmed, reference.trim(ali))
+        self.assertEqual(trimmed.names, expected.names)
+        for seq1, seq2 in zip(trimmed.sequences, expected.sequences):
+            self.assertEqual(seq1, seq2)
+
+    def test_gap_window_rounding(self):
+        # the windowed gaps are rounded to the nearest integer, e.g. the
+        # window of column 17 averages (2 + 0 + 3) / 3 = 1.67 gaps into 2,
+        # and the conservation baseline is computed from the windowed gaps
+        ali = Alignment(
+            names=[b"seq1", b"seq2", b"seq3", b"seq4"],
+            sequences=[
+                "M--KV-LLAG--KVMLL-AGKV-LMLAG",
+                "M--KV-LLAGY-KVM-LLAGKV-LM-AG",
+                "MYKK--LLAGYRKV--L-AGK--LMLAG",
+                "MYKKV-LLAGYRKVMLL-AGKVMLMLAG",
+            ],
+        )
+        for window in (1, 2, 3):
+            for kwargs in (
+                dict(gap_threshold=0.6, gap_window=window),
+                dict(gap_absolute_threshold=1, gap_window=window),
+                dict(gap_threshold=0.6, gap_window=window, conservation_percentage=60),
+                dict(gap_threshold=0.6, window=window, conservation_percentage=80),
+            ):
+                trimmer = ManualTrimmer(backend=self.backend, **kwargs)
+                reference = ManualTrimmer(backend=None, **kwargs)
+                self.assertTrimmedAlignmentEqual(trimmer.trim(ali), reference.trim(ali))
+
     def test_large_window(self):
         ali = Alignment([b"seq1", b"seq2"], ["M-KKV", "MY-KV"])
         trimmer = ManualTrimmer(gap_threshold=0.9, window=100, backend=self.backend)
@@ -76,6 +129,51 @@ class TestManualTrimmer(TrimmerTestCase, unittest.TestCase):
             "ManualTrimmer(gap_absolute_threshold=10, similarity_threshold=0.5, conservation_percentage=50.0, gap_window=5, similarity_window=5, backend=None)",
         )
 
+    def test_nucleotides(self):
+        # nucleotide alignments use the kernels specialized for their
+        # alphabet, which must give the same results as trimAl
+        ali = Alignment(
+            names=[b"seq1", b"seq2", b"seq3", b"seq4", b"seq5"],
+            sequences=[
+                "ATGC-GTANNACGT--ACGTTGCA-ATG",
+                "ATGCAGTA-TACGTA-ACGATGCAAATG",
+                "ATCCAG-ANTACCTACACG-TGCA--TG",
+                "AAGCAGTAGT-CGTACACGTTNCAAATG",
+                "ATGC-GTNGTACGTA-ACGTTGCAA-TG",
+            ],
+        )
+        trimmer = ManualTrimmer(gap_threshold=0.8, similarity_threshold=0.5, backend=self.backend)
+        expected = ManualTrimmer(gap_threshold=0.8, similarity_threshold=0.5, backend=None).trim(ali)
+        self.assertTrimmedAlignmentEqual(trimmer.trim(ali), expected)
+
+    def test_profile(self):
+        ali = Alignment(
+            names=[b"Sp8", b"Sp17", b"Sp10", b"Sp26"],
+            sequences=[
+                "LG-----------TKSD---NNNNNNNNNNNNNNNNWV----------",
+                "APDLLL-IGFLLKTV-ATFG-----------------DTWFQLWQGLD",
+                "DPAVL--FVIMLGTI-TKFS-----------------SEWFFAWLGLE",
+                "AAALLTYLGLFLGTDYENFA-----------------AAAANAWLGLE",
+            ],
+        )
+        trimmer = ManualTrimmer(gap_threshold=0.4, similarity_threshold=0.5, backend=self.backend)
+        with trimmer.profile() as profile:
+            trimmed = trimmer.trim(ali)
+            self.assertRaises(RuntimeError, trimmer.profile().__enter__)
+        self.assertTrimmedAlignmentEqual(trimmed, trimmer.trim(ali))
+        stages = profile.stages
+        self.assertEqual(list(stages), list(profile.STAGES))
+        self.assertEqual(stages["setup"].calls, 1)
+        self.assertEqual(stages["cleaning"].calls, 1)
+        self.assertEqual(stages["copy"].calls, 0)
+        self.assertAlmostEqual(profile.time, sum(s.time for s in stages.values()))
+        if self.backend is not None:
+            self.assertGreater(stages["gaps"].calls, 0)
+            self.assertEqual(stages["gaps"].bytes, stages["gaps"].calls * 4 * 48)
+            self.assertGreater(stages["similarity"].calls, 0)
+        # trimming outside of the context is not recorded
+        self.assertEqual(profile.stages["setup"].calls, 1)
+
     def test_pickle(self):
         trimmer = ManualTrimmer(gap_threshold=0.4, window=5, backend=self.backend)
         pickled = pickle.loads(pickle.dumps(trimmer))
@@ -97,6 +195,14 @@ class TestManualTrimmerGeneric(TestManualTrimmer):
     backend = "generic"
 
 
+class TestManualTrimmerBitsliced(TestManualTrimmer):
+    backend = "bitsliced"
+
+
+class TestManualTrimmerAuto(TestManualTrimmer):
+    backend = "auto"
+
+
 @unittest.skipUnless(_trimal._MMX_RUNTIME_SUPPORT, "MMX not available")
 class TestManualTrimmerMMX(TestManualTrimmer):
     backend = "mmx"
@@ -112,6 +218,11 @@ class TestManualTrimmerAVX(TestManualTrimmer):
     backend = "avx"
 
 
+@unittest.skipUnless(_trimal._AVX512_RUNTIME_SUPPORT, "AVX-512 not available")
+class TestManualTrimmerAVX512(TestManualTrimmer):
+    backend = "avx512"
+
+
 @unittest.skipUnless(_trimal._NEON_RUNTIME_SUPPORT, "NEON not available")
 class TestManualTrimmerNEON(TestManualTrimmer):
     backend = "neon"
\ No newline at end of file
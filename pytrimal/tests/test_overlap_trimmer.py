@@ -10,12 +10,12 @@ from ._base import TrimmerTestCase, files
 
 class TestOverlapTrimmer(TrimmerTestCase, unittest.TestCase):
 
-    def _test_overlap(self, seq, res):
+    def _test_overlap(self, seq, res, threads=1):
         ali = self._load_alignment("ENOG411BWBU.fasta")
         expected = self._load_alignment(
             "ENOG411BWBU.seq{}.res{}.fasta".format(seq, res)
         )
-        trimmer = OverlapTrimmer(sequence_overlap=seq, residue_overlap=res / 100, backend=self.backend)
+        trimmer = OverlapTrimmer(sequence_overlap=seq, residue_overlap=res / 100, backend=self.backend, threads=threads)
         trimmed = trimmer.trim(ali)
         self.assertTrimmedAlignmentEqual(trimmed, expected)
 
@@ -29,6 +29,26 @@ class TestOverlapTrimmer(TrimmerTestCase, unittest.TestCase):
     def test_seqoverlap40_resoverlap60(self):
         self._test_overlap(40, 60)
 
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(files, "importlib.resources.files not available")
+    def test_seqoverlap80_resoverlap80_threads(self):
+        self._test_overlap(80, 80, threads=4)
+
+    def test_many_sequences(self):
+        # the overlap is counted for more than `UCHAR_MAX` sequences, with
+        # gaps and indeterminations, and must match the original code
+        import random
+        rng = random.Random(42)
+        names = [f"seq{i}".encode() for i in range(300)]
+        sequences = [
+            "".join(rng.choice("ACDEFGHIK--X") for _ in range(100))
+            for _ in names
+        ]
+        ali = Alignment(names, sequences)
+        trimmer = OverlapTrimmer(50, 0.4, backend=self.backend, threads=2)
+        expected = OverlapTrimmer(50, 0.4, backend=None).trim(ali)
+        self.assertTrimmedAlignmentEqual(trimmer.trim(ali), expected)
+
     def test_repr(self):
         trimmer = OverlapTrimmer(80, 0.5)
         self.assertEqual(repr(trimmer), "OverlapTrimmer(80.0, 0.5)")
@@ -58,6 +78,14 @@ class TestOverlapTrimmerGeneric(TestOverlapTrimmer):
     backend = "generic"
 
 
+class TestOverlapTrimmerBitsliced(TestOverlapTrimmer):
+    backend = "bitsliced"
+
+
+class TestOverlapTrimmerAuto(TestOverlapTrimmer):
+    backend = "auto"
+
+
 @unittest.skipUnless(_trimal._MMX_RUNTIME_SUPPORT, "MMX not available")
 class TestOverlapTrimmerMMX(TestOverlapTrimmer):
     backend = "mmx"
@@ -73,6 +101,11 @@ class TestOverlapTrimmerAVX(TestOverlapTrimmer):
     backend = "avx"
 
 
+@unittest.skipUnless(_trimal._AVX512_RUNTIME_SUPPORT, "AVX-512 not available")
+class TestOverlapTrimmerAVX512(TestOverlapTrimmer):
+    backend = "avx512"
+
+
 @unittest.skipUnless(_trimal._NEON_RUNTIME_SUPPORT, "NEON not available")
 class TestOverlapTrimmerNEON(TestOverlapTrimmer):
     backend = "neon"
\ No newline at end of file
@@ -30,7 +30,7 @@ class TestRepresentativeTrimmer(unittest.TestCase):
         with importlib_resources.path("pytrimal.tests.data", name) as path:
             return Alignment.load(path)
 
-    def _test_representative(self, clusters=None, identity_threshold=None):
+    def _test_representative(self, clusters=None, identity_threshold=None, threads=1, clustering="exact"):
         ali = self._load_alignment("ENOG411BWBU.fasta")
 
         if clusters is not None:
@@ -43,7 +43,11 @@ class TestRepresentativeTrimmer(unittest.TestCase):
             )
 
         trimmer = RepresentativeTrimmer(
-            clusters=clusters, identity_threshold=identity_threshold, backend=self.backend
+            clusters=clusters,
+            identity_threshold=identity_threshold,
+            backend=self.backend,
+            threads=threads,
+            clustering=clustering,
         )
         trimmed = trimmer.trim(ali)
 
@@ -66,6 +70,49 @@ class TestRepresentativeTrimmer(unittest.TestCase):
     def test_identity75(self):
         self._test_representative(identity_threshold=0.75)
 
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(importlib_resources, "importlib.resources not available")
+    def test_clusters10_threads(self):
+        self._test_representative(clusters=10, threads=4)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(importlib_resources, "importlib.resources not available")
+    def test_identity75_greedy(self):
+        self._test_representative(identity_threshold=0.75, clustering="greedy")
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(importlib_resources, "importlib.resources not available")
+    def test_identity75_greedy_threads(self):
+        self._test_representative(identity_threshold=0.75, clustering="greedy", threads=4)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(importlib_resources, "importlib.resources not available")
+    def test_clusters10_greedy(self):
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        trimmer = RepresentativeTrimmer(
+            clusters=10, backend=self.backend, clustering="greedy"
+        )
+        trimmed = trimmer.trim(ali)
+        self.assertLessEqual(len(trimmed.sequences), 10)
+        self.assertGreater(len(trimmed.sequences), 0)
+
+    @unittest.skipIf(sys.version_info < (3, 6), "No pathlib support in Python 3.5")
+    @unittest.skipUnless(importlib_resources, "importlib.resources not available")
+    def test_clusters_sweep(self):
+        # the second trimming reads the identities kept with the alignment,
+        # and the last one recomputes them after the cache was cleared
+        ali = self._load_alignment("ENOG411BWBU.fasta")
+        for clusters in (5, 10, 5):
+            expected = self._load_alignment("ENOG411BWBU.clusters{}.fasta".format(clusters))
+            trimmer = RepresentativeTrimmer(clusters=clusters, backend=self.backend)
+            self.assertTrimmedAlignmentEqual(trimmer.trim(ali), expected)
+            if clusters == 10:
+                ali.clear_cache()
+
+    def test_invalid_clustering(self):
+        self.assertRaises(ValueError, RepresentativeTrimmer, clusters=2, clustering="fast")
+        self.assertRaises(TypeError, RepresentativeTrimmer, clusters=2, clustering=1)
+
     def test_repr(self):
         trimmer = RepresentativeTrimmer(identity_threshold=0.25)
         self.assertEqual(
@@ -77,6 +124,10 @@ class TestRepresentativeTrimmer(unittest.TestCase):
         self.assertEqual(
             repr(trimmer), "RepresentativeTrimmer(clusters=3, backend=None)"
         )
+        trimmer = RepresentativeTrimmer(clusters=3, clustering="greedy")
+        self.assertEqual(
+            repr(trimmer), "RepresentativeTrimmer(clusters=3, clustering='greedy')"
+        )
 
     def test_pickle(self):
         trimmer = RepresentativeTrimmer(clusters=3, backend=self.backend)
@@ -94,11 +145,29 @@ class TestRepresentativeTrimmer(unittest.TestCase):
         t2 = pickled.trim(ali)
         self.assertTrimmedAlignmentEqual(t2, t1)
 
+    def test_pickle_threads(self):
+        trimmer = RepresentativeTrimmer(clusters=3, backend=self.backend, threads=2)
+        pickled = pickle.loads(pickle.dumps(trimmer))
+        self.assertEqual(pickled.threads, 2)
+
+    def test_pickle_clustering(self):
+        trimmer = RepresentativeTrimmer(clusters=3, backend=self.backend, clustering="greedy")
+        pickled = pickle.loads(pickle.dumps(trimmer))
+        self.assertEqual(pickled.clustering, "greedy")
+
 
 class TestRepresentativeTrimmerGeneric(TestRepresentativeTrimmer):
     backend = "generic"
 
 
+class TestRepresentativeTrimmerBitsliced(TestRepresentativeTrimmer):
+    backend = "bitsliced"
+
+
+class TestRepresentativeTrimmerAuto(TestRepresentativeTrimmer):
+    backend = "auto"
+
+
 @unittest.skipUnless(_trimal._MMX_RUNTIME_SUPPORT, "MMX not available")
 class TestRepresentativeTrimmerMMX(TestRepresentativeTrimmer):
     backend = "mmx"
@@ -114,6 +183,11 @@ class TestRepresentativeTrimmerAVX(TestRepresentativeTrimmer):
     backend = "avx"
 
 
+@unittest.skipUnless(_trimal._AVX512_RUNTIME_SUPPORT, "AVX-512 not available")
+class TestRepresentativeTrimmerAVX512(TestRepresentativeTrimmer):
+    backend = "avx512"
+
+
 @unittest.skipUnless(_trimal._NEON_RUNTIME_SUPPORT, "NEON not available")
 class TestRepresentativeTrimmerNEON(TestRepresentativeTrimmer):
     backend = "neon"
\ No newline at end of file
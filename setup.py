@@ -12,7 +12,7 @@ import setuptools.extension
 import subprocess
 import sys
 from distutils.command.clean import clean as _clean
-from distutils.errors import CompileError
+from distutils.errors import CompileError, LinkError
 from setuptools.command.build_clib import build_clib as _build_clib
 from setuptools.command.build_ext import build_ext as _build_ext
 from setuptools.command.sdist import sdist as _sdist
@@ -82,6 +82,29 @@ def _patch_osx_compiler(compiler):
             flags.pop(i - 1)
 
 
+def _locate_hunk(s, p, i, l, sl, sign):
+    # find the lines replaced by the hunk starting at `p[i]`, at the line
+    # given in the hunk header or at the nearest offset like `patch` does,
+    # so that hunks still apply when the vendored sources move
+    old = []
+    while i < len(p) and p[i][0] != "@":
+        if p[i][0] in (" ", "-", "+") and p[i][0] != sign:
+            old.append(p[i][1:].strip())
+        i += 1
+    def matches(start):
+        lines = s[start:start + len(old)]
+        return len(lines) == len(old) and all(
+            x.strip() == y for x, y in zip(lines, old)
+        )
+    if not old or matches(l):
+        return l
+    for offset in range(1, len(s)):
+        for start in (l - offset, l + offset):
+            if start >= sl and matches(start):
+                return start
+    raise ValueError("Hunk at line {} does not apply".format(l + 1))
+
+
 def _apply_patch(s, patch, revert=False):
     # see https://stackoverflow.com/a/40967337
     s = s.splitlines(keepends=True)
@@ -99,6 +122,7 @@ def _apply_patch(s, patch, revert=False):
             raise ValueError("Invalid line in patch: {!r}".format(p[i]))
         i += 1
         l = int(match.group(midx)) - 1 + (match.group(midx + 1) == "0")
+        l = _locate_hunk(s, p, i, l, sl, sign)
         t.extend(s[sl:l])
         sl = l
         while i < len(p) and p[i][0] != "@":
@@ -151,6 +175,11 @@ class build_ext(_build_ext):
     # --- Compatibility with `setuptools.Command`
 
     user_options = _build_ext.user_options + [
+        (
+            "disable-avx512",
+            None,
+            "Force compiling the extension without AVX-512 instructions",
+        ),
         (
             "disable-avx2",
             None,
@@ -171,27 +200,44 @@ class build_ext(_build_ext):
             None,
             "Force compiling the extension without NEON instructions",
         ),
+        (
+            "disable-zlib",
+            None,
+            "Force compiling the extension without gzip compression support",
+        ),
+        (
+            "disable-zstd",
+            None,
+            "Force compiling the extension without Zstandard compression support",
+        ),
     ]
 
     def initialize_options(self):
         _build_ext.initialize_options(self)
+        self.disable_avx512 = False
         self.disable_avx2 = False
         self.disable_mmx  = False
         self.disable_sse2 = False
         self.disable_neon = False
+        self.disable_zlib = False
+        self.disable_zstd = False
 
     def finalize_options(self):
         _build_ext.finalize_options(self)
         # record SIMD-specific options
-        self._simd_supported = dict(AVX2=False, SSE2=False, NEON=False, MMX=False)
-        self._simd_defines = dict(AVX2=[], SSE2=[], NEON=[], MMX=[])
-        self._simd_flags = dict(AVX2=[], SSE2=[], NEON=[], MMX=[])
+        self._simd_supported = dict(AVX512=False, AVX2=False, SSE2=False, NEON=False, MMX=False)
+        self._simd_defines = dict(AVX512=[], AVX2=[], SSE2=[], NEON=[], MMX=[])
+        self._simd_flags = dict(AVX512=[], AVX2=[], SSE2=[], NEON=[], MMX=[])
         self._simd_disabled = {
+            "AVX512": self.disable_avx512,
             "AVX2": self.disable_avx2,
             "SSE2": self.disable_sse2,
             "NEON": self.disable_neon,
             "MMX": self.disable_mmx
         }
+        # record compression libraries found on the system
+        self._compression_defines = []
+        self._compression_libraries = []
         # transfer arguments to the build_clib method
         self._clib_cmd = self.get_finalized_command("build_clib")
         self._clib_cmd.debug = self.debug
@@ -240,10 +286,31 @@ class build_ext(_build_ext):
             if os.path.isfile(binfile):
                 os.remove(binfile)
 
+    def _avx512_flags(self):
+        if self.compiler.compiler_type == "msvc":
+            return ["/arch:AVX512"]
+        # AVX-512 implies FMA, which must not be used to contract the
+        # similarity products, or the results would differ from trimAl
+        return ["-mavx512f", "-mavx512bw", "-mpopcnt", "-ffp-contract=off"]
+
+    def _check_avx512(self):
+        return self._check_simd_generic(
+            "AVX512",
+            self._avx512_flags(),
+            program="""
+                #include <immintrin.h>
+                int main() {{
+                    __m512i   a = _mm512_set1_epi8(-1);
+                    __mmask64 m = _mm512_cmpeq_epi8_mask(a, _mm512_abs_epi8(a));
+                    return (m == 0) ? 0 : 1;
+                }}
+            """,
+        )
+
     def _avx2_flags(self):
         if self.compiler.compiler_type == "msvc":
             return ["/arch:AVX2"]
-        return ["-mavx", "-mavx2"]
+        return ["-mavx", "-mavx2", "-mpopcnt"]
 
     def _check_avx2(self):
         return self._check_simd_generic(
@@ -354,35 +421,144 @@ class build_ext(_build_ext):
             for obj in filter(os.path.isfile, objects):
                 os.remove(obj)
 
+    def _check_library(self, name, library, program):
+        _eprint("checking whether", name, "library is available", end="... ")
+
+        base = "have_{}".format(library)
+        testfile = os.path.join(self.build_temp, "{}.c".format(base))
+        binfile = self.compiler.executable_filename(base, output_dir=self.build_temp)
+        objects = []
+
+        self.mkpath(self.build_temp)
+        with open(testfile, "w") as f:
+            f.write(program)
+
+        try:
+            objects = self.compiler.compile([testfile])
+            self.compiler.link_executable(
+                objects, base, libraries=[library], output_dir=self.build_temp
+            )
+        except (CompileError, LinkError):
+            _eprint("no")
+            return False
+        else:
+            _eprint("yes")
+            return True
+        finally:
+            os.remove(testfile)
+            for obj in filter(os.path.isfile, objects):
+                os.remove(obj)
+            if os.path.isfile(binfile):
+                os.remove(binfile)
+
+    def _check_zlib(self):
+        return self._check_library(
+            "zlib",
+            "z",
+            """
+            #include <string.h>
+            #include <zlib.h>
+
+            int main(int argc, char *argv[]) {
+                z_stream stream;
+                memset(&stream, 0, sizeof(stream));
+                return inflateInit2(&stream, 16 + MAX_WBITS) == Z_OK ? 0 : 1;
+            }
+            """,
+        )
+
+    def _check_zstd(self):
+        return self._check_library(
+            "zstd",
+            "zstd",
+            """
+            #include <zstd.h>
+
+            int main(int argc, char *argv[]) {
+                ZSTD_CCtx* context = ZSTD_createCCtx();
+                ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, 3);
+                ZSTD_freeCCtx(context);
+                return 0;
+            }
+            """,
+        )
+
+    # --- Build configuration ---
+
+    def _configure_platform(self, compile_time_env):
+        # check if we can build platform-specific code
+        if TARGET_CPU == "x86":
+            if not self._simd_disabled["MMX"] and self._check_mmx():
+                compile_time_env["MMX_BUILD_SUPPORT"] = True
+                self._simd_supported["MMX"] = True
+                self._simd_flags["MMX"].extend(self._mmx_flags())
+                self._simd_defines["MMX"].append(("__MMX__", 1))
+            if not self._simd_disabled["AVX512"] and self._check_avx512():
+                compile_time_env["AVX512_BUILD_SUPPORT"] = True
+                self._simd_supported["AVX512"] = True
+                self._simd_flags["AVX512"].extend(self._avx512_flags())
+                self._simd_defines["AVX512"].append(("__AVX512BW__", 1))
+            if not self._simd_disabled["AVX2"] and self._check_avx2():
+                compile_time_env["AVX2_BUILD_SUPPORT"] = True
+                self._simd_supported["AVX2"] = True
+                self._simd_flags["AVX2"].extend(self._avx2_flags())
+                self._simd_defines["AVX2"].append(("__AVX2__", 1))
+            if not self._simd_disabled["SSE2"] and self._check_sse2():
+                compile_time_env["SSE2_BUILD_SUPPORT"] = True
+                self._simd_supported["SSE2"] = True
+                self._simd_flags["SSE2"].extend(self._sse2_flags())
+                self._simd_defines["SSE2"].append(("__SSE2__", 1))
+        elif TARGET_CPU == "arm" or TARGET_CPU == "aarch64":
+            if not self._simd_disabled["NEON"] and self._check_neon():
+                compile_time_env["NEON_BUILD_SUPPORT"] = True
+                self._simd_supported["NEON"] = True
+                self._simd_flags["NEON"].extend(self._neon_flags())
+                self._simd_defines["NEON"].append(("__ARM_NEON__", 1))
+
+        # check which compression libraries are available
+        if not self.disable_zlib and self._check_zlib():
+            self._compression_defines.append(("HAS_ZLIB", 1))
+            self._compression_libraries.append("z")
+        if not self.disable_zstd and self._check_zstd():
+            self._compression_defines.append(("HAS_ZSTD", 1))
+            self._compression_libraries.append("zstd")
+
     # --- Build code ---
 
     def build_simd_code(self, ext):
-        # build platform-specific code
-        for simd, sources in ext.platform_sources.items():
-            if self._simd_supported[simd] and not self._simd_disabled[simd]:
-                objects = [
-                    os.path.join(
-                        self.build_temp, s.replace(".cpp", self.compiler.obj_extension)
-                    )
-                    for s in sources
-                ]
-                for source, object in zip(sources, objects):
-                    self.make_file(
+        # build platform-specific code, from the least to the most demanding
+        # instruction set: the objects are linked after the portable ones in
+        # that order, so that the linker keeps the portable (or least
+        # demanding) copy of the inline library code they share
+        for simd in ("MMX", "SSE2", "NEON", "AVX2", "AVX512"):
+            sources = ext.platform_sources.get(simd)
+            if not sources or not self._simd_supported[simd]:
+                continue
+            if self._simd_disabled[simd]:
+                continue
+            objects = [
+                os.path.join(
+                    self.build_temp, s.replace(".cpp", self.compiler.obj_extension)
+                )
+                for s in sources
+            ]
+            for source, object in zip(sources, objects):
+                self.make_file(
+                    [source],
+                    object,
+                    self.compiler.compile,
+                    (
                         [source],
-                        object,
-                        self.compiler.compile,
-                        (
-                            [source],
-                            self.build_temp,
-                            ext.define_macros + self._simd_defines[simd],
-                            ext.include_dirs,
-                            self.debug,
-                            ext.extra_compile_args + self._simd_flags[simd],
-                            None,
-                            ext.depends,
-                        ),
-                    )
-                ext.extra_objects.extend(objects)
+                        self.build_temp,
+                        ext.define_macros + self._simd_defines[simd],
+                        ext.include_dirs,
+                        self.debug,
+                        ext.extra_compile_args + self._simd_flags[simd],
+                        None,
+                        ext.depends,
+                    ),
+                )
+            ext.extra_objects.extend(objects)
 
     def build_extension(self, ext):
         # show the compiler being used
@@ -403,7 +579,9 @@ class build_ext(_build_ext):
         if self.compiler.compiler_type in {"unix", "cygwin", "mingw32"}:
             ext.extra_compile_args.append("-std=c++11")
             ext.extra_compile_args.append("-funroll-loops")
+            ext.extra_compile_args.append("-pthread")
             ext.extra_link_args.append("-Wno-alloc-size-larger-than")
+            ext.extra_link_args.append("-pthread")
         elif self.compiler.compiler_type == "msvc":
             ext.extra_compile_args.append("/std:c11")
 
@@ -424,6 +602,10 @@ class build_ext(_build_ext):
             ext.depends.append(libfile)
             ext.extra_objects.append(libfile)
 
+        # link to the compression libraries found on the system
+        ext.define_macros.extend(self._compression_defines)
+        ext.libraries.extend(self._compression_libraries)
+
         # build platform-specific code
         self.build_simd_code(ext)
 
@@ -457,6 +639,7 @@ class build_ext(_build_ext):
                 "DEFAULT_BUFFER_SIZE": io.DEFAULT_BUFFER_SIZE,
                 "TARGET_CPU": TARGET_CPU,
                 "TARGET_SYSTEM": TARGET_SYSTEM,
+                "AVX512_BUILD_SUPPORT": False,
                 "AVX2_BUILD_SUPPORT": False,
                 "MMX_BUILD_SUPPORT":  False,
                 "NEON_BUILD_SUPPORT": False,
@@ -487,29 +670,8 @@ class build_ext(_build_ext):
         for ext in self.extensions:
             ext.include_dirs.append(self._clib_cmd.build_clib)
 
-        # check if we can build platform-specific code
-        if TARGET_CPU == "x86":
-            if not self._simd_disabled["MMX"] and self._check_mmx():
-                cython_args["compile_time_env"]["MMX_BUILD_SUPPORT"] = True
-                self._simd_supported["MMX"] = True
-                self._simd_flags["MMX"].extend(self._mmx_flags())
-                self._simd_defines["MMX"].append(("__MMX__", 1))
-            if not self._simd_disabled["AVX2"] and self._check_avx2():
-                cython_args["compile_time_env"]["AVX2_BUILD_SUPPORT"] = True
-                self._simd_supported["AVX2"] = True
-                self._simd_flags["AVX2"].extend(self._avx2_flags())
-                self._simd_defines["AVX2"].append(("__AVX2__", 1))
-            if not self._simd_disabled["SSE2"] and self._check_sse2():
-                cython_args["compile_time_env"]["SSE2_BUILD_SUPPORT"] = True
-                self._simd_supported["SSE2"] = True
-                self._simd_flags["SSE2"].extend(self._sse2_flags())
-                self._simd_defines["SSE2"].append(("__SSE2__", 1))
-        elif TARGET_CPU == "arm" or TARGET_CPU == "aarch64":
-            if not self._simd_disabled["NEON"] and self._check_neon():
-                cython_args["compile_time_env"]["NEON_BUILD_SUPPORT"] = True
-                self._simd_supported["NEON"] = True
-                self._simd_flags["NEON"].extend(self._neon_flags())
-                self._simd_defines["NEON"].append(("__ARM_NEON__", 1))
+        # check the platform-specific code and libraries we can build
+        self._configure_platform(cython_args["compile_time_env"])
 
         # add the platform sources as dependencies
         for ext in self.extensions:
@@ -713,6 +875,104 @@ class build_clib(_build_clib):
         )
 
 
+class build_bench(build_ext):
+    """A `build_ext` that builds the native benchmark of the SIMD kernels."""
+
+    description = "build the native benchmark of the statistics kernels"
+
+    def build_extensions(self):
+        # remove universal compilation flags for OSX
+        if platform.system() == "Darwin":
+            _patch_osx_compiler(self.compiler)
+
+        # compile the C library
+        if not self.distribution.have_run.get("build_clib", False):
+            self._clib_cmd.run()
+        libfile = self.compiler.library_filename(
+            "trimal", output_dir=self._clib_cmd.build_clib
+        )
+
+        # check which backends can be built, and define the same macros
+        # as the Cython compile-time environment to select them
+        compile_time_env = {}
+        self._configure_platform(compile_time_env)
+        bench = Extension(
+            "kernels",
+            language="c++",
+            sources=[
+                os.path.join("bench", "kernels.cpp"),
+                os.path.join("vendor", "trimal", "source", "reportsystem.cpp"),
+                os.path.join("pytrimal", "impl", "bitsliced.cpp"),
+                os.path.join("pytrimal", "impl", "context.cpp"),
+                os.path.join("pytrimal", "impl", "generic.cpp"),
+                os.path.join("pytrimal", "impl", "profile.cpp"),
+            ],
+            platform_sources=self.extensions[0].platform_sources,
+            define_macros=[
+                (name, 1) for name, enabled in compile_time_env.items() if enabled
+            ],
+            include_dirs=[
+                os.path.join("pytrimal", "impl"),
+                "pytrimal",
+                self._clib_cmd.build_clib,
+            ],
+            depends=self.extensions[0].depends,
+        )
+
+        # add debug and C++11 flags
+        if self.compiler.compiler_type in {"unix", "cygwin", "mingw32"}:
+            if self.debug:
+                bench.extra_compile_args.append("-g")
+            bench.extra_compile_args.append("-std=c++11")
+            bench.extra_compile_args.append("-funroll-loops")
+            bench.extra_compile_args.append("-pthread")
+            bench.extra_link_args.append("-pthread")
+        elif self.compiler.compiler_type == "msvc":
+            if self.debug:
+                bench.extra_compile_args.append("/Z7")
+            bench.extra_compile_args.append("/std:c11")
+            bench.define_macros.append(("WIN32", 1))
+
+        # compile the benchmark and the backends
+        objects = []
+        for source in bench.sources:
+            object = os.path.join(
+                self.build_temp,
+                source.replace(".cpp", self.compiler.obj_extension),
+            )
+            self.make_file(
+                [source, *bench.depends],
+                object,
+                self.compiler.compile,
+                (
+                    [source],
+                    self.build_temp,
+                    bench.define_macros,
+                    bench.include_dirs,
+                    self.debug,
+                    bench.extra_compile_args,
+                    None,
+                    bench.depends,
+                ),
+            )
+            objects.append(object)
+        self.build_simd_code(bench)
+
+        # link the benchmark to the trimAl library
+        self.compiler.link_executable(
+            objects + bench.extra_objects + [libfile],
+            bench.name,
+            output_dir=self.build_temp,
+            debug=self.debug,
+            extra_postargs=bench.extra_link_args,
+            target_lang="c++",
+        )
+        _eprint(
+            "built benchmark",
+            self.compiler.executable_filename(bench.name, output_dir=self.build_temp),
+        )
+
+
 class clean(_clean):
     """A `clean` that removes intermediate files created by Cython."""
 
@@ -821,13 +1081,23 @@ setuptools.setup(
                 os.path.join("pytrimal", "fileobj", "pyreadbuf.cpp"),
                 os.path.join("pytrimal", "fileobj", "pyreadintobuf.cpp"),
                 os.path.join("pytrimal", "patch", "reportsystem.cpp"),
+                os.path.join("pytrimal", "impl", "batch.cpp"),
+                os.path.join("pytrimal", "impl", "bitsliced.cpp"),
+                os.path.join("pytrimal", "impl", "buffer.cpp"),
+                os.path.join("pytrimal", "impl", "compression.cpp"),
+                os.path.join("pytrimal", "impl", "context.cpp"),
+                os.path.join("pytrimal", "impl", "fasta.cpp"),
                 os.path.join("pytrimal", "impl", "generic.cpp"),
+                os.path.join("pytrimal", "impl", "lease.cpp"),
+                os.path.join("pytrimal", "impl", "profile.cpp"),
+                os.path.join("pytrimal", "impl", "records.cpp"),
                 os.path.join("pytrimal", "_trimal.pyx"),
             ],
             platform_sources={
                 "SSE2": [os.path.join("pytrimal", "impl", "sse.cpp")],
                 "NEON": [os.path.join("pytrimal", "impl", "neon.cpp")],
                 "AVX2": [os.path.join("pytrimal", "impl", "avx.cpp")],
+                "AVX512": [os.path.join("pytrimal", "impl", "avx512.cpp")],
                 "MMX": [os.path.join("pytrimal", "impl", "mmx.cpp")],
             },
             include_dirs=[
@@ -841,7 +1111,25 @@ setuptools.setup(
                 "trimal",
             ],
             depends=[
+                os.path.join("pytrimal", "impl", "alphabet.h"),
+                os.path.join("pytrimal", "impl", "arena.h"),
+                os.path.join("pytrimal", "impl", "batch.h"),
+                os.path.join("pytrimal", "impl", "bits.h"),
+                os.path.join("pytrimal", "impl", "bitsliced.h"),
+                os.path.join("pytrimal", "impl", "buffer.h"),
+                os.path.join("pytrimal", "impl", "clustering.h"),
+                os.path.join("pytrimal", "impl", "compression.h"),
+                os.path.join("pytrimal", "impl", "context.h"),
+                os.path.join("pytrimal", "impl", "fasta.h"),
+                os.path.join("pytrimal", "impl", "identity.h"),
+                os.path.join("pytrimal", "impl", "lease.h"),
+                os.path.join("pytrimal", "impl", "parallel.h"),
+                os.path.join("pytrimal", "impl", "pool.h"),
+                os.path.join("pytrimal", "impl", "profile.h"),
+                os.path.join("pytrimal", "impl", "records.h"),
+                os.path.join("pytrimal", "impl", "reports.h"),
                 os.path.join("pytrimal", "impl", "template.h"),
+                os.path.join("pytrimal", "impl", "tiling.h"),
             ]
         ),
     ],
@@ -849,6 +1137,7 @@ setuptools.setup(
         "sdist": sdist,
         "build_ext": build_ext,
         "build_clib": build_clib,
+        "build_bench": build_bench,
         "clean": clean,
     },
 )